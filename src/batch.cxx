@@ -0,0 +1,251 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <yaal/hcore/hcore.hxx>
+#include <yaal/hcore/algorithm.hxx>
+#include <yaal/hcore/hthread.hxx>
+#include <yaal/tools/hhuginn.hxx>
+#include <yaal/tools/hfsitem.hxx>
+#include <yaal/tools/hfuture.hxx>
+#include <yaal/tools/hstringstream.hxx>
+#include <yaal/tools/streamtools.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "batch.hxx"
+#include "huginn.hxx"
+#include "tags.hxx"
+#include "reformat.hxx"
+#include "scriptsource.hxx"
+#include "colorize.hxx"
+#include "prompt.hxx"
+#include "setup.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+typedef yaal::hcore::HArray<yaal::hcore::HString> files_t;
+
+char const SCRIPT_EXTENSION[] = ".hgn";
+
+void find_scripts( yaal::hcore::HString const& path_, files_t& files_ ) {
+	M_PROLOG
+	files_t files;
+	files_t dirs;
+	HFSItem dir( path_ );
+	for ( HFSItem const& f : dir ) {
+		HString name( f.get_name() );
+		if ( name.front() == '.' ) {
+			continue;
+		}
+		HString path( path_ );
+		path.append( "/" ).append( name );
+		if ( f.is_directory() ) {
+			dirs.push_back( path );
+		} else if ( ( name.get_length() > static_cast<int>( sizeof ( SCRIPT_EXTENSION ) - 1 ) ) && ( name.right( sizeof ( SCRIPT_EXTENSION ) - 1 ) == SCRIPT_EXTENSION ) ) {
+			files.push_back( path );
+		}
+	}
+	sort( files.begin(), files.end() );
+	sort( dirs.begin(), dirs.end() );
+	files_.insert( files_.end(), files.begin(), files.end() );
+	for ( HString const& d : dirs ) {
+		find_scripts( d, files_ );
+	}
+	return;
+	M_EPILOG
+}
+
+/*
+ * Programs given to linter, tags or reformat mode are processed by `--jobs` workers,
+ * each worker takes next unprocessed program from the list,
+ * results are collected per program and reported in order of the list
+ * once all workers finish.
+ * Reformatted program is preceded by its own header line
+ * so output for consecutive programs can be told apart.
+ */
+class HBatch {
+	struct OResult {
+		int _status;
+		hcore::HString _output;
+		hcore::HString _error;
+		tags_t _tags;
+		OResult( void )
+			: _status( 0 )
+			, _output()
+			, _error()
+			, _tags() {
+		}
+	};
+	typedef yaal::hcore::HArray<OResult> results_t;
+	typedef yaal::tools::HFuture<bool> future_t;
+	typedef yaal::hcore::HResource<future_t> promise_t;
+	typedef yaal::hcore::HArray<promise_t> promises_t;
+	files_t const& _files;
+	results_t _results;
+	int _next;
+	HMutex _mutex;
+public:
+	HBatch( files_t const& files_ )
+		: _files( files_ )
+		, _results( files_.get_size() )
+		, _next( 0 )
+		, _mutex() {
+	}
+	int run( void ) {
+		M_PROLOG
+		promises_t promises;
+		for ( int i( 0 ), jobs( min( setup._jobs, static_cast<int>( _files.get_size() ) ) ); i < jobs; ++ i ) {
+			promises.push_back( make_resource<future_t>( call( &HBatch::work, this ), HWorkFlow::SCHEDULE_POLICY::EAGER ) );
+		}
+		for ( promise_t& promise : promises ) {
+			promise->get();
+		}
+		int status( 0 );
+		tags_t allTags;
+		bool separate( false );
+		for ( int i( 0 ), count( static_cast<int>( _results.get_size() ) ); i < count; ++ i ) {
+			OResult& result( _results[i] );
+			if ( setup._reformat && ( result._status == 0 ) ) {
+				cout << ( separate ? "\n" : "" ) << "==> " << _files[i] << " <==" << endl;
+				separate = true;
+			}
+			cout << result._output;
+			if ( ! result._error.is_empty() ) {
+				cerr << result._error << endl;
+			}
+			allTags.insert( allTags.end(), result._tags.begin(), result._tags.end() );
+			status = max( status, result._status );
+		}
+		if ( setup._tags ) {
+			/* Tags file has to be sorted as a whole. */
+			sort( allTags.begin(), allTags.end() );
+			for ( yaal::hcore::HString const& tag : allTags ) {
+				cout << tag << endl;
+			}
+		}
+		cout << flush;
+		return ( status );
+		M_EPILOG
+	}
+private:
+	bool work( void ) {
+		M_PROLOG
+		HResource<HFormatter> formatter( setup._reformat ? make_resource<HFormatter>() : HResource<HFormatter>() );
+		HResource<HPrompt> prompt( setup._lint ? make_resource<HPrompt>() : HResource<HPrompt>() );
+		while ( true ) {
+			int idx( 0 );
+			/* scope for lock */ {
+				HLock l( _mutex );
+				if ( _next >= _files.get_size() ) {
+					break;
+				}
+				idx = _next;
+				++ _next;
+			}
+			OResult& result( _results[idx] );
+			HUTF8String path( _files[idx] );
+			try {
+				if ( setup._tags ) {
+					result._status = tags( path.c_str(), result._tags, result._error );
+				} else if ( setup._reformat ) {
+					result._status = reformat( *formatter, _files[idx], result );
+				} else {
+					result._status = lint( *prompt, _files[idx], result._error );
+				}
+			} catch ( HException const& e ) {
+				result._status = max( result._status, 1 );
+				result._error = e.what();
+			}
+		}
+		return ( true );
+		M_EPILOG
+	}
+	int reformat( HFormatter& formatter_, yaal::hcore::HString const& path_, OResult& result_ ) {
+		M_PROLOG
+		HScriptSource source( path_, HScriptSource::EMBEDDED::AUTO );
+		if ( ! formatter_.reformat_string( hcore::HString( source.data(), source.size() ), result_._output ) ) {
+			result_._error.assign( path_ ).append( ": " ).append( formatter_.error_message() );
+			return ( 1 );
+		}
+		return ( 0 );
+		M_EPILOG
+	}
+	int lint( HPrompt& prompt_, yaal::hcore::HString const& path_, yaal::hcore::HString& error_ ) {
+		M_PROLOG
+		HHuginn h;
+		register_builtins( h, prompt_ );
+		HScriptSource source( path_, setup._embedded ? HScriptSource::EMBEDDED::YES : HScriptSource::EMBEDDED::NO );
+		HStreamInterface* stream( &source.stream() );
+		HResource<HStringStream> stub;
+		HResource<HCat> cat;
+		if ( ! setup._assumeUsed.is_empty() ) {
+			stub = make_resource<HStringStream>( assume_used_stub() );
+			cat = make_resource<HCat>( tools::cat( stream, stub.raw() ) );
+			stream = cat.raw();
+		}
+		h.load( *stream, path_, setup._nativeLines ? 0 : source.line_skip() );
+		h.preprocess();
+		int status( 0 );
+		if ( ! h.parse() ) {
+			status = 1;
+		} else if ( ! h.compile( setup._modulePath, error_handling() ) ) {
+			status = 2;
+		}
+		if ( status != 0 ) {
+			error_ = ! setup._noColor ? colorize_error( h.error_message() ) : h.error_message();
+		}
+		return ( status );
+		M_EPILOG
+	}
+	HBatch( HBatch const& ) = delete;
+	HBatch& operator = ( HBatch const& ) = delete;
+};
+
+}
+
+bool is_batch( int argc_, char** argv_ ) {
+	M_PROLOG
+	if ( ! ( setup._lint || setup._tags || setup._reformat ) ) {
+		return ( false );
+	}
+	/*
+	 * Without `--batch` arguments following the program are its own arguments,
+	 * as in `huginn --lint script.hgn arg1 arg2`.
+	 */
+	if ( setup._batch ) {
+		return ( true );
+	}
+	return ( ( argc_ > 0 ) && filesystem::is_directory( argv_[0] ) );
+	M_EPILOG
+}
+
+int batch( int argc_, char** argv_ ) {
+	M_PROLOG
+	files_t files;
+	for ( int i( 0 ); i < argc_; ++ i ) {
+		HString path( argv_[i] );
+		if ( filesystem::is_directory( path ) ) {
+			path.trim_right( "/" );
+			find_scripts( ! path.is_empty() ? path : HString( "/" ), files );
+		} else {
+			files.push_back( path );
+		}
+	}
+	if ( ! setup._tags && ! setup._rapidStart ) {
+		/* Verify the grammar once, not once per program. */
+		HHuginn verifyGrammar;
+	}
+	HHuginn::disable_grammar_verification();
+	HBatch b( files );
+	return ( b.run() );
+	M_EPILOG
+}
+
+}
+
@@ -0,0 +1,25 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+/*! \file batch.hxx
+ * \brief Declaration of batch() function.
+ */
+
+#ifndef BATCH_HXX_INCLUDED
+#define BATCH_HXX_INCLUDED 1
+
+namespace huginn {
+
+/*! \brief Tell if linter, tags or reformat mode shall process many programs.
+ *
+ * It does with `--batch` switch, or when the first argument is a directory.
+ */
+bool is_batch( int, char** );
+
+/*! \brief Run linter, tags or reformat mode over many programs and directory trees.
+ */
+int batch( int, char** );
+
+}
+
+#endif /* #ifndef BATCH_HXX_INCLUDED */
+
@@ -6,7 +6,6 @@
 #include <yaal/hcore/hregex.hxx>
 #include <yaal/hcore/hfile.hxx>
 #include <yaal/tools/stringalgo.hxx>
-#include <yaal/tools/hfsitem.hxx>
 #include <yaal/tools/ansi.hxx>
 #include <yaal/tools/color.hxx>
 #include <yaal/tools/huginn/helper.hxx>
@@ -14,6 +13,7 @@ M_VCSID( "$Id: " __ID__ " $" )
 #include "colorize.hxx"
 #include "systemshell.hxx"
 #include "shell/util.hxx"
+#include "shell/fileinfocache.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -595,9 +595,10 @@ yaal::tools::COLOR::color_t file_color( yaal::tools::filesystem::path_t&& path_,
 	COLOR::color_t c( defaultColor_ );
 	denormalize_path( path_, true );
 	path_ = unescape_system( yaal::move( path_ ) );
-	try {
-		filesystem::FILE_TYPE ft( filesystem::file_type( path_ ) );
-		switch ( ft ) {
+	HSystemShell::HFileInfoCache const& fileInfoCache( shell_->file_info_cache() );
+	HSystemShell::HFileInfoCache::OFileInfo fileInfo( fileInfoCache.info( path_ ) );
+	if ( fileInfo._exists ) {
+		switch ( fileInfo._type ) {
 			case ( FILE_TYPE::SYMBOLIC_LINK ):    c = color( GROUP::SYMBOLIC_LINKS ); break;
 			case ( FILE_TYPE::DIRECTORY ):        c = color( GROUP::DIRECTORIES );    break;
 			case ( FILE_TYPE::FIFO ):             c = color( GROUP::FIFOS );          break;
@@ -622,20 +623,20 @@ yaal::tools::COLOR::color_t file_color( yaal::tools::filesystem::path_t&& path_,
 					}
 					++ ci;
 				}
-				if ( ! HFSItem( path_ ).is_executable() ) {
+				if ( ! fileInfo._executable ) {
 					break;
 				}
-				if ( is_suid( path_ ) ) {
+				if ( fileInfo._suid ) {
 					c = color( GROUP::SUID );
 				} else {
 					c = color( GROUP::EXECUTABLES );
 				}
 			} break;
 		}
-	} catch ( ... ) {
+	} else {
 		HSystemShell::system_commands_t::const_iterator it( shell_->system_commands().find( path_ ) );
 		if ( it != shell_->system_commands().end() ) {
-			c = color( is_suid( it->second + filesystem::path::SEPARATOR + path_ ) ? GROUP::SUID : GROUP::EXECUTABLES );
+			c = color( fileInfoCache.info( it->second + filesystem::path::SEPARATOR + path_ )._suid ? GROUP::SUID : GROUP::EXECUTABLES );
 		} else if ( shell_->builtins().count( path_ ) > 0 ) {
 			c = color( GROUP::SHELL_BUILTINS );
 		} else if ( shell_->aliases().count( path_ ) > 0 ) {
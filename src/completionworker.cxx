@@ -0,0 +1,169 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <yaal/hcore/hcore.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "completionworker.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+
+namespace huginn {
+
+HRepl::HCompletionWorker::HCompletionWorker( HRepl& repl_ )
+	: _repl( repl_ )
+	, _request()
+	, _pending( false )
+	, _busy( false )
+	, _waiting( false )
+	, _stop( false )
+	, _generation( 0 )
+	, _resultKind( KIND::COMPLETIONS )
+	, _resultContext()
+	, _result()
+	, _hasResult( false )
+	, _wakeUp()
+	, _idle()
+	, _mutex()
+	, _thread() {
+	M_PROLOG
+	_thread.spawn( call( &HCompletionWorker::run, this ) );
+	return;
+	M_EPILOG
+}
+
+HRepl::HCompletionWorker::~HCompletionWorker( void ) {
+	M_PROLOG
+	cancel();
+	{
+		HLock l( _mutex );
+		_stop = true;
+	}
+	_wakeUp.signal();
+	_thread.finish();
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+bool HRepl::HCompletionWorker::fetch( KIND kind_, yaal::hcore::HString const& context_, OResult& result_ ) {
+	M_PROLOG
+	HLock l( _mutex );
+	if ( ! _hasResult || ( _resultKind != kind_ ) || ( _resultContext != context_ ) ) {
+		return ( false );
+	}
+	result_ = _result;
+	/* Hints are asked for on every repaint, completions only once per request. */
+	if ( kind_ == KIND::COMPLETIONS ) {
+		_hasResult = false;
+	}
+	return ( true );
+	M_EPILOG
+}
+
+bool HRepl::HCompletionWorker::has_result( KIND kind_ ) {
+	M_PROLOG
+	HLock l( _mutex );
+	return ( _hasResult && ( _resultKind == kind_ ) );
+	M_EPILOG
+}
+
+void HRepl::HCompletionWorker::submit( KIND kind_, yaal::hcore::HString const& context_, yaal::hcore::HString const& prefix_, int contextLen_, bool shell_ ) {
+	M_PROLOG
+	{
+		HLock l( _mutex );
+		if ( _pending && ( _request._kind == kind_ ) && ( _request._context == context_ ) ) {
+			return;
+		}
+		++ _generation;
+		_request._kind = kind_;
+		_request._context = context_;
+		_request._prefix = prefix_;
+		_request._contextLen = contextLen_;
+		_request._shell = shell_;
+		_pending = true;
+	}
+	_wakeUp.signal();
+	return;
+	M_EPILOG
+}
+
+/*
+ * Drop pending request and any result not picked up yet,
+ * then wait for the request being processed right now (if any) to finish,
+ * so the caller may safely modify the state completions are generated from.
+ */
+void HRepl::HCompletionWorker::cancel( void ) {
+	M_PROLOG
+	bool busy( false );
+	{
+		HLock l( _mutex );
+		++ _generation;
+		_pending = false;
+		_hasResult = false;
+		busy = _busy;
+		_waiting = busy;
+	}
+	if ( busy ) {
+		_idle.wait();
+	}
+	return;
+	M_EPILOG
+}
+
+void HRepl::HCompletionWorker::run( void ) {
+	M_PROLOG
+	while ( true ) {
+		_wakeUp.wait();
+		ORequest request;
+		int generation( 0 );
+		{
+			HLock l( _mutex );
+			if ( _stop ) {
+				break;
+			}
+			if ( ! _pending ) {
+				continue;
+			}
+			request = _request;
+			generation = _generation;
+			_pending = false;
+			_busy = true;
+		}
+		OResult result;
+		result._contextLen = request._contextLen;
+		try {
+			result._completions = _repl.completion_words(
+				HString( request._context ), yaal::move( request._prefix ),
+				result._contextLen, result._contextType, request._shell, request._kind == KIND::HINTS
+			);
+		} catch ( HException const& ) {
+			result._completions.clear();
+		}
+		bool current( false );
+		{
+			HLock l( _mutex );
+			_busy = false;
+			current = ( generation == _generation );
+			if ( current ) {
+				_resultKind = request._kind;
+				_resultContext = yaal::move( request._context );
+				_result = yaal::move( result );
+				_hasResult = true;
+			}
+			if ( _waiting ) {
+				_waiting = false;
+				_idle.signal();
+			}
+		}
+		if ( current ) {
+			_repl.completion_ready( request._kind == KIND::HINTS );
+		}
+	}
+	return;
+	M_EPILOG
+}
+
+}
+
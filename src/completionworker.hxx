@@ -0,0 +1,85 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+/*! \file completionworker.hxx
+ * \brief Declaration of HRepl::HCompletionWorker class.
+ */
+
+#ifndef COMPLETIONWORKER_HXX_INCLUDED
+#define COMPLETIONWORKER_HXX_INCLUDED 1
+
+#include <yaal/hcore/hthread.hxx>
+
+#include "repl.hxx"
+
+namespace huginn {
+
+/*! \brief Background generator of completions and hints.
+ *
+ * Only the most recent request is kept, each new request (i.e. each keystroke)
+ * supersedes the previous one and results of superseded requests are dropped.
+ * When a result is ready the REPL is notified so it can pick the result up
+ * on the input thread.
+ */
+class HRepl::HCompletionWorker {
+public:
+	enum class KIND {
+		COMPLETIONS,
+		HINTS
+	};
+	struct OResult {
+		completions_t _completions;
+		int _contextLen;
+		CONTEXT_TYPE _contextType;
+		OResult( void )
+			: _completions()
+			, _contextLen( 0 )
+			, _contextType( CONTEXT_TYPE::HUGINN ) {
+		}
+	};
+private:
+	struct ORequest {
+		KIND _kind;
+		yaal::hcore::HString _context;
+		yaal::hcore::HString _prefix;
+		int _contextLen;
+		bool _shell;
+		ORequest( void )
+			: _kind( KIND::COMPLETIONS )
+			, _context()
+			, _prefix()
+			, _contextLen( 0 )
+			, _shell( false ) {
+		}
+	};
+	HRepl& _repl;
+	ORequest _request;
+	bool _pending;
+	bool _busy;
+	bool _waiting;
+	bool _stop;
+	int _generation;
+	KIND _resultKind;
+	yaal::hcore::HString _resultContext;
+	OResult _result;
+	bool _hasResult;
+	yaal::hcore::HSemaphore _wakeUp;
+	yaal::hcore::HSemaphore _idle;
+	yaal::hcore::HMutex _mutex;
+	yaal::hcore::HThread _thread;
+public:
+	HCompletionWorker( HRepl& );
+	~HCompletionWorker( void );
+	bool fetch( KIND, yaal::hcore::HString const&, OResult& );
+	bool has_result( KIND );
+	void submit( KIND, yaal::hcore::HString const&, yaal::hcore::HString const&, int, bool );
+	void cancel( void );
+private:
+	void run( void );
+	HCompletionWorker( HCompletionWorker const& ) = delete;
+	HCompletionWorker& operator = ( HCompletionWorker const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef COMPLETIONWORKER_HXX_INCLUDED */
+
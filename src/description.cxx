@@ -16,19 +16,24 @@ namespace huginn {
 
 HDescription::HDescription( void )
 	: _symbols()
+	, _baseSymbols()
+	, _locals()
 	, _classes()
 	, _functions()
 	, _packages()
 	, _memberMap()
 	, _docs()
 	, _docSymbols()
-	, _streamCache() {
+	, _streamCache()
+	, _stale( true ) {
 	return;
 }
 
 void HDescription::clear( void ) {
 	M_PROLOG
 	_symbols.clear();
+	_baseSymbols.clear();
+	_locals.clear();
 	_classes.clear();
 	_functions.clear();
 	_packages.clear();
@@ -36,13 +41,30 @@ void HDescription::clear( void ) {
 	_docs.clear();
 	_docSymbols.clear();
 	_streamCache.clear();
+	_stale = true;
 	return;
 	M_EPILOG
 }
 
+/*
+ * Only imports and definitions change what VM state dump describes,
+ * plain code lines change local variables only and those are tracked by `note_locals()`.
+ * Owner marks description as stale whenever an import or a definition is removed
+ * so the next `prepare()` is not skipped.
+ */
+void HDescription::invalidate( void ) {
+	_stale = true;
+}
+
+bool HDescription::is_stale( void ) const {
+	return ( _stale );
+}
+
 void HDescription::prepare( HHuginn const& huginn_ ) {
 	M_PROLOG
+	words_t locals( yaal::move( _locals ) );
 	clear();
+	_locals = yaal::move( locals );
 	/* scope for debugLevel */ {
 		HScopedValueReplacement<int> debugLevel( _debugLevel_, 0 );
 		huginn_.dump_vm_state( _streamCache );
@@ -188,16 +210,54 @@ void HDescription::prepare( HHuginn const& huginn_ ) {
 	transform( _packages.begin(), _packages.end(), back_insert_iterator( _docSymbols ), select1st<symbol_map_t::value_type>() );
 	sort( _docSymbols.begin(), _docSymbols.end() );
 	_docSymbols.erase( unique( _docSymbols.begin(), _docSymbols.end() ), _docSymbols.end() );
+	_baseSymbols = _symbols;
+	rebuild_symbols();
+	_stale = false;
 	return;
 	M_EPILOG
 }
 
+void HDescription::rebuild_symbols( void ) {
+	M_PROLOG
+	_symbols = _baseSymbols;
+	_symbols.insert( _symbols.end(), _locals.begin(), _locals.end() );
+	sort( _symbols.begin(), _symbols.end() );
+	_symbols.erase( unique( _symbols.begin(), _symbols.end() ), _symbols.end() );
+	return;
+	M_EPILOG
+}
+
+/*
+ * New statements usually only append local variables,
+ * in such case new names are merged into sorted symbol list one by one,
+ * any other change rebuilds the list.
+ */
 void HDescription::note_locals( yaal::tools::HIntrospecteeInterface::variable_views_t const& variableView_ ) {
 	M_PROLOG
+	int oldCount( static_cast<int>( _locals.get_size() ) );
+	int newCount( static_cast<int>( variableView_.get_size() ) );
+	bool appendOnly( newCount >= oldCount );
+	for ( int i( 0 ); appendOnly && ( i < oldCount ); ++ i ) {
+		appendOnly = variableView_[i].name() == _locals[i];
+	}
+	if ( appendOnly && ( newCount == oldCount ) ) {
+		return;
+	}
+	_locals.clear();
 	for ( HIntrospecteeInterface::HVariableView const& vv : variableView_ ) {
-		_symbols.push_back( vv.name() );
+		_locals.push_back( vv.name() );
+	}
+	if ( ! appendOnly ) {
+		rebuild_symbols();
+		return;
+	}
+	for ( int i( oldCount ); i < newCount; ++ i ) {
+		HString const& name( _locals[i] );
+		words_t::iterator it( lower_bound( _symbols.begin(), _symbols.end(), name ) );
+		if ( ( it == _symbols.end() ) || ( *it != name ) ) {
+			_symbols.insert( it, name );
+		}
 	}
-	sort( _symbols.begin(), _symbols.end() );
 	return;
 	M_EPILOG
 }
@@ -28,6 +28,8 @@ public:
 	};
 private:
 	words_t _symbols;
+	words_t _baseSymbols;
+	words_t _locals;
 	words_t _classes;
 	words_t _functions;
 	symbol_map_t _packages;
@@ -35,11 +37,14 @@ private:
 	symbol_map_t _docs;
 	words_t _docSymbols;
 	yaal::tools::HStringStream _streamCache;
+	bool _stale;
 public:
 	HDescription( void );
 	void prepare( yaal::tools::HHuginn const& );
 	void note_locals( yaal::tools::HIntrospecteeInterface::variable_views_t const& );
 	void clear( void );
+	void invalidate( void );
+	bool is_stale( void ) const;
 	words_t const& members( yaal::hcore::HString const& );
 	words_t const& symbols( bool ) const;
 	words_t const& classes( void ) const;
@@ -47,6 +52,8 @@ public:
 	yaal::hcore::HString const& package_alias( yaal::hcore::HString const& ) const;
 	yaal::hcore::HString doc( yaal::hcore::HString const&, yaal::hcore::HString const& = yaal::hcore::HString() ) const;
 	SYMBOL_KIND symbol_kind( yaal::hcore::HString const& ) const;
+private:
+	void rebuild_symbols( void );
 };
 
 void dump_call_stack( yaal::tools::HHuginn::call_stack_t const&, yaal::hcore::HStreamInterface& );
@@ -1,5 +1,18 @@
 /* Read huginn/LICENSE.md file for copyright and licensing information. */
 
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifndef __MSVCXX__
+#	include <fcntl.h>
+#	include <poll.h>
+#	include <unistd.h>
+#	include <sys/stat.h>
+#endif
+
+#include <yaal/hcore/hchunk.hxx>
+#include <yaal/hcore/system.hxx>
 #include <yaal/tools/hpipedchild.hxx>
 #include <yaal/tools/streamtools.hxx>
 
@@ -12,30 +25,289 @@ using namespace yaal::tools;
 
 namespace huginn {
 
-bool HForwardingShell::do_try_command( yaal::hcore::HString const& command_ ) {
+namespace {
+
+/*
+ * Split `--shell` value into the shell path and its leading options,
+ * e.g. `-l,-c,/bin/bash` gives `/bin/bash` and `[-l, -c]`.
+ */
+bool shell_command( yaal::hcore::HString& shell_, yaal::tools::HPipedChild::argv_t& argv_ ) {
 	M_PROLOG
-	HPipedChild pc;
-	HString shell( *setup._shell );
-	HPipedChild::argv_t argv;
-	while ( ! shell.is_empty() && ( shell.front() == '-'_ycp ) ) {
-		int long commaIdx( shell.find( ','_ycp ) );
-		argv.push_back( shell.substr( 0, commaIdx ) );
-		shell.shift_left( commaIdx + 1 );
+	shell_ = *setup._shell;
+	while ( ! shell_.is_empty() && ( shell_.front() == '-'_ycp ) ) {
+		int long commaIdx( shell_.find( ','_ycp ) );
+		argv_.push_back( shell_.substr( 0, commaIdx ) );
+		shell_.shift_left( commaIdx + 1 );
 	}
-	if ( shell.is_empty() ) {
+	if ( shell_.is_empty() ) {
 		return ( false );
 	}
-	if ( shell.front() == ','_ycp ) {
-		shell.shift_left( 1 );
-	} else if ( argv.is_empty() ) {
-		argv.push_back( "-c" );
+	if ( shell_.front() == ','_ycp ) {
+		shell_.shift_left( 1 );
+	} else if ( argv_.is_empty() ) {
+		argv_.push_back( "-c" );
+	}
+	return ( true );
+	M_EPILOG
+}
+
+HPipedChild::STATUS exit_status( int value_ ) {
+	HPipedChild::STATUS s;
+	s.type = HPipedChild::STATUS::TYPE::FINISHED;
+	s.value = value_;
+	return ( s );
+}
+
+}
+
+#ifndef __MSVCXX__
+
+/*! \brief Long lived forwarding shell process.
+ *
+ * The shell runs a small driver loop that reads commands from a control FIFO,
+ * `eval`s them with the original standard streams, and reports each exit status
+ * to a status FIFO as a line starting with a per-process sentinel.
+ * Commands are terminated with the sentinel line too, so they can span many lines.
+ * Because all commands are evaluated by one shell, working directory,
+ * environment, variables and functions carry over between commands.
+ */
+class HForwardingShell::HCoProcess {
+	static int const POLL_INTERVAL = 100;
+	static int const SHUTDOWN_TIMEOUT = 1000;
+	HPipedChild _child;
+	HString _dir;
+	HString _commandsPath;
+	HString _statusPath;
+	HString _sentinel;
+	int _commands;
+	int _status;
+	HString _pending;
+public:
+	HCoProcess( yaal::hcore::HString const& shell_, yaal::tools::HPipedChild::argv_t argv_ )
+		: _child()
+		, _dir()
+		, _commandsPath()
+		, _statusPath()
+		, _sentinel()
+		, _commands( -1 )
+		, _status( -1 )
+		, _pending() {
+		M_PROLOG
+		char const* tmp( ::getenv( "TMPDIR" ) );
+		HUTF8String dirTemplate( HString( tmp && tmp[0] ? tmp : "/tmp" ).append( "/huginn-shell-XXXXXX" ) );
+		HChunk dir;
+		dir.realloc( dirTemplate.byte_count() + 1 );
+		::memcpy( dir.raw(), dirTemplate.c_str(), static_cast<size_t>( dirTemplate.byte_count() + 1 ) );
+		if ( ! ::mkdtemp( dir.get<char>() ) ) {
+			throw HRuntimeException( "Cannot create forwarding shell control directory: "_ys.append( ::strerror( errno ) ) );
+		}
+		_dir = dir.get<char>();
+		_commandsPath.assign( _dir ).append( "/commands" );
+		_statusPath.assign( _dir ).append( "/status" );
+		/* Random part of the directory name keeps the sentinel from colliding with script contents. */
+		_sentinel.assign( "__huginn_" )
+			.append( static_cast<int long long>( system::getpid() ) )
+			.append( "_" )
+			.append( _dir.right( 6 ) );
+		/*
+		 * Both FIFOs are opened for reading and writing so neither side ever blocks in open(2)
+		 * waiting for its peer, shell death is noticed by polling its status instead.
+		 */
+		_commands = open_fifo( _commandsPath );
+		_status = open_fifo( _statusPath );
+		argv_.push_back(
+			"__huginn_commands=\"${1}\"; __huginn_sentinel=\"${3}\"; exec 3<\"${__huginn_commands}\" 4>\"${2}\"; set --\n"
+			"__huginn_code=\n"
+			"while IFS= read -r __huginn_line <&3 ; do\n"
+			"\tif [ \"${__huginn_line}\" = \"${__huginn_sentinel}\" ] ; then\n"
+			"\t\teval \"${__huginn_code}\" 3<&- 4>&-\n"
+			"\t\tprintf '%s %d\\n' \"${__huginn_sentinel}\" \"${?}\" >&4\n"
+			"\t\t__huginn_code=\n"
+			"\telse\n"
+			"\t\t__huginn_code=\"${__huginn_code}${__huginn_line}\n\"\n"
+			"\tfi\n"
+			"done\n"
+		);
+		argv_.push_back( "huginn" );
+		argv_.push_back( _commandsPath );
+		argv_.push_back( _statusPath );
+		argv_.push_back( _sentinel );
+		_child.spawn( shell_, argv_, &cin, &cout, &cerr );
+		return;
+		M_EPILOG
+	}
+	~HCoProcess( void ) {
+		M_PROLOG
+		/* Closing the last writer of the control FIFO ends the driver loop. */
+		if ( _commands >= 0 ) {
+			::close( _commands );
+		}
+		if ( _child.get_status().type == HPipedChild::STATUS::TYPE::RUNNING ) {
+			_child.finish( SHUTDOWN_TIMEOUT );
+		}
+		if ( _status >= 0 ) {
+			::close( _status );
+		}
+		HUTF8String path( _commandsPath );
+		::unlink( path.c_str() );
+		path.assign( _statusPath );
+		::unlink( path.c_str() );
+		path.assign( _dir );
+		::rmdir( path.c_str() );
+		return;
+		M_DESTRUCTOR_EPILOG
+	}
+	/*! \brief Run command in the co-process shell.
+	 *
+	 * \return True iff the shell survived the command.
+	 */
+	bool run( yaal::hcore::HString const& command_, yaal::tools::HPipedChild::STATUS& status_ ) {
+		M_PROLOG
+		HString request( command_ );
+		if ( request.is_empty() || ( request.back() != '\n'_ycp ) ) {
+			request.push_back( '\n'_ycp );
+		}
+		request.append( _sentinel ).push_back( '\n'_ycp );
+		HUTF8String utf8( request );
+		char const* data( utf8.c_str() );
+		int long toWrite( utf8.byte_count() );
+		while ( toWrite > 0 ) {
+			int long nWritten( static_cast<int long>( ::write( _commands, data, static_cast<size_t>( toWrite ) ) ) );
+			if ( nWritten < 0 ) {
+				if ( errno == EINTR ) {
+					continue;
+				}
+				throw HRuntimeException( "Cannot send command to forwarding shell: "_ys.append( ::strerror( errno ) ) );
+			}
+			data += nWritten;
+			toWrite -= nWritten;
+		}
+		return ( wait_for_status( status_ ) );
+		M_EPILOG
 	}
+private:
+	static int open_fifo( yaal::hcore::HString const& path_ ) {
+		M_PROLOG
+		HUTF8String path( path_ );
+		if ( ::mkfifo( path.c_str(), 0600 ) != 0 ) {
+			throw HRuntimeException( "Cannot create forwarding shell control FIFO: "_ys.append( ::strerror( errno ) ) );
+		}
+		int fd( ::open( path.c_str(), O_RDWR | O_CLOEXEC ) );
+		if ( fd < 0 ) {
+			throw HRuntimeException( "Cannot open forwarding shell control FIFO: "_ys.append( ::strerror( errno ) ) );
+		}
+		return ( fd );
+		M_EPILOG
+	}
+	bool wait_for_status( yaal::tools::HPipedChild::STATUS& status_ ) {
+		M_PROLOG
+		char buffer[256];
+		pollfd pfd{ _status, POLLIN, 0 };
+		while ( true ) {
+			int long newLineIdx( _pending.find( '\n'_ycp ) );
+			if ( newLineIdx != HString::npos ) {
+				HString line( _pending.left( newLineIdx ) );
+				_pending.shift_left( newLineIdx + 1 );
+				if ( line.starts_with( _sentinel ) ) {
+					line.shift_left( _sentinel.get_length() );
+					line.trim();
+					status_ = exit_status( lexical_cast<int>( line ) );
+					return ( true );
+				}
+				continue;
+			}
+			int ready( ::poll( &pfd, 1, POLL_INTERVAL ) );
+			if ( ready > 0 ) {
+				int long nRead( static_cast<int long>( ::read( _status, buffer, sizeof ( buffer ) ) ) );
+				if ( nRead > 0 ) {
+					_pending.append( buffer, nRead );
+				}
+				continue;
+			}
+			if ( ( ready < 0 ) && ( errno != EINTR ) ) {
+				throw HRuntimeException( "Cannot read forwarding shell status: "_ys.append( ::strerror( errno ) ) );
+			}
+			HPipedChild::STATUS s( _child.get_status() );
+			if ( ( s.type != HPipedChild::STATUS::TYPE::RUNNING ) && ( s.type != HPipedChild::STATUS::TYPE::PAUSED ) ) {
+				/* Command made the shell exit, e.g. with `exit` builtin. */
+				status_ = s;
+				return ( false );
+			}
+		}
+		M_EPILOG
+	}
+	HCoProcess( HCoProcess const& ) = delete;
+	HCoProcess& operator = ( HCoProcess const& ) = delete;
+};
+
+#else
+
+class HForwardingShell::HCoProcess {
+};
+
+#endif
+
+HForwardingShell::HForwardingShell( void )
+	: _coProcess() {
+	return;
+}
+
+HForwardingShell::~HForwardingShell( void ) {
+	return;
+}
+
+yaal::tools::HPipedChild::STATUS HForwardingShell::run_command( yaal::hcore::HString const& command_ ) {
+	M_PROLOG
+	HString shell;
+	HPipedChild::argv_t argv;
+	if ( ! shell_command( shell, argv ) ) {
+		return ( exit_status( -1 ) );
+	}
+#ifndef __MSVCXX__
+	if ( setup._persistentShell ) {
+		if ( ! _coProcess ) {
+			_coProcess = make_resource<HCoProcess>( shell, argv );
+		}
+		HPipedChild::STATUS s;
+		if ( ! _coProcess->run( command_, s ) ) {
+			/* Next command gets a fresh shell. */
+			_coProcess.reset();
+		}
+		return ( s );
+	}
+#endif
+	HPipedChild pc;
 	argv.push_back( command_ );
 	pc.spawn( shell, argv, &cin, &cout, &cerr );
-	HPipedChild::STATUS s( pc.finish( OSetup::CENTURY_IN_MILLISECONDS ) );
+	return ( pc.finish( OSetup::CENTURY_IN_MILLISECONDS ) );
+	M_EPILOG
+}
+
+bool HForwardingShell::do_try_command( yaal::hcore::HString const& command_ ) {
+	M_PROLOG
+	HPipedChild::STATUS s( run_command( command_ ) );
 	return ( ( s.type == HPipedChild::STATUS::TYPE::FINISHED ) && ( s.value == 0 ) );
 	M_EPILOG
 }
 
+int HForwardingShell::do_run_script( yaal::hcore::HStreamInterface& shellScript_, yaal::hcore::HString const& ) {
+	M_PROLOG
+	/*
+	 * Script is handed to the shell as a single unit, so compound commands,
+	 * function bodies and here-documents spanning many lines work,
+	 * and `exit` ends the whole script, as it would in the shell itself.
+	 */
+	HString script;
+	HString line;
+	while ( getline( shellScript_, line ).good() ) {
+		script.append( line ).push_back( '\n'_ycp );
+	}
+	if ( script.is_empty() ) {
+		return ( 0 );
+	}
+	return ( run_command( script ).value );
+	M_EPILOG
+}
+
 }
 
@@ -12,6 +12,14 @@
 namespace huginn {
 
 class HForwardingShell : public HShell {
+public:
+	class HCoProcess;
+	typedef yaal::hcore::HResource<HCoProcess> co_process_t;
+private:
+	co_process_t _coProcess;
+public:
+	HForwardingShell( void );
+	virtual ~HForwardingShell( void );
 private:
 	virtual bool do_is_valid_command( yaal::hcore::HString const& ) override {
 		return ( false );
@@ -23,9 +31,10 @@ private:
 	virtual completions_t do_gen_completions( yaal::hcore::HString const&, yaal::hcore::HString const&, bool ) const override {
 		return ( completions_t() );
 	}
-	virtual int do_run_script( yaal::hcore::HStreamInterface&, yaal::hcore::HString const& ) override {
-		return ( 0 );
-	}
+	virtual int do_run_script( yaal::hcore::HStreamInterface&, yaal::hcore::HString const& ) override;
+	yaal::tools::HPipedChild::STATUS run_command( yaal::hcore::HString const& );
+	HForwardingShell( HForwardingShell const& ) = delete;
+	HForwardingShell& operator = ( HForwardingShell const& ) = delete;
 };
 
 }
@@ -9,6 +9,7 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "gendocs.hxx"
 #include "description.hxx"
 #include "setup.hxx"
+#include "scriptsource.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -27,27 +28,13 @@ HString escape( HString&& str_ ) {
 int gen_docs( int argc_, char** argv_ ) {
 	HHuginn::disable_grammar_verification();
 	HHuginn h;
-	HPointer<HFile> f;
-	bool readFromScript( ( argc_ > 0 ) && ( argv_[0] != "-"_ys ) );
-	if ( readFromScript ) {
-		f = make_pointer<HFile>( argv_[0], HFile::OPEN::READING );
-		if ( ! *f ) {
-			throw HFileException( f->get_error() );
-		}
+	HResource<HScriptSource> script;
+	if ( argc_ > 0 ) {
+		script = make_resource<HScriptSource>( argv_[0], setup._embedded ? HScriptSource::EMBEDDED::YES : HScriptSource::EMBEDDED::NO );
 	}
 	HStringStream empty( "main(){}" );
-	HStreamInterface* source( readFromScript ? static_cast<HStreamInterface*>( f.raw() ) : ( argc_ > 0 ? static_cast<HStreamInterface*>( &cin ) : &empty ) );
-	int lineSkip( 0 );
-	if ( setup._embedded ) {
-		HString s;
-		HRegex r( "^#!.*\\bhuginn\\b.*" );
-		while ( getline( *source, s ).good() ) {
-			++ lineSkip;
-			if ( r.matches( s ) ) {
-				break;
-			}
-		}
-	}
+	HStreamInterface* source( !! script ? &script->stream() : static_cast<HStreamInterface*>( &empty ) );
+	int lineSkip( !! script ? script->line_skip() : 0 );
 	h.load( *source, setup._nativeLines ? 0 : lineSkip );
 	h.preprocess();
 	int err( 0 );
@@ -0,0 +1,58 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <yaal/hcore/hlog.hxx>
+#include <yaal/hcore/hclock.hxx>
+#include <yaal/tools/hhuginn.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "grammar.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+HGrammar& HGrammar::get_instance( void ) {
+	static thread_local HGrammar grammar;
+	return ( grammar );
+}
+
+/*
+ * Grammar verification policy is left as the runner has set it (see `--rapid-start`),
+ * runners switch verification off before the grammar is first used,
+ * so the interpreter built here does not verify the grammar again.
+ */
+HGrammar::HGrammar( void )
+	: _grammarSource()
+	, _grammar()
+	, _parsers()
+	, _buildTime( 0 ) {
+	M_PROLOG
+	HClock c;
+	_grammarSource = make_resource<HHuginn>();
+	_grammar = _grammarSource->make_engine();
+	_buildTime = c.get_time_elapsed( time::UNIT::NANOSECOND );
+	hcore::log( LOG_LEVEL::DEBUG ) << "Grammar built in " << durationformat( time::UNIT_FORM::ABBREVIATED ) << time::duration_t( _buildTime ) << endl;
+	return;
+	M_EPILOG
+}
+
+bool HGrammar::parse( yaal::hcore::HString const& ruleName_, yaal::hcore::HString const& input_ ) {
+	M_PROLOG
+	parser_t& parser( _parsers[ruleName_] );
+	if ( ! parser ) {
+		executing_parser::HRuleBase const* rule( _grammar.find( ruleName_ ) );
+		if ( ! rule ) {
+			throw HRuntimeException( "Unknown grammar rule: `"_ys.append( ruleName_ ).append( "`." ) );
+		}
+		parser = make_resource<HExecutingParser>( *rule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
+	}
+	return ( ( *parser )( input_ ) );
+	M_EPILOG
+}
+
+}
+
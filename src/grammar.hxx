@@ -0,0 +1,52 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+/*! \file grammar.hxx
+ * \brief Declaration of HGrammar class.
+ */
+
+#ifndef GRAMMAR_HXX_INCLUDED
+#define GRAMMAR_HXX_INCLUDED 1
+
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hresource.hxx>
+#include <yaal/tools/executingparser.hxx>
+#include <yaal/tools/hhuginn.hxx>
+
+namespace huginn {
+
+/*! \brief Per thread registry of Huginn grammar rules.
+ *
+ * Grammar is built once per thread, on first use in that thread,
+ * and a parser for each individual rule is created once, when the rule is first asked for.
+ * Semantic actions of all parsers are bound to the interpreter the grammar was made from,
+ * so each thread has its own interpreter and parsers, and parsing needs no lock.
+ */
+class HGrammar {
+public:
+	typedef yaal::hcore::HResource<yaal::tools::HExecutingParser> parser_t;
+private:
+	typedef yaal::hcore::HHashMap<yaal::hcore::HString, parser_t> parsers_t;
+	yaal::hcore::HResource<yaal::tools::HHuginn> _grammarSource;
+	yaal::tools::executing_parser::HRule _grammar;
+	parsers_t _parsers;
+	yaal::i64_t _buildTime;
+public:
+	static HGrammar& get_instance( void );
+	/*! \brief Tell if given input matches given grammar rule.
+	 */
+	bool parse( yaal::hcore::HString const&, yaal::hcore::HString const& );
+	/*! \brief Get time (in nanoseconds) it took to build the grammar.
+	 */
+	yaal::i64_t build_time( void ) const {
+		return ( _buildTime );
+	}
+private:
+	HGrammar( void );
+	HGrammar( HGrammar const& ) = delete;
+	HGrammar& operator = ( HGrammar const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef GRAMMAR_HXX_INCLUDED */
+
@@ -6,7 +6,6 @@
 #include <yaal/tools/stringalgo.hxx>
 #include <yaal/tools/streamtools.hxx>
 #include <yaal/tools/filesystem.hxx>
-#include <yaal/tools/hmemory.hxx>
 #include <yaal/tools/huginn/runtime.hxx>
 #include <yaal/tools/huginn/thread.hxx>
 #include <yaal/tools/huginn/objectfactory.hxx>
@@ -20,6 +19,8 @@ M_VCSID( "$Id: " __ID__ " $" )
 #include "systemshell.hxx"
 #include "colorize.hxx"
 #include "timeit.hxx"
+#include "profiler.hxx"
+#include "scriptsource.hxx"
 #include "setup.hxx"
 
 using namespace yaal;
@@ -53,6 +54,28 @@ HHuginn::value_t repl( HPrompt* prompt_, tools::huginn::HThread* thread_, HHugin
 
 }
 
+yaal::hcore::HString assume_used_stub( void ) {
+	M_PROLOG
+	hcore::HString stub( "\n\n\nlist_of_symbol_names_assume_used_by_linter() { [" );
+	for ( yaal::hcore::HString const& symbolName : setup._assumeUsed ) {
+		stub.append( symbolName ).append( "," );
+	}
+	stub.append( "list_of_symbol_names_assume_used_by_linter];}" );
+	return stub;
+	M_EPILOG
+}
+
+void register_builtins( HHuginn& huginn_, HPrompt& prompt_ ) {
+	M_PROLOG
+	huginn_.register_function( "repl", call( &repl, &prompt_, _1, _2, _3, _4 ), "( [*prompt*] ) - read line of user input potentially prefixing it with *prompt*" );
+	return;
+	M_EPILOG
+}
+
+HHuginn::compiler_setup_t error_handling( void ) {
+	return ( setup._beSloppy ? HHuginn::COMPILER::BE_SLOPPY : HHuginn::COMPILER::BE_STRICT );
+}
+
 int run_huginn( int argc_, char** argv_ ) {
 	M_PROLOG
 	if ( setup._rapidStart ) {
@@ -61,45 +84,36 @@ int run_huginn( int argc_, char** argv_ ) {
 	HClock c;
 	HHuginn h( setup._optimize ? HHuginn::COMPILER::OPTIMIZE : HHuginn::COMPILER::DEFAULT );
 	HPrompt prompt;
-	h.register_function( "repl", call( &repl, &prompt, _1, _2, _3, _4 ), "( [*prompt*] ) - read line of user input potentially prefixing it with *prompt*" );
+	register_builtins( h, prompt );
 	time::duration_t huginn( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
-	HResource<HFile> f;
 	bool readFromScript( ( argc_ > 0 ) && ( argv_[0] != "-"_ys ) );
 	hcore::HString scriptPath( argc_ > 0 ? argv_[0] : "" );
-	if ( readFromScript ) {
-		f = make_resource<HFile>( scriptPath, HFile::OPEN::READING );
-		if ( ! *f ) {
-			if ( is_relative( scriptPath ) ) {
-				scriptPath.append( ".hgn" );
-				HHuginn::paths_t paths( HHuginn::MODULE_PATHS );
-				paths.insert( paths.end(), setup._modulePath.begin(), setup._modulePath.end() );
-				paths.push_back( setup._sessionDir );
-				for ( hcore::HString path : paths ) {
-					path.append( path::SEPARATOR ).append( scriptPath );
-					f = make_resource<HFile>( path, HFile::OPEN::READING );
-					if ( !! *f ) {
-						break;
-					}
-				}
-				if ( ! *f ) {
-					throw HFileException( "Huginn module : '"_ys.append( argv_[0] ).append( "' was not found." ) );
-				}
-			} else {
-				throw HFileException( f->get_error() );
+	hcore::HString sourcePath( scriptPath );
+	if ( readFromScript && ! exists( scriptPath ) && is_relative( scriptPath ) ) {
+		scriptPath.append( ".hgn" );
+		HHuginn::paths_t paths( HHuginn::MODULE_PATHS );
+		paths.insert( paths.end(), setup._modulePath.begin(), setup._modulePath.end() );
+		paths.push_back( setup._sessionDir );
+		sourcePath.clear();
+		for ( hcore::HString path : paths ) {
+			path.append( path::SEPARATOR ).append( scriptPath );
+			if ( exists( path ) ) {
+				sourcePath = path;
+				break;
 			}
 		}
+		if ( sourcePath.is_empty() ) {
+			throw HFileException( "Huginn module : '"_ys.append( argv_[0] ).append( "' was not found." ) );
+		}
 	}
-	HStreamInterface* source( readFromScript ? static_cast<HStreamInterface*>( f.raw() ) : &cin );
+	c.reset();
+	HScriptSource script( readFromScript ? sourcePath : hcore::HString(), setup._embedded ? HScriptSource::EMBEDDED::YES : HScriptSource::EMBEDDED::NO );
+	HStreamInterface* source( &script.stream() );
 	HResource<HCat> cat;
 	HResource<HStringStream> ss;
 	if ( ! setup._assumeUsed.is_empty() ) {
-		ss = make_resource<HStringStream>();
+		ss = make_resource<HStringStream>( assume_used_stub() );
 		cat = make_resource<HCat>( tools::cat( source, ss.raw() ) );
-		*ss << "\n\n\nlist_of_symbol_names_assume_used_by_linter() { [";
-		for ( yaal::hcore::HString const& symbolName : setup._assumeUsed ) {
-			*ss << symbolName << ",";
-		}
-		*ss << "list_of_symbol_names_assume_used_by_linter];}";
 		source = cat.raw();
 	}
 
@@ -108,18 +122,10 @@ int run_huginn( int argc_, char** argv_ ) {
 			h.add_argument( argv_[i] );
 		}
 	}
-	c.reset();
-	int lineSkip( 0 );
+	int lineSkip( script.line_skip() );
 	if ( setup._embedded ) {
-		hcore::HString line;
+		hcore::HString const& line( script.shebang() );
 #define LANG_NAME "huginn"
-		HRegex r( "^#!.*\\b" LANG_NAME "\\b.*" );
-		while ( getline( *source, line ).good() ) {
-			++ lineSkip;
-			if ( r.matches( line ) ) {
-				break;
-			}
-		}
 		int long settingPos( line.find( LANG_NAME ) );
 		if ( settingPos != hcore::HString::npos ) {
 			settingPos += static_cast<int>( sizeof ( LANG_NAME ) );
@@ -156,8 +162,8 @@ int run_huginn( int argc_, char** argv_ ) {
 		}
 		time::duration_t parse( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
 		c.reset();
-		HHuginn::compiler_setup_t errorHandling( setup._beSloppy ? HHuginn::COMPILER::BE_SLOPPY : HHuginn::COMPILER::BE_STRICT );
-		if ( ! h.compile( setup._modulePath, errorHandling ) ) {
+		HResource<HProfiler> profiler( !! setup._profile ? make_resource<HProfiler>() : HResource<HProfiler>() );
+		if ( ! h.compile( setup._modulePath, error_handling(), profiler.raw() ) ) {
 			retVal = 2;
 			break;
 		}
@@ -165,10 +171,21 @@ int run_huginn( int argc_, char** argv_ ) {
 		time::duration_t execute( 0 );
 		time::duration_t preciseTime( 0 );
 		int runs( 0 );
+		durations_t samples;
 		if ( ! setup._lint ) {
 			c.reset();
-			ok = timeit( h, preciseTime, runs );
+			if ( !! profiler ) {
+				profiler->start();
+			}
+			ok = timeit( h, preciseTime, runs, samples );
 			execute = time::duration_t( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+			if ( !! profiler ) {
+				profiler->stop();
+				profiler->report( cerr );
+				if ( ! setup._profile->is_empty() ) {
+					profiler->save_collapsed_stacks( *setup._profile );
+				}
+			}
 			if ( ! ok ) {
 				if ( setup._verbose ) {
 					dump_call_stack( h.trace(), cerr );
@@ -189,7 +206,7 @@ int run_huginn( int argc_, char** argv_ ) {
 				<< "), compile(" << compile
 				<< "), execute(" << execute << ")" << endl;
 		}
-		report_timeit( huginn, load, preprocess, parse, compile, execute, preciseTime, runs );
+		report_timeit( huginn, load, preprocess, parse, compile, execute, preciseTime, runs, samples );
 		if ( ! setup._lint ) {
 			HHuginn::value_t result( h.result() );
 			if ( result->type_id() == HHuginn::TYPE::INTEGER ) {
@@ -209,53 +226,5 @@ int run_huginn( int argc_, char** argv_ ) {
 	M_EPILOG
 }
 
-buffer_t load( char const* path_, int* lineSkip_ ) {
-	M_PROLOG
-	HResource<HFile> f;
-	HStreamInterface* stream( nullptr );
-	if ( path_ && ( path_ != "-"_ys ) ) {
-		f = make_resource<HFile>( path_, HFile::OPEN::READING );
-		if ( ! *f ) {
-			throw HFileException( f->get_error() );
-		}
-		stream = f.raw();
-	} else {
-		stream = &cin;
-	}
-	static int const INITIAL_SIZE( 4096 );
-	int nSize( 0 );
-	buffer_t buffer( INITIAL_SIZE, '\0' );
-	while ( true ) {
-		int toRead( static_cast<int>( buffer.get_size() ) - nSize );
-		int nRead( static_cast<int>( stream->read( buffer.data() + nSize, toRead ) ) );
-		nSize += nRead;
-		if ( nRead < toRead ) {
-			break;
-		}
-		buffer.resize( buffer.get_size() * 2 );
-	}
-	buffer.resize( nSize );
-	char const* raw( buffer.data() );
-	bool embedded( ( nSize > 2 ) && ( raw[0] == '#' ) && ( raw[1] == '!' ) );
-	int lineSkip( 0 );
-	HMemory source( make_resource<HMemoryObserver>( buffer.data(), nSize ), HMemory::INITIAL_STATE::VALID );
-	if ( embedded ) {
-		hcore::HString line;
-		HRegex r( "^#!.*\\bhuginn\\b.*" );
-		while ( getline( source, line ).good() ) {
-			++ lineSkip;
-			if ( r.matches( line ) ) {
-				break;
-			}
-		}
-	}
-	buffer.erase( buffer.begin(), buffer.begin() + ( nSize - source.valid_octets() ) );
-	if ( lineSkip_ ) {
-		*lineSkip_ = lineSkip;
-	}
-	return buffer;
-	M_EPILOG
-}
-
 }
 
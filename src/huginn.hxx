@@ -7,9 +7,18 @@
 
 namespace huginn {
 
+class HPrompt;
+
 int run_huginn( int, char** );
-typedef yaal::hcore::HArray<char> buffer_t;
-buffer_t load( char const*, int* = nullptr );
+/*! \brief Register functions that huginn program sees on top of the language built-ins.
+ */
+void register_builtins( yaal::tools::HHuginn&, HPrompt& );
+/*! \brief Get compiler error handling mode selected with `--be-sloppy`.
+ */
+yaal::tools::HHuginn::compiler_setup_t error_handling( void );
+/*! \brief Get code that makes linter treat symbols given with `--assume-used` as used.
+ */
+yaal::hcore::HString assume_used_stub( void );
 
 }
 
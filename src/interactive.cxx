@@ -53,7 +53,7 @@ COLOR::color_t symbol_color( yaal::hcore::HString const& symbol_ ) {
 	return c;
 }
 
-HRepl::completions_t completion_words( yaal::hcore::HString&& context_, yaal::hcore::HString&& prefix_, int& contextLen_, CONTEXT_TYPE& contextType_, void* data_, bool hints_ ) {
+HRepl::completions_t completion_words( yaal::hcore::HString&& context_, yaal::hcore::HString&& prefix_, int& contextLen_, CONTEXT_TYPE& contextType_, void* data_, HShell* shell_, bool hints_ ) {
 	M_PROLOG
 	HRepl* repl( static_cast<HRepl*>( data_ ) );
 	HRepl::completions_t completions;
@@ -134,7 +134,7 @@ HRepl::completions_t completion_words( yaal::hcore::HString&& context_, yaal::hc
 				break;
 			}
 		}
-		HSystemShell* systemShell( dynamic_cast<HSystemShell*>( repl->shell() ) );
+		HSystemShell* systemShell( dynamic_cast<HSystemShell*>( shell_ ) );
 		if ( systemShell ) {
 			try {
 				hcore::HString shellPrefix( context_ );
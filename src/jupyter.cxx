@@ -1,7 +1,14 @@
 /* Read huginn/LICENSE.md file for copyright and licensing information. */
 
+#include <cstring>
+
 #include <yaal/hcore/hfile.hxx>
+#include <yaal/hcore/hchunk.hxx>
+#include <yaal/hcore/hlist.hxx>
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hthread.hxx>
 #include <yaal/tools/huginn/integer.hxx>
+#include <yaal/tools/stringalgo.hxx>
 M_VCSID( "$Id: " __ID__ " $" )
 M_VCSID( "$Id: " __TID__ " $" )
 #include "jupyter.hxx"
@@ -17,62 +24,380 @@ using namespace yaal::tools::filesystem;
 
 namespace huginn {
 
-int jupyter_session( void ) {
+namespace {
+
+HLineRunner::words_t symbolic_completions( yaal::hcore::HString const& name_ ) {
+	M_PROLOG
+	HLineRunner::words_t completions;
+	char const* symbol( symbol_from_name( name_ ) );
+	if ( symbol ) {
+		completions.push_back( symbol );
+	} else {
+		symbolic_names_t sn( symbol_name_completions( name_ ) );
+		completions.insert( completions.end(), sn.begin(), sn.end() );
+	}
+	return completions;
+	M_EPILOG
+}
+
+/*
+ * Cell result, returns `true` iff the cell was executed successfully.
+ */
+bool run_cell( HLineRunner& lr_, yaal::hcore::HString const& code_, yaal::hcore::HString& result_, int& retVal_ ) {
+	M_PROLOG
+	result_.clear();
+	if ( ! lr_.add_line( code_, true ) ) {
+		result_ = lr_.err();
+		return ( false );
+	}
+	HHuginn::value_t res( lr_.execute() );
+	if ( !! res && lr_.use_result() && ( res->type_id() == HHuginn::TYPE::INTEGER ) ) {
+		retVal_ = static_cast<int>( static_cast<tools::huginn::HInteger*>( res.raw() )->value() );
+	} else {
+		retVal_ = 0;
+	}
+	if ( ! res ) {
+		result_ = lr_.err();
+		return ( false );
+	}
+	if ( lr_.use_result() ) {
+		result_ = tools::code( res, lr_.huginn() );
+	}
+	return ( true );
+	M_EPILOG
+}
+
+/*
+ * Writes frames to the standard output, one frame at a time.
+ * Frame is a header line: `<type> <request-id> <payload-byte-count>`
+ * followed by the payload.
+ */
+class HFramer {
+	HFile _out;
+	HMutex _mutex;
+public:
+	HFramer( void )
+		: _out( stdout, HFile::OWNERSHIP::EXTERNAL )
+		, _mutex() {
+	}
+	void send( char const* type_, int id_, yaal::hcore::HString const& payload_ ) {
+		M_PROLOG
+		HUTF8String utf8( payload_ );
+		send( type_, id_, utf8.c_str(), utf8.byte_count() );
+		return;
+		M_EPILOG
+	}
+	void send( char const* type_, int id_, char const* data_, int long size_ ) {
+		M_PROLOG
+		HLock l( _mutex );
+		_out << type_ << " " << id_ << " " << size_ << "\n";
+		if ( size_ > 0 ) {
+			_out.write( data_, size_ );
+		}
+		_out.flush();
+		return;
+		M_EPILOG
+	}
+private:
+	HFramer( HFramer const& ) = delete;
+	HFramer& operator = ( HFramer const& ) = delete;
+};
+
+/*
+ * Replaces `cout` for the duration of framed session,
+ * everything a cell prints is streamed to the client as `output` frames
+ * of the request being executed, one frame per line (or per flush).
+ */
+class HCellOutput : public yaal::hcore::HStreamInterface {
+public:
+	static int const MAX_FRAME_SIZE = 64 * 1024;
+private:
+	HFramer& _framer;
+	int _id;
+	yaal::hcore::HArray<char> _buffer;
+	HMutex _mutex;
+public:
+	HCellOutput( HFramer& framer_ )
+		: _framer( framer_ )
+		, _id( 0 )
+		, _buffer()
+		, _mutex() {
+	}
+	void set_request( int id_ ) {
+		M_PROLOG
+		HLock l( _mutex );
+		send();
+		_id = id_;
+		return;
+		M_EPILOG
+	}
+private:
+	void send( void ) {
+		M_PROLOG
+		if ( _buffer.is_empty() ) {
+			return;
+		}
+		_framer.send( "output", _id, _buffer.data(), _buffer.get_size() );
+		_buffer.clear();
+		return;
+		M_EPILOG
+	}
+	virtual int long do_write( void const* data_, int long size_ ) override {
+		M_PROLOG
+		HLock l( _mutex );
+		char const* data( static_cast<char const*>( data_ ) );
+		_buffer.insert( _buffer.end(), data, data + size_ );
+		if ( ::memchr( data, '\n', static_cast<size_t>( size_ ) ) || ( _buffer.get_size() >= MAX_FRAME_SIZE ) ) {
+			send();
+		}
+		return ( size_ );
+		M_EPILOG
+	}
+	virtual void do_flush( void ) override {
+		M_PROLOG
+		HLock l( _mutex );
+		send();
+		return;
+		M_EPILOG
+	}
+	virtual int long do_read( void*, int long ) override {
+		return ( -1 );
+	}
+	virtual bool do_is_valid( void ) const override {
+		return ( true );
+	}
+	virtual POLL_TYPE do_poll_type( void ) const override {
+		return ( POLL_TYPE::EMULATED );
+	}
+	virtual void const* do_data( void ) const override {
+		return ( this );
+	}
+};
+
+/*
+ * Framed Jupyter kernel protocol.
+ *
+ * Requests (client to huginn) and responses (huginn to client) are frames,
+ * see HFramer for the layout.
+ *
+ * `execute` (payload: cell code) and `meta` (payload: `//command ...`) requests
+ * are queued and run in order on a separate thread.
+ * While a request runs its output is streamed as `output` frames,
+ * and the request is concluded with `result` (payload: representation of cell value, if any)
+ * or `error` (payload: error message) frame.
+ *
+ * `complete` requests (payload: the same as in `//?` line protocol query)
+ * are answered immediately with `completions` frame (payload: new line separated words),
+ * while a cell runs answers come from the state after the previous cell.
+ */
+class HFramedSession {
+	struct ORequest {
+		hcore::HString _type;
+		int _id;
+		hcore::HString _payload;
+		ORequest( void )
+			: _type()
+			, _id( 0 )
+			, _payload() {
+		}
+	};
+	typedef yaal::hcore::HList<ORequest> requests_t;
+	typedef yaal::hcore::HHashMap<yaal::hcore::HString, HLineRunner::words_t> dependent_symbols_t;
+	HLineRunner& _lr;
+	HFramer _framer;
+	HStreamInterface::ptr_t _output;
+	requests_t _requests;
+	bool _busy;
+	HLineRunner::words_t _words;
+	dependent_symbols_t _dependentSymbols;
+	int _retVal;
+	HSemaphore _queued;
+	HMutex _mutex;
+	HThread _executor;
+public:
+	HFramedSession( HLineRunner& lr_ )
+		: _lr( lr_ )
+		, _framer()
+		, _output( make_pointer<HCellOutput>( _framer ) )
+		, _requests()
+		, _busy( false )
+		, _words()
+		, _dependentSymbols()
+		, _retVal( 0 )
+		, _queued()
+		, _mutex()
+		, _executor() {
+	}
+	int run( void ) {
+		M_PROLOG
+		_words = _lr.words( false );
+		cout.reset_owned( _output );
+		_executor.spawn( call( &HFramedSession::execute_requests, this ) );
+		ORequest request;
+		while ( read_request( request ) ) {
+			if ( ( request._type == "execute" ) || ( request._type == "meta" ) ) {
+				enqueue( yaal::move( request ) );
+			} else if ( request._type == "complete" ) {
+				_framer.send( "completions", request._id, string::join( complete( request._payload ), "\n" ) );
+			} else {
+				_framer.send( "error", request._id, "Unknown request type: "_ys.append( request._type ) );
+			}
+		}
+		enqueue( ORequest() );
+		_executor.finish();
+		cout.reset_owned( make_pointer<HFile>( stdout, HFile::OWNERSHIP::EXTERNAL ) );
+		return ( _retVal );
+		M_EPILOG
+	}
+private:
+	bool read_request( ORequest& request_ ) {
+		M_PROLOG
+		hcore::HString header;
+		if ( ! getline( cin, header ).good() ) {
+			return ( false );
+		}
+		string::tokens_t tokens( string::split<string::tokens_t>( header, " ", HTokenizer::SKIP_EMPTY ) );
+		int long size( -1 );
+		if ( tokens.get_size() == 3 ) {
+			try {
+				request_._type = tokens[0];
+				request_._id = lexical_cast<int>( tokens[1] );
+				size = lexical_cast<int long>( tokens[2] );
+			} catch ( HException const& ) {
+				size = -1;
+			}
+		}
+		if ( size < 0 ) {
+			/* There is no way to find next frame after a malformed header. */
+			_framer.send( "error", 0, "Malformed frame header: "_ys.append( header ) );
+			return ( false );
+		}
+		HChunk payload( size );
+		int long got( 0 );
+		while ( got < size ) {
+			int long nRead( cin.read( payload.get<char>() + got, size - got ) );
+			if ( nRead <= 0 ) {
+				return ( false );
+			}
+			got += nRead;
+		}
+		request_._payload.assign( payload.get<char>(), size );
+		return ( true );
+		M_EPILOG
+	}
+	void enqueue( ORequest&& request_ ) {
+		M_PROLOG
+		/* scope for lock */ {
+			HLock l( _mutex );
+			_requests.push_back( yaal::move( request_ ) );
+		}
+		_queued.signal();
+		return;
+		M_EPILOG
+	}
+	HLineRunner::words_t complete( yaal::hcore::HString const& query_ ) {
+		M_PROLOG
+		if ( ! query_.is_empty() && ( query_.front() == '\\'_ycp ) ) {
+			return ( symbolic_completions( query_ ) );
+		}
+		HLock l( _mutex );
+		if ( query_.is_empty() ) {
+			if ( ! _busy ) {
+				_words = _lr.words( false );
+			}
+			return ( _words );
+		}
+		dependent_symbols_t::const_iterator it( _dependentSymbols.find( query_ ) );
+		if ( it != _dependentSymbols.end() ) {
+			return ( it->second );
+		}
+		if ( _busy ) {
+			return ( HLineRunner::words_t() );
+		}
+		return ( _dependentSymbols.insert( make_pair( query_, _lr.dependent_symbols( query_, false ) ) ).first->second );
+		M_EPILOG
+	}
+	void execute_requests( void ) {
+		M_PROLOG
+		HCellOutput& output( static_cast<HCellOutput&>( *_output ) );
+		while ( true ) {
+			_queued.wait();
+			ORequest request;
+			/* scope for lock */ {
+				HLock l( _mutex );
+				request = yaal::move( _requests.front() );
+				_requests.pop_front();
+				_busy = true;
+			}
+			if ( request._type.is_empty() ) {
+				break;
+			}
+			output.set_request( request._id );
+			hcore::HString result;
+			bool ok( true );
+			try {
+				if ( request._type == "meta" ) {
+					ok = meta( _lr, request._payload );
+					if ( ! ok ) {
+						result.assign( "Not a meta command: " ).append( request._payload );
+					}
+				} else {
+					ok = run_cell( _lr, request._payload, result, _retVal );
+				}
+			} catch ( HException const& e ) {
+				ok = false;
+				result = e.what();
+			}
+			cout << flush;
+			output.set_request( 0 );
+			_framer.send( ok ? "result" : "error", request._id, result );
+			HLineRunner::words_t words( _lr.words( false ) );
+			HLock l( _mutex );
+			_words = yaal::move( words );
+			_dependentSymbols.clear();
+			_busy = false;
+		}
+		return;
+		M_EPILOG
+	}
+	HFramedSession( HFramedSession const& ) = delete;
+	HFramedSession& operator = ( HFramedSession const& ) = delete;
+};
+
+int line_session( HLineRunner& lr_ ) {
 	M_PROLOG
-	HLineRunner lr( "*huginn jupyter*" );
 	int retVal( 0 );
 	HString line;
 	HString code;
-	if ( ! setup._noDefaultInit ) {
-		lr.load_session( setup._sessionDir + "/init", false );
-	}
-	lr.load_session( setup._sessionDir + "/" + setup._session, true );
 	while ( getline( cin, line ).good() ) {
 		if ( line.find( "//?" ) == 0 ) {
 			line.shift_left( 3 );
-			char const* symbol( nullptr );
 			if ( ! line.is_empty() && ( line.front() == '\\'_ycp ) ) {
-				symbol = symbol_from_name( line );
-				if ( symbol ) {
-					cout << symbol << endl;
-				} else {
-					symbolic_names_t sn( symbol_name_completions( line ) );
-					for ( yaal::hcore::HString const& n : sn ) {
-						cout << n << endl;
-					}
+				for ( yaal::hcore::HString const& n : symbolic_completions( line ) ) {
+					cout << n << endl;
 				}
 			} else {
-				HLineRunner::words_t const& words( ! line.is_empty() ? lr.dependent_symbols( line, false ) : lr.words( false ) );
+				HLineRunner::words_t const& words( ! line.is_empty() ? lr_.dependent_symbols( line, false ) : lr_.words( false ) );
 				for ( HString const& w : words ) {
 					cout << w << endl;
 				}
 			}
 			cout << "// done" << endl;
-		} else if ( meta( lr, line ) ) {
+		} else if ( meta( lr_, line ) ) {
 			/* Done in meta(). */
 		} else if ( line == "//" ) {
 			if ( code.is_empty() ) {
 				cout << "// ok" << endl;
 				continue;
 			}
-			if ( lr.add_line( code, true ) ) {
-				HHuginn::value_t res( lr.execute() );
-				if ( !! res && lr.use_result() && ( res->type_id() == HHuginn::TYPE::INTEGER ) ) {
-					retVal = static_cast<int>( static_cast<tools::huginn::HInteger*>( res.raw() )->value() );
-				} else {
-					retVal = 0;
-				}
-				if ( !! res ) {
-					if ( lr.use_result() ) {
-						cout << tools::code( res, lr.huginn() ) << endl;
-					}
-					cout << "// ok" << endl;
-				} else {
-					cout << lr.err() << endl;
-					cout << "// error" << endl;
+			HString result;
+			if ( run_cell( lr_, code, result, retVal ) ) {
+				if ( ! result.is_empty() ) {
+					cout << result << endl;
 				}
+				cout << "// ok" << endl;
 			} else {
-				cout << lr.err() << endl;
+				cout << result << endl;
 				cout << "// error" << endl;
 			}
 			code.clear();
@@ -83,6 +408,26 @@ int jupyter_session( void ) {
 			code.append( line );
 		}
 	}
+	return retVal;
+	M_EPILOG
+}
+
+}
+
+int jupyter_session( void ) {
+	M_PROLOG
+	HLineRunner lr( "*huginn jupyter*" );
+	if ( ! setup._noDefaultInit ) {
+		lr.load_session( setup._sessionDir + "/init", false );
+	}
+	lr.load_session( setup._sessionDir + "/" + setup._session, true );
+	int retVal( 0 );
+	if ( setup._framed ) {
+		HFramedSession session( lr );
+		retVal = session.run();
+	} else {
+		retVal = line_session( lr );
+	}
 	filesystem::create_directory( setup._sessionDir, DIRECTORY_MODIFICATION::RECURSIVE );
 	lr.save_session( setup._sessionDir + "/" + setup._session );
 	return retVal;
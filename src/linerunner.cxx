@@ -6,7 +6,6 @@
 #include <yaal/hcore/hclock.hxx>
 #include <yaal/tools/ansi.hxx>
 #include <yaal/tools/signals.hxx>
-#include <yaal/tools/executingparser.hxx>
 #include <yaal/tools/hterminal.hxx>
 #include <yaal/tools/tools.hxx>
 #include <yaal/tools/stringalgo.hxx>
@@ -27,6 +26,7 @@ M_VCSID( "$Id: " __TID__ " $" )
 #	define REPL_print printf
 #endif
 #include "linerunner.hxx"
+#include "grammar.hxx"
 #include "quotes.hxx"
 #include "setup.hxx"
 #include "settings.hxx"
@@ -50,8 +50,16 @@ HLineRunner::HLineRunner( yaal::hcore::HString const& tag_ )
 	, _interrupted( false )
 	, _huginn()
 	, _streamCache()
+	, _preprocessor()
+	, _preprocessorCache()
 	, _description()
 	, _source()
+	, _importsSource()
+	, _definitionsSource()
+	, _linesSource()
+	, _importsSourceCount( 0 )
+	, _definitionsSourceCount( 0 )
+	, _linesSourceCount( 0 )
 	, _locals()
 	, _localsTypes()
 	, _symbolToTypeCache()
@@ -66,6 +74,11 @@ HLineRunner::HLineRunner( yaal::hcore::HString const& tag_ )
 	, _mutex( HMutex::TYPE::RECURSIVE ) {
 	M_PROLOG
 	HHuginn::disable_grammar_verification();
+	/*
+	 * Created here and not in the initializer list,
+	 * so it does not verify the grammar on every runner construction.
+	 */
+	_preprocessor = make_pointer<HHuginn>();
 	reset_session( true );
 	HSignalService::get_instance().register_handler( SIGINT, hcore::call( &HLineRunner::handle_interrupt, this, _1 ) );
 	return;
@@ -119,6 +132,7 @@ void HLineRunner::reset_session( bool full_ ) {
 	_definitions.clear();
 	_imports.clear();
 	_lines.clear();
+	invalidate_source_cache();
 	settingsObserver._maxCallStackSize = _huginnMaxCallStack_;
 	settingsObserver._modulePath = setup._modulePath;
 	return;
@@ -135,10 +149,6 @@ void HLineRunner::save_error_info( void ) {
 }
 
 namespace {
-yaal::hcore::HString first_name( yaal::hcore::HString const& input_ ) {
-	int long nonNameIdx( input_.find_one_of( hcore::HString( character_class<CHARACTER_CLASS::WHITESPACE>().data() ).append( '(' ) ) );
-	return ( input_.substr( 0, nonNameIdx != yaal::hcore::HString::npos ? nonNameIdx : 0 ) );
-}
 static yaal::hcore::HString const _noop_ = "/**/";
 }
 
@@ -157,33 +167,60 @@ void HLineRunner::do_introspect( yaal::tools::HIntrospecteeInterface& introspect
 	M_EPILOG
 }
 
+/*
+ * Tell imports and definitions from plain statements.
+ * Leading keyword (or a name followed by an argument list) selects
+ * the only grammar rule that can possibly match,
+ * so at most one parser runs on each line.
+ */
+HLineRunner::LINE_TYPE HLineRunner::classify( yaal::hcore::HString const& input_ ) {
+	M_PROLOG
+	static hcore::HString const nameEnd( hcore::HString( character_class<CHARACTER_CLASS::WHITESPACE>().data() ).append( '(' ) );
+
+	int long nameEndIdx( input_.find_one_of( nameEnd ) );
+	if ( nameEndIdx == hcore::HString::npos ) {
+		return ( LINE_TYPE::CODE );
+	}
+	hcore::HString name( input_.substr( 0, nameEndIdx ) );
+	LINE_TYPE lineType( LINE_TYPE::CODE );
+	HGrammar& grammar( HGrammar::get_instance() );
+	if ( ( name == "import" ) || ( name == "from" ) ) {
+		_preprocessorCache.reset();
+		_preprocessorCache << input_ << ";";
+		hcore::HString const& statement( _preprocessorCache.string() );
+		if ( grammar.parse( ( name == "import" ) ? "importStatement" : "fromStatement", statement ) ) {
+			lineType = LINE_TYPE::IMPORT;
+		}
+	} else if ( name == "class" ) {
+		lineType = grammar.parse( "classDefinition", input_ ) ? LINE_TYPE::DEFINITION : LINE_TYPE::CODE;
+	} else if ( name == "enum" ) {
+		lineType = grammar.parse( "enumDefinition", input_ ) ? LINE_TYPE::DEFINITION : LINE_TYPE::CODE;
+	} else if ( ! name.is_empty() && ! is_keyword( name ) ) {
+		int long argsIdx( input_.find_other_than( character_class<CHARACTER_CLASS::WHITESPACE>().data(), nameEndIdx ) );
+		if ( ( argsIdx != hcore::HString::npos ) && ( input_[argsIdx] == '(' ) && grammar.parse( "functionDefinition", input_ ) ) {
+			lineType = LINE_TYPE::DEFINITION;
+		}
+	}
+	return ( lineType );
+	M_EPILOG
+}
+
 bool HLineRunner::add_line( yaal::hcore::HString const& line_, bool persist_ ) {
 	M_PROLOG
 	HLock l( _mutex );
 	static char const inactive[] = ";\t \r\n\a\b\f\v";
-	static HHuginn grammarSource;
-	static executing_parser::HRule grammar( grammarSource.make_engine() );
-	static executing_parser::HRuleBase const* importRule( grammar.find( "importStatement" ) );
-	static executing_parser::HRuleBase const* fromRule( grammar.find( "fromStatement" ) );
-	static executing_parser::HRuleBase const* classRule( grammar.find( "classDefinition" ) );
-	static executing_parser::HRuleBase const* enumRule( grammar.find( "enumDefinition" ) );
-	static executing_parser::HRuleBase const* functionRule( grammar.find( "functionDefinition" ) );
-	static HExecutingParser importParser( *importRule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
-	static HExecutingParser fromParser( *fromRule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
-	static HExecutingParser classParser( *classRule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
-	static HExecutingParser enumParser( *enumRule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
-	static HExecutingParser functionParser( *functionRule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
 
 	M_ASSERT( ! line_.is_empty() );
 
 	_lastLineType = LINE_TYPE::NONE;
 
-	HHuginn preprocessor;
-	HStringStream src( line_ );
-	preprocessor.load( src );
-	preprocessor.preprocess();
-	preprocessor.dump_preprocessed_source( src );
-	hcore::HString input( src.string() );
+	_preprocessorCache.str( line_ );
+	_preprocessor->reset();
+	_preprocessor->load( _preprocessorCache );
+	_preprocessor->preprocess();
+	_preprocessorCache.reset();
+	_preprocessor->dump_preprocessed_source( _preprocessorCache );
+	hcore::HString input( _preprocessorCache.string() );
 
 	input.trim_left( inactive );
 	hcore::HString::size_type lastSemiPos( input.find_last( ';'_ycp ) );
@@ -194,8 +231,9 @@ bool HLineRunner::add_line( yaal::hcore::HString const& line_, bool persist_ ) {
 		return ( true );
 	}
 
-	bool isImport( importParser( to_string( input ).append( ";" ) ) || fromParser( to_string( input ).append( ";" ) ) );
-	bool isDefinition( classParser( input ) || enumParser( input ) || ( functionParser( input ) && ! is_keyword( first_name( input ) ) ) );
+	LINE_TYPE lineType( classify( input ) );
+	bool isImport( lineType == LINE_TYPE::IMPORT );
+	bool isDefinition( lineType == LINE_TYPE::DEFINITION );
 
 	addSemi = addSemi || ( ! input.is_empty() && ( input.back() != '}'_ycp ) );
 
@@ -203,27 +241,21 @@ bool HLineRunner::add_line( yaal::hcore::HString const& line_, bool persist_ ) {
 	input.assign( line_ ).trim( inactive );
 	bool addNL( input.find( "//" ) != hcore::HString::npos );
 
+	update_source_cache();
 	_streamCache.reset();
 
-	for ( HEntry const& import : _imports ) {
-		_streamCache << import.data() << "\n";
-	}
+	_streamCache << _importsSource;
 	if ( isImport ) {
 		_streamCache << input << ";\n";
 	}
 	_streamCache << "\n";
 
-	for ( HEntry const& definition : _definitions ) {
-		_streamCache << definition.data() << "\n\n";
-	}
+	_streamCache << _definitionsSource;
 	if ( isDefinition ) {
 		_streamCache << input << "\n\n";
 	}
 
-	_streamCache << "main() {\n";
-	for ( HEntry const& line : _lines ) {
-		_streamCache << '\t' << line.data() << "\n";
-	}
+	_streamCache << "main() {\n" << _linesSource;
 
 	bool gotInput( ! ( isImport || isDefinition || input.is_empty() ) );
 	if ( gotInput ) {
@@ -267,7 +299,9 @@ bool HLineRunner::add_line( yaal::hcore::HString const& line_, bool persist_ ) {
 			_definitions.emplace_back( _lastLine, persist_ );
 			_definitionsLineCount += static_cast<int>( count( _lastLine.cbegin(), _lastLine.cend(), '\n'_ycp ) + 1 );
 		}
-		_description.prepare( *_huginn );
+		if ( isImport || isDefinition || _description.is_stale() ) {
+			_description.prepare( *_huginn );
+		}
 		_symbolToTypeCache.clear();
 	}
 	if ( ! ok ) {
@@ -310,10 +344,44 @@ HHuginn::value_t HLineRunner::do_execute( bool trimCode_ ) {
 	M_EPILOG
 }
 
-HLineRunner::HTimeItResult::HTimeItResult( int count_, yaal::hcore::time::duration_t total_ )
+/*
+ * Compile given line as a body of `main()` of a separate interpreter
+ * that shares only imports and definitions with the session.
+ * Such interpreter can run concurrently with the session one,
+ * e.g. as an additional Huginn stage of a shell pipe.
+ */
+yaal::tools::HHuginn::ptr_t HLineRunner::detached( yaal::hcore::HString const& line_ ) {
+	M_PROLOG
+	HLock l( _mutex );
+	update_source_cache();
+	hcore::HString body( _importsSource );
+	body.append( "\n" ).append( _definitionsSource ).append( "main() {\n\t" ).append( line_ );
+	char const epilogues[][8] = { "\n}\n", ";\n}\n" };
+	HHuginn::ptr_t huginn;
+	bool ok( false );
+	for ( char const* epilogue : epilogues ) {
+		HStringStream src( to_string( body ).append( epilogue ) );
+		huginn = make_pointer<HHuginn>();
+		huginn->load( src, _tag );
+		huginn->preprocess();
+		ok = huginn->parse();
+		if ( ok ) {
+			break;
+		}
+	}
+	ok = ok && huginn->compile( settingsObserver._modulePath, HHuginn::COMPILER::BE_SLOPPY );
+	if ( ! ok ) {
+		throw HRuntimeException( huginn->error_message() );
+	}
+	return ( huginn );
+	M_EPILOG
+}
+
+HLineRunner::HTimeItResult::HTimeItResult( int count_, yaal::hcore::time::duration_t total_, durations_t&& samples_ )
 	: _count( count_ )
 	, _total( total_ )
-	, _iteration( count_ > 0 ? total_ / count_ : time::duration_t( -1 ) ) {
+	, _iteration( count_ > 0 ? total_ / count_ : time::duration_t( -1 ) )
+	, _samples( yaal::move( samples_ ) ) {
 }
 
 HLineRunner::HTimeItResult HLineRunner::timeit( int count_ ) {
@@ -327,15 +395,23 @@ HLineRunner::HTimeItResult HLineRunner::timeit( int count_ ) {
 	int i( 0 );
 	bool ok( true );
 	time::duration_t preciseTime( 0 );
-	while ( ok && ( i < count_ ) ) {
+	durations_t samples;
+	for ( int w( 0 ); ok && ( w < setup._timeitWarmup ); ++ w ) {
 		ok = _huginn->execute();
-		preciseTime += _huginn->execution_time();
-		++ i;
 	}
-	if ( ! ok ) {
-		-- i;
+	i64_t budget( static_cast<i64_t>( setup._timeitBudget ) * 1000000LL );
+	HClock clock;
+	while ( ok && ( ( i < count_ ) || ( clock.get_time_elapsed( time::UNIT::NANOSECOND ) < budget ) ) ) {
+		ok = _huginn->execute();
+		if ( ! ok ) {
+			break;
+		}
+		time::duration_t executionTime( _huginn->execution_time() );
+		preciseTime += executionTime;
+		samples.push_back( executionTime );
+		++ i;
 	}
-	HTimeItResult timeResult( i, preciseTime );
+	HTimeItResult timeResult( i, preciseTime, yaal::move( samples ) );
 	finalize_execute( ok, true, localsOrig, localsTypesOrig, localVarCount, newStatementCount );
 	return timeResult;
 	M_EPILOG
@@ -373,6 +449,7 @@ yaal::tools::HHuginn::value_t HLineRunner::finalize_execute(
 			&& ( _lastLineType == LINE_TYPE::CODE )
 		) {
 			_lines.pop_back();
+			invalidate_source_cache();
 			_lastLineType = LINE_TYPE::TRIMMED_CODE;
 			_huginn->reset( newStatementCount_ );
 		}
@@ -408,10 +485,13 @@ void HLineRunner::undo( void ) {
 		_lines.pop_back();
 	} else if ( _lastLineType == LINE_TYPE::IMPORT ) {
 		_imports.pop_back();
+		_description.invalidate();
 	} else if ( _lastLineType == LINE_TYPE::DEFINITION ) {
 		_definitions.pop_back();
 		_definitionsLineCount -= static_cast<int>( count( _lastLine.cbegin(), _lastLine.cend(), '\n'_ycp ) + 1 );
+		_description.invalidate();
 	}
+	invalidate_source_cache();
 	_lastLineType = LINE_TYPE::NONE;
 	return;
 	M_EPILOG
@@ -422,6 +502,7 @@ void HLineRunner::mend( void ) {
 	if ( ( _lastLineType == LINE_TYPE::NONE ) || ( _lastLineType == LINE_TYPE::TRIMMED_CODE ) ) {
 		add_line( _noop_, false );
 		_lines.pop_back();
+		invalidate_source_cache();
 	}
 	return;
 	M_EPILOG
@@ -540,24 +621,56 @@ yaal::hcore::HString HLineRunner::err( void ) const {
 
 void HLineRunner::prepare_source( void ) {
 	M_PROLOG
+	update_source_cache();
 	_streamCache.reset();
+	_streamCache << _importsSource << "\n" << _definitionsSource << "main() {\n" << _linesSource << "}" << "\n";
+	_source = _streamCache.string();
+	return;
+	M_EPILOG
+}
 
-	for ( HEntry const& import : _imports ) {
-		_streamCache << import.data() << "\n";
+/*
+ * Serialized form of each session section is kept between calls,
+ * so that adding new line only costs serialization of this new line.
+ * Any removal of an entry invalidates the cache and forces full rebuild.
+ *
+ * Only the serialization is incremental, HHuginn cannot compile a statement
+ * into an already compiled program, so add_line() still loads, parses
+ * and compiles the whole session and its cost grows with the session size.
+ */
+void HLineRunner::update_source_cache( void ) {
+	M_PROLOG
+	if (
+		( _importsSourceCount > _imports.get_size() )
+		|| ( _definitionsSourceCount > _definitions.get_size() )
+		|| ( _linesSourceCount > _lines.get_size() )
+	) {
+		invalidate_source_cache();
 	}
-	_streamCache << "\n";
-
-	for ( HEntry const& definition : _definitions ) {
-		_streamCache << definition.data() << "\n\n";
+	for ( int i( _importsSourceCount ), COUNT( static_cast<int>( _imports.get_size() ) ); i < COUNT; ++ i ) {
+		_importsSource.append( _imports[i].data() ).append( "\n" );
 	}
-
-	_streamCache << "main() {\n";
-	for ( HEntry const& line : _lines ) {
-		_streamCache << '\t' << line.data() << "\n";
+	_importsSourceCount = static_cast<int>( _imports.get_size() );
+	for ( int i( _definitionsSourceCount ), COUNT( static_cast<int>( _definitions.get_size() ) ); i < COUNT; ++ i ) {
+		_definitionsSource.append( _definitions[i].data() ).append( "\n\n" );
+	}
+	_definitionsSourceCount = static_cast<int>( _definitions.get_size() );
+	for ( int i( _linesSourceCount ), COUNT( static_cast<int>( _lines.get_size() ) ); i < COUNT; ++ i ) {
+		_linesSource.append( "\t" ).append( _lines[i].data() ).append( "\n" );
 	}
+	_linesSourceCount = static_cast<int>( _lines.get_size() );
+	return;
+	M_EPILOG
+}
 
-	_streamCache << "}" << "\n";
-	_source = _streamCache.string();
+void HLineRunner::invalidate_source_cache( void ) {
+	M_PROLOG
+	_importsSource.clear();
+	_definitionsSource.clear();
+	_linesSource.clear();
+	_importsSourceCount = 0;
+	_definitionsSourceCount = 0;
+	_linesSourceCount = 0;
 	return;
 	M_EPILOG
 }
@@ -901,7 +1014,6 @@ void HLineRunner::save_session( yaal::tools::filesystem::path_t const& path_ ) {
 	add_line( "none;", false );
 	do_execute( false );
 	HFile f( path_, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
-	hcore::HString escaped;
 	if ( !! f ) {
 		f << "// This file was generated automatically, do not edit it!" << endl;
 		for ( rt_settings_t::value_type const& s : rt_settings() ) {
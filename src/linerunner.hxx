@@ -14,6 +14,7 @@
 
 #include "description.hxx"
 #include "reformat.hxx"
+#include "timeit.hxx"
 
 namespace huginn {
 
@@ -43,8 +44,9 @@ public:
 		int _count;
 		yaal::hcore::time::duration_t _total;
 		yaal::hcore::time::duration_t _iteration;
+		durations_t _samples;
 	public:
-		HTimeItResult( int, yaal::hcore::time::duration_t );
+		HTimeItResult( int, yaal::hcore::time::duration_t, durations_t&& );
 		int count( void ) const {
 			return ( _count );
 		}
@@ -54,6 +56,9 @@ public:
 		yaal::hcore::time::duration_t iteration( void ) const {
 			return ( _iteration );
 		}
+		durations_t const& samples( void ) const {
+			return ( _samples );
+		}
 	};
 	typedef yaal::hcore::HArray<HEntry> entries_t;
 	typedef yaal::hcore::HHashMap<yaal::hcore::HString, yaal::tools::huginn::HClass const*> symbol_types_t;
@@ -74,8 +79,16 @@ private:
 	bool _interrupted;
 	yaal::tools::HHuginn::ptr_t _huginn;
 	yaal::tools::HStringStream _streamCache;
+	yaal::tools::HHuginn::ptr_t _preprocessor;
+	yaal::tools::HStringStream _preprocessorCache;
 	HDescription _description;
 	yaal::hcore::HString _source;
+	yaal::hcore::HString _importsSource;
+	yaal::hcore::HString _definitionsSource;
+	yaal::hcore::HString _linesSource;
+	int _importsSourceCount;
+	int _definitionsSourceCount;
+	int _linesSourceCount;
 	yaal::tools::HIntrospecteeInterface::variable_views_t _locals;
 	yaal::tools::huginn::classes_t _localsTypes;
 	symbol_types_t _symbolToTypeCache;
@@ -92,6 +105,7 @@ public:
 	HLineRunner( yaal::hcore::HString const& );
 	bool add_line( yaal::hcore::HString const&, bool );
 	yaal::tools::HHuginn::value_t execute( void );
+	yaal::tools::HHuginn::ptr_t detached( yaal::hcore::HString const& );
 	HTimeItResult timeit( int );
 	yaal::hcore::HString err( void ) const;
 	words_t const& words( bool );
@@ -126,7 +140,10 @@ private:
 	bool amend(  yaal::hcore::HString const& );
 	int handle_interrupt( int );
 	void prepare_source( void );
+	void update_source_cache( void );
+	void invalidate_source_cache( void );
 	void load_session_impl( yaal::tools::filesystem::path_t const&, bool, bool );
+	LINE_TYPE classify( yaal::hcore::HString const& );
 	void reset_session( bool );
 	yaal::tools::huginn::HClass const* symbol_type_id( yaal::tools::HHuginn::value_t const& );
 	void save_error_info( void );
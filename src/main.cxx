@@ -18,6 +18,7 @@ M_VCSID( "$Id: " __ID__ " $" )
 #include "gendocs.hxx"
 #include "reformat.hxx"
 #include "tags.hxx"
+#include "batch.hxx"
 #include "shellscript.hxx"
 
 #include "setup.hxx"
@@ -59,6 +60,8 @@ int main( int argc_, char* argv_[] ) {
 			err = ( !! setup._shell ? ::huginn::oneliner_shell : ::huginn::oneliner )( *setup._program, argc_, argv_ );
 		} else if ( ! setup._genDocs.is_empty() ) {
 			err = ::huginn::gen_docs( argc_, argv_ );
+		} else if ( is_batch( argc_, argv_ ) ) {
+			err = ::huginn::batch( argc_, argv_ );
 		} else if ( setup._reformat ) {
 			HFormatter formatter;
 			err = formatter.reformat_file( argv_[0] ) ? 0 : 1;
@@ -24,6 +24,7 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "commit_id.hxx"
 
 #include "setup.hxx"
+#include "timeit.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -86,6 +87,7 @@ void doc( HRepl* repl_ ) {
 		"**//load** *sess-file*   - load additional session file\n"
 		"**//lsmagic**          - list available magic commands\n"
 		"**//time**[*count*] *code* - measure execution time of given *code* running it *count* times\n"
+		"                       (see *timeit_warmup*, *timeit_budget* and *timeit_format* options)\n"
 		"**//version**          - print engine (yaal library) and runner version\n"
 	;
 	if ( setup._interactive && ! setup._noColor ) {
@@ -261,14 +263,17 @@ void timeit( HLineRunner& lr_, HString&& line_ ) {
 	}
 	if ( timeitResult.count() == 0 ) {
 		/* only show error message */
-	} else if ( count == 1 ) {
+	} else if ( setup._timeitFormat != TIMEIT_FORMAT::TEXT ) {
+		report_timeit_statistics( cout, OTimeItStatistics( timeitResult.samples() ), setup._timeitWarmup, setup._timeitFormat );
+	} else if ( timeitResult.count() == 1 ) {
 		cout << lexical_cast<HString>( timeitResult.total() ) << endl;
-	} else if ( timeitResult.count() > 1 ) {
+	} else {
 		cout
-			<< "repetitions:    " << timeitResult.count() << "\n"
-			<< "iteration time: " << lexical_cast<HString>( timeitResult.iteration() ) << "\n"
-			<< "total time:     " << lexical_cast<HString>( timeitResult.total() )
+			<< "repetitions:      " << timeitResult.count() << "\n"
+			<< "iteration time:   " << lexical_cast<HString>( timeitResult.iteration() ) << "\n"
+			<< "total time:       " << lexical_cast<HString>( timeitResult.total() )
 			<< endl;
+		report_timeit_statistics( cout, OTimeItStatistics( timeitResult.samples() ), setup._timeitWarmup, TIMEIT_FORMAT::TEXT );
 	}
 	return;
 	M_EPILOG
@@ -1,10 +1,23 @@
 /* Read huginn/LICENSE.md file for copyright and licensing information. */
 
+#include <cstring>
+#ifndef __MSVCXX__
+#	include <sys/stat.h>
+#endif
 #include <yaal/tools/hhuginn.hxx>
 #include <yaal/tools/hstringstream.hxx>
+#include <yaal/tools/stringalgo.hxx>
 #include <yaal/hcore/hfile.hxx>
+#include <yaal/hcore/hhashset.hxx>
+#include <yaal/hcore/hthread.hxx>
 #include <yaal/tools/huginn/integer.hxx>
+#include <yaal/tools/huginn/helper.hxx>
+#include <yaal/tools/hfsitem.hxx>
+#include <yaal/tools/hfuture.hxx>
 #include <yaal/hcore/hclock.hxx>
+#include <yaal/hcore/hcore.hxx>
+#include <yaal/tools/hash.hxx>
+#include <yaal/tools/filesystem.hxx>
 M_VCSID( "$Id: " __ID__ " $" )
 M_VCSID( "$Id: " __TID__ " $" )
 #include "oneliner.hxx"
@@ -14,6 +27,9 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "forwardingshell.hxx"
 #include "quotes.hxx"
 #include "timeit.hxx"
+#include "grammar.hxx"
+#include "description.hxx"
+#include "config.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -25,6 +41,51 @@ using namespace yaal::tools::huginn;
 namespace huginn {
 
 namespace {
+
+char const CACHE_PRINT_MARK[] = "//print:";
+char const CACHE_STREAM_MARK[] = " stream:";
+char const STREAM_FUNCTION[] = "__sed__";
+int const STREAM_BLOCK_SIZE = 256 * 1024;
+int const MAX_CACHED_PROGRAMS = 1024;
+char const CACHE_COUNT_FILE[] = ".count";
+char const CACHE_PACKAGES_FILE[] = ".packages";
+
+struct OGeneratedCode {
+	yaal::hcore::HString _code;
+	bool _printResult;
+	bool _streamDriver;
+	OGeneratedCode( void )
+		: _code()
+		, _printResult( true )
+		, _streamDriver( false ) {
+	}
+};
+
+struct OPackage {
+	char const* _name;
+	char const* _alias;
+};
+
+OPackage const DEFAULT_IMPORTS[] = {
+	{ "Mathematics", "math" },
+	{ "Algorithms", "algo" },
+	{ "Operators", "op" },
+	{ "Introspection", "intro" },
+	{ "RegularExpressions", "re" },
+	{ "DateTime", "dt" },
+	{ "OperatingSystem", "os" },
+	{ "Cryptography", "crypto" },
+	{ "Network", "net" },
+	{ "Database", "db" },
+	{ "XML", "xml" },
+	{ "JSON", "json" },
+	{ "YAML", "yaml" },
+	{ "Base64", "base64" },
+	{ "Terminal", "term" }
+};
+
+typedef yaal::hcore::HHashSet<yaal::hcore::HString> identifiers_t;
+
 void import( yaal::hcore::HStreamInterface& source_, yaal::hcore::HString const& package_, yaal::hcore::HString const& alias_ ) {
 	if ( setup._aliasImports ) {
 		source_ << "import " << package_ << " as " << alias_ << ";\n";
@@ -32,17 +93,725 @@ void import( yaal::hcore::HStreamInterface& source_, yaal::hcore::HString const&
 		source_ << "from " << package_ << " import *;\n";
 	}
 }
+
+identifiers_t identifiers( yaal::hcore::HString const& program_ ) {
+	M_PROLOG
+	identifiers_t ids;
+	hcore::HString word( character_class<CHARACTER_CLASS::WORD>().data() );
+	int long pos( program_.find_one_of( word ) );
+	while ( pos != hcore::HString::npos ) {
+		int long end( program_.find_other_than( word, pos ) );
+		ids.insert( program_.substr( pos, end != hcore::HString::npos ? end - pos : hcore::HString::npos ) );
+		if ( end == hcore::HString::npos ) {
+			break;
+		}
+		pos = program_.find_one_of( word, end );
+	}
+	return ( ids );
+	M_EPILOG
 }
 
-int oneliner( yaal::hcore::HString const& program_, int argc_, char** argv_ ) {
+typedef yaal::hcore::HHashMap<yaal::hcore::HString, identifiers_t> package_members_t;
+
+/*
+ * Names exported by each default package, keyed by package alias.
+ * Taken from VM state of an interpreter that does nothing but import the packages,
+ * the program itself is never compiled for this.
+ */
+package_members_t build_package_members( void ) {
 	M_PROLOG
-	HHuginn::disable_grammar_verification();
+	HStringStream src;
+	src << "import FileSystem as fs;\nimport Text as text;\n";
+	for ( OPackage const& package : DEFAULT_IMPORTS ) {
+		src << "import " << package._name << " as " << package._alias << ";\n";
+	}
+	src << "main() {\n}\n";
+	HHuginn h;
+	h.load( src );
+	h.preprocess();
+	package_members_t members;
+	if ( ! ( h.parse() && h.compile( HHuginn::COMPILER::BE_SLOPPY ) ) ) {
+		return ( members );
+	}
+	HDescription description;
+	description.prepare( h );
+	auto add = [&members, &description]( char const* name_, char const* alias_ ) {
+		identifiers_t& names( members[alias_] );
+		for ( hcore::HString const& name : description.members( name_ ) ) {
+			names.insert( name );
+		}
+	};
+	add( "FileSystem", "fs" );
+	add( "Text", "text" );
+	for ( OPackage const& package : DEFAULT_IMPORTS ) {
+		add( package._name, package._alias );
+	}
+	return ( members );
+	M_EPILOG
+}
 
-	static HHuginn grammarSource;
-	static executing_parser::HRule grammar( grammarSource.make_engine() );
-	static executing_parser::HRuleBase const* expressionRule( grammar.find( "expression" ) );
-	static HExecutingParser expressionParser( *expressionRule, HExecutingParser::INIT_MODE::TRUST_GRAMMAR );
+/*
+ * Package members only change with huginn or yaal version,
+ * so the table is built once and kept in the session cache directory,
+ * one line per package: alias followed by its member names.
+ */
+package_members_t package_members( void ) {
+	M_PROLOG
+	hcore::HString version( PACKAGE_STRING " " );
+	version.append( yaal_version( true ) );
+	hcore::HString path( ! setup._sessionDir.is_empty() ? setup._sessionDir + "/cache/" + CACHE_PACKAGES_FILE : hcore::HString() );
+	package_members_t members;
+	try {
+		if ( ! path.is_empty() && filesystem::exists( path ) ) {
+			HFile f( path, HFile::OPEN::READING );
+			hcore::HString line;
+			if ( !! f && ( f.read_line( line ) >= 0 ) && ( line == version ) ) {
+				while ( f.read_line( line ) >= 0 ) {
+					string::tokens_t tokens( string::split<string::tokens_t>( line, " ", HTokenizer::SKIP_EMPTY ) );
+					if ( tokens.is_empty() ) {
+						continue;
+					}
+					identifiers_t& names( members[tokens.front()] );
+					for ( int long i( 1 ), count( tokens.get_size() ); i < count; ++ i ) {
+						names.insert( tokens[i] );
+					}
+				}
+				if ( ! members.is_empty() ) {
+					return ( members );
+				}
+			}
+		}
+	} catch ( HException const& ) {
+		members.clear();
+	}
+	members = build_package_members();
+	if ( path.is_empty() || members.is_empty() ) {
+		return ( members );
+	}
+	try {
+		filesystem::create_directory( setup._sessionDir + "/cache", DIRECTORY_MODIFICATION::RECURSIVE );
+		hcore::HString tmpPath( path );
+		tmpPath.append( "." ).append( hcore::HString( static_cast<int long long>( system::getpid() ) ) );
+		HFile f( tmpPath, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
+		if ( ! f ) {
+			return ( members );
+		}
+		f << version << "\n";
+		for ( package_members_t::value_type const& package : members ) {
+			f << package.first;
+			for ( hcore::HString const& name : package.second ) {
+				f << " " << name;
+			}
+			f << "\n";
+		}
+		f.close();
+		filesystem::rename( tmpPath, path );
+	} catch ( HException const& ) {
+		/* Table is only an optimization, failing to write it is not an error. */
+	}
+	return ( members );
+	M_EPILOG
+}
+
+/*
+ * Import only those default packages that given program can actually reference.
+ * With aliased imports a package is referenced by its alias,
+ * with star imports by any of the names it exports.
+ */
+hcore::HString default_imports( yaal::hcore::HString const& program_, int argc_ ) {
+	M_PROLOG
+	bool defaults( ! setup._noDefaultImports );
+	identifiers_t referenced( defaults ? identifiers( program_ ) : identifiers_t() );
+	package_members_t members( defaults && ! setup._aliasImports ? package_members() : package_members_t() );
+	/* Without the member table nothing can be matched, keep every default import then. */
+	bool all( defaults && ! setup._aliasImports && members.is_empty() );
+	auto wanted = [&defaults, &all, &referenced, &members]( char const* alias_ ) {
+		if ( ! defaults ) {
+			return ( false );
+		}
+		if ( all || ( setup._aliasImports && ( referenced.count( alias_ ) > 0 ) ) ) {
+			return ( true );
+		}
+		for ( hcore::HString const& name : members[alias_] ) {
+			if ( referenced.count( name ) > 0 ) {
+				return ( true );
+			}
+		}
+		return ( false );
+	};
+	HStringStream ss;
+	if ( wanted( "fs" ) || ( setup._streamEditor && ( argc_ > 0 ) ) ) {
+		import( ss, "FileSystem", "fs" );
+	}
+	if ( wanted( "text" ) || setup._autoSplit ) {
+		import( ss, "Text", "text" );
+	}
+	if ( defaults ) {
+		for ( OPackage const& package : DEFAULT_IMPORTS ) {
+			if ( wanted( package._alias ) ) {
+				import( ss, package._name, package._alias );
+			}
+		}
+		ss << "\n";
+	}
+	return ( ss.string() );
+	M_EPILOG
+}
 
+/*
+ * Stream editor output collected between flushes,
+ * its size is known without looking at the data.
+ */
+class HOutputBuffer : public yaal::hcore::HStreamInterface {
+	yaal::hcore::HArray<char> _data;
+public:
+	HOutputBuffer( void )
+		: _data() {
+	}
+	int long size( void ) const {
+		return ( _data.get_size() );
+	}
+	void flush_to( HStreamInterface& out_ ) {
+		M_PROLOG
+		if ( ! _data.is_empty() ) {
+			out_.write( _data.data(), _data.get_size() );
+		}
+		out_.flush();
+		_data.clear();
+		return;
+		M_EPILOG
+	}
+private:
+	virtual int long do_write( void const* data_, int long size_ ) override {
+		M_PROLOG
+		char const* data( static_cast<char const*>( data_ ) );
+		_data.insert( _data.end(), data, data + size_ );
+		return ( size_ );
+		M_EPILOG
+	}
+	virtual void do_flush( void ) override {
+	}
+	virtual int long do_read( void*, int long ) override {
+		return ( -1 );
+	}
+	virtual bool do_is_valid( void ) const override {
+		return ( true );
+	}
+	virtual POLL_TYPE do_poll_type( void ) const override {
+		return ( POLL_TYPE::EMULATED );
+	}
+	virtual void const* do_data( void ) const override {
+		return ( this );
+	}
+};
+
+/*
+ * Stream editor driven natively: input is read in large blocks and split into lines here,
+ * each line is passed to generated `__sed__()` function and its results are batched
+ * in an output buffer that is flushed only when it grows past the block size.
+ */
+class HStreamEditor {
+	HHuginn& _huginn;
+	HStreamInterface& _userOutput;
+	HHuginn::values_t _args;
+	HChunk _block;
+	int long _blockSize;
+	hcore::HString _line;
+	HOutputBuffer _output;
+	int long long _lineNo;
+public:
+	HStreamEditor( HHuginn& huginn_, HStreamInterface& userOutput_ )
+		: _huginn( huginn_ )
+		, _userOutput( userOutput_ )
+		, _args()
+		, _block()
+		, _blockSize( STREAM_BLOCK_SIZE )
+		, _line()
+		, _output()
+		, _lineNo( 0 ) {
+		_block.realloc( _blockSize, HChunk::STRATEGY::EXACT );
+	}
+	~HStreamEditor( void ) {
+		_huginn.set_output_stream( cout );
+	}
+	bool start( int argc_ ) {
+		M_PROLOG
+		bool ok( _huginn.execute() );
+		_args.resize( argc_ > 0 ? 3 : 2 );
+		_huginn.set_output_stream( setup._inplace ? _userOutput : _output );
+		return ( ok );
+		M_EPILOG
+	}
+	bool run( int argc_, char** argv_ ) {
+		M_PROLOG
+		bool ok( start( argc_ ) );
+		if ( ok && ( argc_ == 0 ) ) {
+			ok = filter( cin, cout );
+		}
+		hcore::HString tmpExt( temporary_extension() );
+		for ( int i( 0 ); ok && ( i < argc_ ); ++ i ) {
+			ok = edit_file( argv_[i], tmpExt );
+		}
+		return ( ok );
+		M_EPILOG
+	}
+	bool edit_file( yaal::hcore::HString const& path_, yaal::hcore::HString const& tmpExt_ ) {
+		M_PROLOG
+		_args[2] = _huginn.value( path_ );
+		HFile in( path_, HFile::OPEN::READING );
+		if ( ! in ) {
+			throw HRuntimeException( "Cannot open `"_ys.append( path_ ).append( "` for reading: " ).append( in.get_error() ) );
+		}
+		if ( ! setup._inplace ) {
+			return ( filter( in, cout ) );
+		}
+		hcore::HString outName( path_ );
+		outName.append( "-" ).append( tmpExt_ );
+		HFile out( outName, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
+		if ( ! out ) {
+			throw HRuntimeException( "Cannot open `"_ys.append( outName ).append( "` for writing: " ).append( out.get_error() ) );
+		}
+		filesystem::chmod( outName, HFSItem( path_ ).get_permissions() );
+		bool ok( filter( in, out ) );
+		out.close();
+		in.close();
+		if ( ! ok ) {
+			filesystem::remove( outName );
+			return ( false );
+		}
+		if ( ! setup._inplace->is_empty() ) {
+			filesystem::rename( path_, path_ + *setup._inplace );
+		}
+		filesystem::rename( outName, path_ );
+		return ( true );
+		M_EPILOG
+	}
+	static hcore::HString temporary_extension( void ) {
+		distribution::HDiscrete rnd( rng_helper::make_random_number_generator() );
+		return ( hcore::HString( static_cast<int long long>( rnd() ) ) );
+	}
+private:
+	bool filter( HStreamInterface& in_, HStreamInterface& out_ ) {
+		M_PROLOG
+		_lineNo = 0;
+		int long filled( 0 );
+		bool ok( true );
+		bool eof( false );
+		while ( ok && ! eof ) {
+			if ( filled == _blockSize ) {
+				_blockSize *= 2;
+				_block.realloc( _blockSize, HChunk::STRATEGY::EXACT );
+			}
+			char* data( _block.get<char>() );
+			int long nRead( in_.read( data + filled, _blockSize - filled ) );
+			eof = nRead <= 0;
+			if ( ! eof ) {
+				filled += nRead;
+			}
+			int long start( 0 );
+			while ( ok && ( start < filled ) ) {
+				char const* nl( static_cast<char const*>( ::memchr( data + start, '\n', static_cast<size_t>( filled - start ) ) ) );
+				if ( ! ( nl || eof ) ) {
+					break;
+				}
+				int long end( nl ? ( nl - data ) + 1 : filled );
+				ok = line( data + start, end - start );
+				start = end;
+				/* Counts `print` output of user code too, not only returned lines. */
+				if ( _output.size() >= STREAM_BLOCK_SIZE ) {
+					flush( out_ );
+				}
+			}
+			filled -= start;
+			::memmove( data, data + start, static_cast<size_t>( filled ) );
+		}
+		flush( out_ );
+		return ( ok );
+		M_EPILOG
+	}
+	bool line( char const* data_, int long size_ ) {
+		M_PROLOG
+		_line.assign( data_, size_ );
+		if ( setup._chomp ) {
+			_line.trim_right( "\r\n" );
+		}
+		++ _lineNo;
+		_args[0] = _huginn.value( _line );
+		_args[1] = _huginn.value( _lineNo );
+		HHuginn::value_t result( _huginn.call( STREAM_FUNCTION, _args ) );
+		if ( ! result ) {
+			return ( false );
+		}
+		if ( ! setup._quiet ) {
+			if ( result->type_id() == HHuginn::TYPE::STRING ) {
+				hcore::HString const& s( get_string( result ) );
+				_output << s << "\n";
+			} else {
+				hcore::HString s( to_string( result, &_huginn ) );
+				_output << s << "\n";
+			}
+		}
+		return ( true );
+		M_EPILOG
+	}
+	void flush( HStreamInterface& out_ ) {
+		M_PROLOG
+		_output.flush_to( out_ );
+		return;
+		M_EPILOG
+	}
+};
+
+/*
+ * In-place stream editor spreading file arguments over `--jobs` workers,
+ * each worker owns separate interpreter compiled from the same generated code.
+ * Output of user program and error messages are collected per file
+ * and reported in order of file arguments once all workers finish.
+ */
+class HParallelStreamEditor {
+	struct OFileResult {
+		bool _done;
+		bool _ok;
+		hcore::HString _output;
+		hcore::HString _error;
+		OFileResult( void )
+			: _done( false )
+			, _ok( true )
+			, _output()
+			, _error() {
+		}
+	};
+	typedef yaal::hcore::HArray<OFileResult> results_t;
+	typedef yaal::tools::HFuture<bool> future_t;
+	typedef yaal::hcore::HResource<future_t> promise_t;
+	typedef yaal::hcore::HArray<promise_t> promises_t;
+	hcore::HString const& _code;
+	int _argc;
+	char** _argv;
+	hcore::HString _tmpExt;
+	results_t _results;
+	int _next;
+	bool _failed;
+	hcore::HString _errorMessage;
+	HMutex _mutex;
+public:
+	HParallelStreamEditor( yaal::hcore::HString const& code_, int argc_, char** argv_ )
+		: _code( code_ )
+		, _argc( argc_ )
+		, _argv( argv_ )
+		, _tmpExt( HStreamEditor::temporary_extension() )
+		, _results( argc_ )
+		, _next( 0 )
+		, _failed( false )
+		, _errorMessage()
+		, _mutex() {
+	}
+	bool run( void ) {
+		M_PROLOG
+		promises_t promises;
+		for ( int i( 0 ), jobs( min( setup._jobs, _argc ) ); i < jobs; ++ i ) {
+			promises.push_back( make_resource<future_t>( call( &HParallelStreamEditor::work, this ), HWorkFlow::SCHEDULE_POLICY::EAGER ) );
+		}
+		for ( promise_t& promise : promises ) {
+			promise->get();
+		}
+		bool ok( ! _failed );
+		for ( OFileResult const& result : _results ) {
+			if ( ! result._done ) {
+				continue;
+			}
+			cout << result._output;
+			if ( ! result._ok ) {
+				_errorMessage.append( result._error ).append( "\n" );
+			}
+		}
+		_errorMessage.trim_right( "\n" );
+		return ( ok );
+		M_EPILOG
+	}
+	yaal::hcore::HString const& error_message( void ) const {
+		return ( _errorMessage );
+	}
+private:
+	bool work( void ) {
+		M_PROLOG
+		HHuginn h;
+		for ( int i( 0 ); i < _argc; ++ i ) {
+			h.add_argument( _argv[i] );
+		}
+		HStringStream src( _code );
+		h.load( src );
+		h.preprocess();
+		HStringStream output;
+		HStreamEditor streamEditor( h, output );
+		if ( ! ( h.parse() && h.compile( HHuginn::COMPILER::BE_SLOPPY ) && streamEditor.start( _argc ) ) ) {
+			HLock l( _mutex );
+			_failed = true;
+			_errorMessage.append( h.error_message() ).append( "\n" );
+			return ( false );
+		}
+		while ( true ) {
+			int idx( 0 );
+			/* scope for lock */ {
+				HLock l( _mutex );
+				if ( _failed || ( _next >= _argc ) ) {
+					break;
+				}
+				idx = _next;
+				++ _next;
+			}
+			OFileResult& result( _results[idx] );
+			try {
+				result._ok = streamEditor.edit_file( _argv[idx], _tmpExt );
+				if ( ! result._ok ) {
+					result._error = h.error_message();
+				}
+			} catch ( HException const& e ) {
+				result._ok = false;
+				result._error = e.what();
+			}
+			result._output = output.string();
+			output.reset();
+			result._done = true;
+			if ( ! result._ok ) {
+				HLock l( _mutex );
+				_failed = true;
+			}
+		}
+		return ( true );
+		M_EPILOG
+	}
+};
+
+/*
+ * Names of modules imported by the program, `import a.b` gives `a/b`.
+ */
+identifiers_t imported_modules( yaal::hcore::HString const& program_ ) {
+	M_PROLOG
+	identifiers_t modules;
+	hcore::HString name( character_class<CHARACTER_CLASS::WORD>().data() );
+	name.append( "." );
+	for ( char const* keyword : { "import", "from" } ) {
+		for ( int long pos( program_.find( keyword ) ); pos != hcore::HString::npos; pos = program_.find( keyword, pos + 1 ) ) {
+			int long start( program_.find_other_than( character_class<CHARACTER_CLASS::WHITESPACE>().data(), pos + static_cast<int long>( ::strlen( keyword ) ) ) );
+			if ( start == hcore::HString::npos ) {
+				break;
+			}
+			int long end( program_.find_other_than( name, start ) );
+			hcore::HString module( program_.substr( start, end != hcore::HString::npos ? end - start : hcore::HString::npos ) );
+			if ( ! module.is_empty() ) {
+				module.replace( ".", "/" );
+				modules.insert( module );
+			}
+		}
+	}
+	return ( modules );
+	M_EPILOG
+}
+
+/*
+ * State of a module file as `<size> <modification time in ns>`,
+ * or an empty string if there is no such file.
+ */
+hcore::HString file_stamp( yaal::hcore::HString const& path_ ) {
+	M_PROLOG
+	hcore::HString stamp;
+#ifndef __MSVCXX__
+	HUTF8String utf8( path_ );
+	struct stat s;
+	if ( ( ::stat( utf8.c_str(), &s ) != 0 ) || ! S_ISREG( s.st_mode ) ) {
+		return ( stamp );
+	}
+	i64_t const NS( 1000000000LL );
+#	ifdef __HOST_OS_TYPE_DARWIN__
+	i64_t modified( static_cast<i64_t>( s.st_mtimespec.tv_sec ) * NS + s.st_mtimespec.tv_nsec );
+#	else
+	i64_t modified( static_cast<i64_t>( s.st_mtim.tv_sec ) * NS + s.st_mtim.tv_nsec );
+#	endif
+	stamp.append( static_cast<int long long>( s.st_size ) ).append( " " ).append( static_cast<int long long>( modified ) );
+#else
+	if ( ! filesystem::exists( path_ ) ) {
+		return ( stamp );
+	}
+	HFSItem fsItem( path_ );
+	if ( fsItem.is_directory() ) {
+		return ( stamp );
+	}
+	stamp.append( static_cast<int long long>( fsItem.get_size() ) ).append( " " ).append( static_cast<int long long>( fsItem.modified().raw() ) );
+#endif
+	return ( stamp );
+	M_EPILOG
+}
+
+/*
+ * Resolve every module the program imports, directly or through other modules,
+ * the same way the interpreter does (first match on the search path wins),
+ * and add state of each resolved file to the cache key.
+ */
+void stamp_modules( HStreamInterface& key_, yaal::hcore::HString const& program_ ) {
+	M_PROLOG
+	HHuginn::paths_t paths( 1, "." );
+	paths.insert( paths.end(), HHuginn::MODULE_PATHS.begin(), HHuginn::MODULE_PATHS.end() );
+	paths.insert( paths.end(), setup._modulePath.begin(), setup._modulePath.end() );
+	identifiers_t visited;
+	HArray<hcore::HString> pending;
+	for ( hcore::HString const& module : imported_modules( program_ ) ) {
+		pending.push_back( module );
+	}
+	hcore::HString line;
+	while ( ! pending.is_empty() ) {
+		hcore::HString module( yaal::move( pending.back() ) );
+		pending.pop_back();
+		if ( ! visited.insert( module ).second ) {
+			continue;
+		}
+		for ( hcore::HString const& dir : paths ) {
+			hcore::HString modulePath( dir );
+			modulePath.append( "/" ).append( module ).append( ".hgn" );
+			hcore::HString stamp( file_stamp( modulePath ) );
+			if ( stamp.is_empty() ) {
+				continue;
+			}
+			key_ << modulePath << " " << stamp << "\n";
+			HFile f( modulePath, HFile::OPEN::READING );
+			HStringStream source;
+			while ( !! f && ( f.read_line( line ) >= 0 ) ) {
+				source << line << "\n";
+			}
+			for ( hcore::HString const& imported : imported_modules( source.string() ) ) {
+				if ( visited.count( imported ) == 0 ) {
+					pending.push_back( imported );
+				}
+			}
+			break;
+		}
+	}
+	return;
+	M_EPILOG
+}
+
+/*
+ * Cache key covers everything generated code depends on: the program, the options,
+ * the module search path and the state of every module file the program imports.
+ */
+hcore::HString code_cache_path( yaal::hcore::HString const& program_, int argc_ ) {
+	M_PROLOG
+	if ( setup._noCache || !! setup._inplace || setup._sessionDir.is_empty() ) {
+		return ( hcore::HString() );
+	}
+	HStringStream key;
+	key
+		<< PACKAGE_STRING << "\n"
+		<< setup._noDefaultImports << setup._streamEditor << setup._quiet << setup._chomp
+		<< setup._autoSplit << setup._aliasImports << ( argc_ > 0 ) << "\n"
+		<< setup._fieldSeparator << "\n"
+		<< string::join( setup._modulePath, ":" ) << "\n"
+		<< program_ << "\n";
+	stamp_modules( key, program_ );
+	return ( setup._sessionDir + "/cache/" + tools::hash::sha1( key.string() ) );
+	M_EPILOG
+}
+
+/*
+ * Keep the cache directory bounded, least recently generated programs go first.
+ * Number of cached programs is kept in a counter file,
+ * so the directory is only listed when the limit has been crossed.
+ */
+void prune_code_cache( void ) {
+	M_PROLOG
+	typedef yaal::hcore::HPair<i64_t, hcore::HString> entry_t;
+	typedef yaal::hcore::HArray<entry_t> entries_t;
+	hcore::HString cacheDir( setup._sessionDir + "/cache" );
+	hcore::HString countPath( cacheDir + "/" + CACHE_COUNT_FILE );
+	int long count( 0 );
+	if ( filesystem::exists( countPath ) ) {
+		HFile f( countPath, HFile::OPEN::READING );
+		hcore::HString line;
+		if ( !! f && ( f.read_line( line ) >= 0 ) ) {
+			count = lexical_cast<int long>( line );
+		}
+	}
+	++ count;
+	if ( count > MAX_CACHED_PROGRAMS ) {
+		entries_t entries;
+		HFSItem dir( cacheDir );
+		for ( HFSItem const& f : dir ) {
+			if ( f.is_directory() || ( f.get_name() == CACHE_COUNT_FILE ) || ( f.get_name() == CACHE_PACKAGES_FILE ) ) {
+				continue;
+			}
+			entries.push_back( make_pair( f.modified().raw(), cacheDir + "/" + f.get_name() ) );
+		}
+		count = entries.get_size();
+		if ( count > MAX_CACHED_PROGRAMS ) {
+			sort( entries.begin(), entries.end() );
+			for ( int long i( 0 ), excess( count - MAX_CACHED_PROGRAMS ); i < excess; ++ i ) {
+				filesystem::remove( entries[i].second );
+			}
+			count = MAX_CACHED_PROGRAMS;
+		}
+	}
+	HFile f( countPath, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
+	if ( !! f ) {
+		f << count << "\n";
+	}
+	return;
+	M_EPILOG
+}
+
+bool load_cached_code( yaal::hcore::HString const& path_, OGeneratedCode& generated_ ) {
+	M_PROLOG
+	if ( path_.is_empty() || ! filesystem::exists( path_ ) ) {
+		return ( false );
+	}
+	HFile f( path_, HFile::OPEN::READING );
+	if ( ! f ) {
+		return ( false );
+	}
+	hcore::HString line;
+	if ( ( f.read_line( line ) < 0 ) || ( line.find( CACHE_PRINT_MARK ) != 0 ) ) {
+		return ( false );
+	}
+	int long streamMark( line.find( CACHE_STREAM_MARK ) );
+	generated_._printResult = line[static_cast<int>( sizeof ( CACHE_PRINT_MARK ) ) - 1] == '1';
+	generated_._streamDriver = ( streamMark != hcore::HString::npos ) && ( line[streamMark + static_cast<int>( sizeof ( CACHE_STREAM_MARK ) ) - 1] == '1' );
+	HStringStream ss;
+	while ( f.read_line( line ) >= 0 ) {
+		ss << line << "\n";
+	}
+	generated_._code.assign( ss.string() );
+	return ( ! generated_._code.is_empty() );
+	M_EPILOG
+}
+
+void save_cached_code( yaal::hcore::HString const& path_, OGeneratedCode const& generated_ ) {
+	M_PROLOG
+	if ( path_.is_empty() ) {
+		return;
+	}
+	try {
+		filesystem::create_directory( setup._sessionDir + "/cache", DIRECTORY_MODIFICATION::RECURSIVE );
+		hcore::HString tmpPath( path_ );
+		tmpPath.append( "." ).append( hcore::HString( static_cast<int long long>( system::getpid() ) ) );
+		HFile f( tmpPath, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
+		if ( ! f ) {
+			return;
+		}
+		f
+			<< CACHE_PRINT_MARK << ( generated_._printResult ? 1 : 0 )
+			<< CACHE_STREAM_MARK << ( generated_._streamDriver ? 1 : 0 ) << "\n"
+			<< generated_._code;
+		f.close();
+		filesystem::rename( tmpPath, path_ );
+		prune_code_cache();
+	} catch ( HException const& ) {
+		/* Cache is only an optimization, failing to write it is not an error. */
+	}
+	return;
+	M_EPILOG
+}
+
+OGeneratedCode generate_code( yaal::hcore::HString const& program_, int argc_ ) {
+	M_PROLOG
 	hcore::HString program( program_ );
 
 	HHuginn preprocessor;
@@ -52,43 +821,43 @@ int oneliner( yaal::hcore::HString const& program_, int argc_, char** argv_ ) {
 	preprocessor.dump_preprocessed_source( src );
 	program.assign( src.string() );
 
+	OGeneratedCode generated;
 	program.trim_right( character_class<CHARACTER_CLASS::WHITESPACE>().data() );
-	bool printOutLastExpressionResultValue( true );
 	while ( ! program.is_empty() && ( program.back() == ';' ) ) {
-		printOutLastExpressionResultValue = false;
+		generated._printResult = false;
 		program.pop_back();
 		program.trim_right( character_class<CHARACTER_CLASS::WHITESPACE>().data() );
 	}
 
-	bool isExpression( expressionParser( program ) );
+	bool isExpression( HGrammar::get_instance().parse( "expression", program ) );
 
 	HStringStream ss;
-	hcore::HString code;
 
-	if ( ! setup._noDefaultImports || ( setup._streamEditor && ( argc_ > 0 ) ) ) {
-		import( ss, "FileSystem", "fs" );
-	}
-	if ( ! setup._noDefaultImports || setup._autoSplit ) {
-		import( ss, "Text", "text" );
+	if ( setup._autoSplit ) {
 		util::escape( setup._fieldSeparator, cxx_escape_table() );
 	}
-	if ( ! setup._noDefaultImports ) {
-		import( ss, "Mathematics", "math" );
-		import( ss, "Algorithms", "algo" );
-		import( ss, "Operators", "op" );
-		import( ss, "Introspection", "intro" );
-		import( ss, "RegularExpressions", "re" );
-		import( ss, "DateTime", "dt" );
-		import( ss, "OperatingSystem", "os" );
-		import( ss, "Cryptography", "crypto" );
-		import( ss, "Network", "net" );
-		import( ss, "Database", "db" );
-		import( ss, "XML", "xml" );
-		import( ss, "JSON", "json" );
-		import( ss, "YAML", "yaml" );
-		import( ss, "Base64", "base64" );
-		import( ss, "Terminal", "term" );
-		ss << "\n";
+	hcore::HString text( setup._aliasImports ? "text." : "" );
+	/*
+	 * Function form cannot host programs that steer the generated read loop,
+	 * those keep the loop code.
+	 */
+	identifiers_t ids( identifiers( program ) );
+	if ( setup._streamEditor && ( ids.count( "continue" ) == 0 ) && ( ids.count( "break" ) == 0 ) ) {
+		ss << STREAM_FUNCTION << "( _, __" << ( argc_ > 0 ? ", __arg__" : "" ) << " ) {\n\t";
+		if ( setup._autoSplit ) {
+			ss << "F = " << text << "split( _, \"" << setup._fieldSeparator << "\" );\n\t";
+		}
+		if ( isExpression ) {
+			ss << "_ = ";
+		}
+		ss << program;
+		if ( ! program.is_empty() && ( program.back() != '}' ) ) {
+			ss << ";";
+		}
+		ss << "\n\treturn ( _ );\n}\n\n" << ( argc_ > 0 ? "main( argv_ )" : "main()" ) << " {\n\treturn ( 0 );\n}\n";
+		generated._code = default_imports( program, argc_ ) + ss.string();
+		generated._streamDriver = true;
+		return ( generated );
 	}
 	if ( argc_ > 0 ) {
 		ss << "main( argv_ ) {\n\t";
@@ -99,7 +868,6 @@ int oneliner( yaal::hcore::HString const& program_, int argc_, char** argv_ ) {
 	distribution::HDiscrete rnd( rng_helper::make_random_number_generator() );
 	hcore::HString tmpExt( static_cast<int long long>( rnd() ) );
 	hcore::HString fs( setup._aliasImports ? "fs." : "" );
-	hcore::HString text( setup._aliasImports ? "text." : "" );
 	if ( setup._streamEditor ) {
 		if ( argc_ > 0 ) {
 			ss << "for ( __arg__ : argv_ ) {\n\t\t__in__ = " << fs << "open( __arg__, " << fs << "OPEN_MODE.READ );\n\t\t";
@@ -147,50 +915,98 @@ int oneliner( yaal::hcore::HString const& program_, int argc_, char** argv_ ) {
 		ss << "\n\t}";
 	}
 	ss << "\n}\n";
-	code = ss.string();
+	generated._code = default_imports( program, argc_ ) + ss.string();
+	return ( generated );
+	M_EPILOG
+}
+
+}
+
+int oneliner( yaal::hcore::HString const& program_, int argc_, char** argv_ ) {
+	M_PROLOG
+	HHuginn::disable_grammar_verification();
 	HClock c;
+	hcore::HString cachePath( code_cache_path( program_, argc_ ) );
+	OGeneratedCode generated;
+	CODE_CACHE codeCache( CODE_CACHE::NONE );
+	if ( load_cached_code( cachePath, generated ) ) {
+		codeCache = CODE_CACHE::HIT;
+	} else {
+		generated = generate_code( program_, argc_ );
+		if ( ! cachePath.is_empty() ) {
+			save_cached_code( cachePath, generated );
+			codeCache = CODE_CACHE::MISS;
+		}
+	}
+	hcore::HString const& code( generated._code );
+	time::duration_t codegen( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+	c.reset();
 	HHuginn h;
 	time::duration_t huginn( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
 
-	for ( int i( 0 ); i < argc_; ++ i ) {
-		h.add_argument( argv_[i] );
-	}
-	c.reset();
-	h.load( ss );
-	time::duration_t load( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
-	c.reset();
-	h.preprocess();
-	time::duration_t preprocess( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+	/* Parallel stream editor compiles its own program in every worker. */
+	bool parallel( generated._streamDriver && ( setup._jobs > 1 ) && ( argc_ > 1 ) );
+	time::duration_t load( 0 );
+	time::duration_t preprocess( 0 );
+	time::duration_t parse( 0 );
+	time::duration_t compile( 0 );
 	int retVal( 0 );
-	c.reset();
-	bool ok( h.parse() );
-	time::duration_t parse( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
-	c.reset();
-	ok = ok && h.compile( HHuginn::COMPILER::BE_SLOPPY );
-	time::duration_t compile( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+	bool ok( true );
+	if ( ! parallel ) {
+		for ( int i( 0 ); i < argc_; ++ i ) {
+			h.add_argument( argv_[i] );
+		}
+		c.reset();
+		HStringStream src( code );
+		h.load( src );
+		load = time::duration_t( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+		c.reset();
+		h.preprocess();
+		preprocess = time::duration_t( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+		c.reset();
+		ok = h.parse();
+		parse = time::duration_t( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+		c.reset();
+		ok = ok && h.compile( HHuginn::COMPILER::BE_SLOPPY );
+		compile = time::duration_t( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
+	}
 
 	c.reset();
 	time::duration_t preciseTime( 0 );
 	int runs( 0 );
-	ok = ok && timeit( h, preciseTime, runs );
+	durations_t samples;
+	hcore::HString errorMessage;
+	if ( parallel ) {
+		HParallelStreamEditor parallelStreamEditor( code, argc_, argv_ );
+		ok = parallelStreamEditor.run();
+		errorMessage = parallelStreamEditor.error_message();
+	} else if ( generated._streamDriver ) {
+		HStreamEditor streamEditor( h, cout );
+		ok = ok && streamEditor.run( argc_, argv_ );
+	} else {
+		ok = ok && timeit( h, preciseTime, runs, samples );
+	}
 	time::duration_t execute( c.get_time_elapsed( time::UNIT::NANOSECOND ) );
 
 	if ( ! ok ) {
+		if ( errorMessage.is_empty() ) {
+			errorMessage = h.error_message();
+		}
 		if ( ! setup._noColor ) {
-			cerr << colorize( code ) << colorize_error( h.error_message() ) << endl;
+			cerr << colorize( code ) << colorize_error( errorMessage ) << endl;
 		} else {
-			cerr << code << h.error_message() << endl;
+			cerr << code << errorMessage << endl;
 		}
 	} else if ( ! setup._streamEditor ) {
 		HHuginn::value_t result( h.result() );
-		if ( printOutLastExpressionResultValue ) {
+		if ( generated._printResult ) {
 			cout << to_string( result, &h ) << endl;
 		}
 		if ( result->type_id() == HHuginn::TYPE::INTEGER ) {
 			retVal = static_cast<int>( static_cast<HInteger*>( result.raw() )->value() );
 		}
 	}
-	report_timeit( huginn, load, preprocess, parse, compile, execute, preciseTime, runs );
+	report_timeit( huginn, load, preprocess, parse, compile, execute, preciseTime, runs, samples, codegen, codeCache );
 	return ( ok && ! setup._timeitRepeats ? retVal : 0 );
 	M_EPILOG
 }
@@ -17,6 +17,7 @@ M_VCSID( "$Id: " __ID__ " $" )
 #include "options.hxx"
 #include "setup.hxx"
 #include "repl.hxx"
+#include "timeit.hxx"
 #include "commit_id.hxx"
 
 using namespace yaal;
@@ -138,6 +139,12 @@ int handle_program_options( int argc_, char** argv_ ) {
 				return ( string::join( setup._assumeUsed, "," ) );
 			}
 		)
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "batch" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::NONE )
+		.description( "treat every argument given to linter, tags or reformat mode as a program or a directory tree to process" )
+		.recipient( setup._batch )
 	)(
 		HProgramOptionsHandler::HOption()
 		.long_form( "be-sloppy" )
@@ -189,6 +196,12 @@ int handle_program_options( int argc_, char** argv_ ) {
 		.description( "set field separator for auto-split (**-a**) mode in stream editor (**-n**)" )
 		.argument_name( "sep" )
 		.recipient( setup._fieldSeparator )
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "framed" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::NONE )
+		.description( "use length prefixed frames instead of marker lines in Jupyter kernel mode (**-J**), so completions are served while a cell is running" )
+		.recipient( setup._framed )
 	)(
 		HProgramOptionsHandler::HOption()
 		.long_form( "gen-docs" )
@@ -224,6 +237,14 @@ int handle_program_options( int argc_, char** argv_ ) {
 		.argument_name( "bck" )
 		.default_value( "" )
 		.recipient( setup._inplace )
+	)(
+		HProgramOptionsHandler::HOption()
+		.short_form( 'j' )
+		.long_form( "jobs" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::REQUIRED )
+		.description( "process files given to in-place stream editor, linter, tags or reformat mode using *count* parallel workers" )
+		.argument_name( "count" )
+		.recipient( setup._jobs )
 	)(
 		HProgramOptionsHandler::HOption()
 		.short_form( 'J' )
@@ -294,6 +315,12 @@ int handle_program_options( int argc_, char** argv_ ) {
 		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::NONE )
 		.description( "do not pass program arguments to `main()` function" )
 		.recipient( setup._noArgv )
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "no-cache" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::NONE )
+		.description( "do not use nor update cache of generated programs in one-liner mode" )
+		.recipient( setup._noCache )
 	)(
 		HProgramOptionsHandler::HOption()
 		.long_form( "no-color" )
@@ -320,6 +347,22 @@ int handle_program_options( int argc_, char** argv_ ) {
 		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::NONE )
 		.description( "optimize program execution by removing _assert_ statements" )
 		.recipient( setup._optimize )
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "profile" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::OPTIONAL )
+		.description( "sample program call stack during execution and show per-function and per-line hotspots, optionally save collapsed stacks (for flame graphs) to *path*" )
+		.argument_name( "path" )
+		.setter(
+			[]( HString const& value_ ) {
+				setup._profile = value_;
+			}
+		)
+		.getter(
+			[]( void ) -> yaal::hcore::HString {
+				return ( !! setup._profile ? *setup._profile : HString() );
+			}
+		)
 	)(
 		HProgramOptionsHandler::HOption()
 		.short_form( 'p' )
@@ -368,6 +411,12 @@ int handle_program_options( int argc_, char** argv_ ) {
 		.argument_name( "path" )
 		.default_value( "" )
 		.recipient(	setup._shell )
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "persistent-shell" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::NONE )
+		.description( "keep one forwarding shell process running for all commands, so working directory and environment carry over between commands" )
+		.recipient( setup._persistentShell )
 	)(
 		HProgramOptionsHandler::HOption()
 		.short_form( 'S' )
@@ -409,6 +458,36 @@ int handle_program_options( int argc_, char** argv_ ) {
 				return ( !! setup._timeitRepeats ? *setup._timeitRepeats : 1 );
 			}
 		)
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "timeit-budget" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::REQUIRED )
+		.description( "keep repeating timed execution (**--timeit**) until given number of *milliseconds* elapses" )
+		.argument_name( "milliseconds" )
+		.recipient( setup._timeitBudget )
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "timeit-format" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::REQUIRED )
+		.description( "output format of execution time statistics (**--timeit**), one of: text, json, csv" )
+		.argument_name( "format" )
+		.setter(
+			[]( HString const& value_ ) {
+				setup._timeitFormat = timeit_format( value_ );
+			}
+		)
+		.getter(
+			[]( void ) -> yaal::hcore::HString {
+				return ( timeit_format_to_string( setup._timeitFormat ) );
+			}
+		)
+	)(
+		HProgramOptionsHandler::HOption()
+		.long_form( "timeit-warmup" )
+		.switch_type( HProgramOptionsHandler::HOption::ARGUMENT::REQUIRED )
+		.description( "execute program *count* times before timed executions (**--timeit**) begin" )
+		.argument_name( "count" )
+		.recipient( setup._timeitWarmup )
 	)(
 		HProgramOptionsHandler::HOption()
 		.short_form( 'v' )
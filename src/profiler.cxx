@@ -0,0 +1,239 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <yaal/hcore/algorithm.hxx>
+#include <yaal/hcore/hfile.hxx>
+#include <yaal/hcore/hset.hxx>
+#include <yaal/tools/stringalgo.hxx>
+#include <yaal/tools/sleep.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "profiler.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+typedef HArray<HPair<HString, i64_t>> ranking_t;
+
+ranking_t rank( HProfiler::costs_t const& costs_ ) {
+	M_PROLOG
+	ranking_t ranking;
+	ranking.reserve( costs_.get_size() );
+	for ( HProfiler::costs_t::value_type const& c : costs_ ) {
+		ranking.emplace_back( c.first, c.second );
+	}
+	sort(
+		ranking.begin(), ranking.end(),
+		[]( ranking_t::value_type const& left_, ranking_t::value_type const& right_ ) {
+			return ( left_.second > right_.second );
+		}
+	);
+	return ranking;
+	M_EPILOG
+}
+
+HString percent( i64_t cost_, i64_t total_ ) {
+	M_PROLOG
+	i64_t permille( total_ > 0 ? ( cost_ * 1000 ) / total_ : 0 );
+	HString s( to_string( permille / 10 ) );
+	s.append( "." ).append( permille % 10 ).append( "%" );
+	return s;
+	M_EPILOG
+}
+
+}
+
+HProfiler::HProfiler( int interval_ )
+	: _interval( interval_ )
+	, _stacks()
+	, _lines()
+	, _samples( 0 )
+	, _total( 0 )
+	, _lastSample( 0 )
+	, _point( 0 )
+	, _tickPoint( -1 )
+	, _stalled( false )
+	, _tracking( false )
+	, _trackedStack()
+	, _trackedLine()
+	, _trackedPoint( -1 )
+	, _due( false )
+	, _running( false )
+	, _clock()
+	, _sampler() {
+	return;
+}
+
+HProfiler::~HProfiler( void ) {
+	M_PROLOG
+	stop();
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+void HProfiler::start( void ) {
+	M_PROLOG
+	if ( _running.exchange( true ) ) {
+		return;
+	}
+	_due = false;
+	_stalled = false;
+	_tracking = false;
+	_point = 0;
+	_tickPoint = -1;
+	_trackedPoint = -1;
+	_clock.reset();
+	_lastSample = 0;
+	_sampler.spawn( call( &HProfiler::run, this ) );
+	return;
+	M_EPILOG
+}
+
+void HProfiler::stop( void ) {
+	M_PROLOG
+	if ( ! _running.exchange( false ) ) {
+		return;
+	}
+	_sampler.finish();
+	_due = false;
+	return;
+	M_EPILOG
+}
+
+void HProfiler::run( void ) {
+	M_PROLOG
+	while ( _running.load() ) {
+		sleep::milisecond( _interval );
+		i64_t point( _point.load( std::memory_order_relaxed ) );
+		if ( point == _tickPoint ) {
+			_stalled.store( true, std::memory_order_relaxed );
+		}
+		_tickPoint = point;
+		_due.store( true, std::memory_order_relaxed );
+	}
+	return;
+	M_EPILOG
+}
+
+/*
+ * Call stack comes innermost frame first (the same order `dump_call_stack()` prints it),
+ * collapsed stacks are written outermost frame first as flame graph tools expect.
+ *
+ * Time since the previous charge goes to the statement captured at the previous point
+ * if there was one, that statement ran through the whole interval.
+ * Otherwise statements since the last capture were all short
+ * and the interval goes to the current one.
+ */
+void HProfiler::do_introspect( yaal::tools::HIntrospecteeInterface& introspectee_ ) {
+	M_PROLOG
+	i64_t point( _point.fetch_add( 1, std::memory_order_relaxed ) + 1 );
+	bool due( _due.load( std::memory_order_relaxed ) );
+	if ( ! ( due || _tracking ) ) {
+		return;
+	}
+	HHuginn::call_stack_t callStack( introspectee_.get_call_stack() );
+	if ( callStack.is_empty() ) {
+		return;
+	}
+	if ( due ) {
+		_due.store( false, std::memory_order_relaxed );
+		_tracking = _stalled.exchange( false, std::memory_order_relaxed );
+		++ _samples;
+	}
+	i64_t now( _clock.get_time_elapsed( time::UNIT::NANOSECOND ) );
+	i64_t weight( now - _lastSample );
+	_lastSample = now;
+	HString stack;
+	for ( HHuginn::call_stack_t::const_reverse_iterator it( callStack.rbegin() ), end( callStack.rend() ); it != end; ++ it ) {
+		if ( ! stack.is_empty() ) {
+			stack.append( ";" );
+		}
+		stack.append( it->context() );
+	}
+	HHuginn::HCallSite const& top( callStack.front() );
+	HString line( top.file() );
+	line.append( ":" ).append( top.line() ).append( " (" ).append( top.context() ).append( ")" );
+	if ( _trackedPoint == ( point - 1 ) ) {
+		charge( _trackedStack, _trackedLine, weight );
+	} else {
+		charge( stack, line, weight );
+	}
+	_trackedStack = yaal::move( stack );
+	_trackedLine = yaal::move( line );
+	_trackedPoint = point;
+	return;
+	M_EPILOG
+}
+
+void HProfiler::charge( yaal::hcore::HString const& stack_, yaal::hcore::HString const& line_, yaal::i64_t weight_ ) {
+	M_PROLOG
+	_stacks[stack_] += weight_;
+	_lines[line_] += weight_;
+	_total += weight_;
+	return;
+	M_EPILOG
+}
+
+void HProfiler::report( yaal::hcore::HStreamInterface& stream_ ) const {
+	M_PROLOG
+	costs_t inclusive;
+	costs_t exclusive;
+	HSet<HString> seen;
+	for ( costs_t::value_type const& s : _stacks ) {
+		string::tokens_t frames( string::split<string::tokens_t>( s.first, ";" ) );
+		seen.clear();
+		for ( HString const& frame : frames ) {
+			/* Recursive functions are counted only once per sample. */
+			if ( seen.insert( frame ).second ) {
+				inclusive[frame] += s.second;
+			}
+		}
+		exclusive[frames.back()] += s.second;
+	}
+	stream_ << "Profile: " << _samples << " samples, "
+		<< durationformat( time::UNIT_FORM::ABBREVIATED ) << time::duration_t( _total ) << endl;
+	stream_ << setw( 10 ) << "inclusive" << setw( 11 ) << "exclusive" << "  function" << endl;
+	int entries( 0 );
+	for ( ranking_t::value_type const& f : rank( inclusive ) ) {
+		if ( entries ++ >= REPORT_ENTRIES ) {
+			break;
+		}
+		stream_ << setw( 10 ) << percent( f.second, _total ) << setw( 11 ) << percent( exclusive[f.first], _total ) << "  " << f.first << endl;
+	}
+	stream_ << setw( 10 ) << "exclusive" << "  line" << endl;
+	entries = 0;
+	for ( ranking_t::value_type const& l : rank( _lines ) ) {
+		if ( entries ++ >= REPORT_ENTRIES ) {
+			break;
+		}
+		stream_ << setw( 10 ) << percent( l.second, _total ) << "  " << l.first << endl;
+	}
+	return;
+	M_EPILOG
+}
+
+/*
+ * One line per unique stack, `outer;inner;innermost weight`,
+ * weight is expressed in microseconds.
+ */
+void HProfiler::save_collapsed_stacks( yaal::hcore::HString const& path_ ) const {
+	M_PROLOG
+	HFile f( path_, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
+	if ( ! f ) {
+		throw HFileException( f.get_error() );
+	}
+	for ( costs_t::value_type const& s : _stacks ) {
+		f << s.first << " " << ( s.second / 1000 ) << endl;
+	}
+	return;
+	M_EPILOG
+}
+
+}
+
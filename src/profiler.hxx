@@ -0,0 +1,74 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+/*! \file profiler.hxx
+ * \brief Declaration of HProfiler class.
+ */
+
+#ifndef PROFILER_HXX_INCLUDED
+#define PROFILER_HXX_INCLUDED 1
+
+#include <atomic>
+
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hclock.hxx>
+#include <yaal/hcore/hthread.hxx>
+#include <yaal/tools/hhuginn.hxx>
+
+namespace huginn {
+
+/*! \brief Sampling profiler of Huginn programs.
+ *
+ * Sampler thread raises a flag once per sampling interval,
+ * the interpreter call stack is captured at the next introspection point
+ * of the running program, so between samples the cost is a counter increment and an atomic load.
+ * Each sample is weighted with the wall-clock time elapsed since the previous one.
+ *
+ * The interpreter numbers its introspection points and the sampler records
+ * the current number on every tick. Two ticks seeing the same number mean
+ * a single statement (e.g. a long native or blocking call) spans the interval.
+ * The profiler then captures the stack at every point until ticks stop stalling.
+ * Time is charged to the statement that ran through it, not to the line after it.
+ */
+class HProfiler : public yaal::tools::HIntrospectorInterface {
+public:
+	typedef yaal::hcore::HHashMap<yaal::hcore::HString, yaal::i64_t> costs_t;
+	static int const DEFAULT_INTERVAL = 5; /* milliseconds */
+	static int const REPORT_ENTRIES = 20;
+private:
+	int _interval;
+	costs_t _stacks;
+	costs_t _lines;
+	yaal::i64_t _samples;
+	yaal::i64_t _total;
+	yaal::i64_t _lastSample;
+	std::atomic<yaal::i64_t> _point;
+	yaal::i64_t _tickPoint;
+	std::atomic<bool> _stalled;
+	bool _tracking;
+	yaal::hcore::HString _trackedStack;
+	yaal::hcore::HString _trackedLine;
+	yaal::i64_t _trackedPoint;
+	std::atomic<bool> _due;
+	std::atomic<bool> _running;
+	yaal::hcore::HClock _clock;
+	yaal::hcore::HThread _sampler;
+public:
+	HProfiler( int = DEFAULT_INTERVAL );
+	virtual ~HProfiler( void );
+	void start( void );
+	void stop( void );
+	void report( yaal::hcore::HStreamInterface& ) const;
+	void save_collapsed_stacks( yaal::hcore::HString const& ) const;
+protected:
+	virtual void do_introspect( yaal::tools::HIntrospecteeInterface& ) override;
+private:
+	void run( void );
+	void charge( yaal::hcore::HString const&, yaal::hcore::HString const&, yaal::i64_t );
+	HProfiler( HProfiler const& ) = delete;
+	HProfiler& operator = ( HProfiler const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef PROFILER_HXX_INCLUDED */
+
@@ -6,7 +6,7 @@
 
 M_VCSID( "$Id: " __ID__ " $" )
 #include "reformat.hxx"
-#include "huginn.hxx"
+#include "scriptsource.hxx"
 #include "setup.hxx"
 
 using namespace yaal;
@@ -560,8 +560,8 @@ HFormatter::~HFormatter( void ) {
 }
 
 bool HFormatter::reformat_file( char const* script_ ) {
-	buffer_t source( ::huginn::load( script_ ) );
-	hcore::HString s( source.data(), source.get_size() );
+	HScriptSource source( script_, HScriptSource::EMBEDDED::AUTO );
+	hcore::HString s( source.data(), source.size() );
 	hcore::HString out;
 	bool ok( _impl->reformat( s, out ) );
 	cout << out << flush;
@@ -10,6 +10,9 @@
 #include <yaal/tools/streamtools.hxx>
 
 #include "repl.hxx"
+#ifdef USE_REPLXX
+#	include "completionworker.hxx"
+#endif
 M_VCSID( "$Id: " __ID__ " $" )
 M_VCSID( "$Id: " __TID__ " $" )
 
@@ -132,6 +135,13 @@ namespace {
 
 #ifdef USE_REPLXX
 
+/*
+ * Private key codes the completion worker uses to wake up input loop,
+ * no terminal produces those.
+ */
+char32_t const COMPLETIONS_READY_KEY( Replxx::KEY::control( Replxx::KEY::meta( Replxx::KEY::F12 ) ) );
+char32_t const HINTS_READY_KEY( Replxx::KEY::control( Replxx::KEY::meta( Replxx::KEY::F11 ) ) );
+
 typedef yaal::hcore::HHashMap<yaal::tools::COLOR::color_t, Replxx::Color> replxx_colors_t;
 replxx_colors_t _replxxColors_ = {
 	{ COLOR::FG_BLACK,         Replxx::Color::BLACK },
@@ -159,9 +169,18 @@ Replxx::completions_t replxx_completion_words( std::string const& context_, int&
 	contextLen_ = context_length( prefix, CONTEXT_TYPE::HUGINN );
 	prefix.shift_left( prefix.get_length() - contextLen_ );
 	CONTEXT_TYPE contextType( CONTEXT_TYPE::HUGINN );
-	HRepl::completions_t completions( static_cast<HRepl*>( data_ )->completion_words( context_.c_str(), yaal::move( prefix ), contextLen_, contextType, true, false ) );
-	HUTF8String utf8;
+	HRepl::completions_t completions;
 	Replxx::completions_t replxxCompletions;
+	HUTF8String utf8;
+	if ( ! static_cast<HRepl*>( data_ )->completion_words_async( context_.c_str(), prefix, contextLen_, contextType, true, false, completions ) ) {
+		/*
+		 * Completions are still being generated, pretend that prefix completes to itself,
+		 * the real list is shown as soon as it is ready.
+		 */
+		utf8.assign( prefix );
+		replxxCompletions.emplace_back( utf8.c_str() );
+		return replxxCompletions;
+	}
 	for ( HRepl::HCompletion const& c : completions ) {
 		utf8.assign( c.text() );
 		replxxCompletions.emplace_back( utf8.c_str(), yaal_to_replxx( c.color() ) );
@@ -445,6 +464,7 @@ HRepl::HRepl( void )
 		{ "C-F11", Replxx::KEY::control( Replxx::KEY::F11 ) },
 		{ "C-F12", Replxx::KEY::control( Replxx::KEY::F12 ) }
 	})
+	, _completionWorker( make_resource<HCompletionWorker>( *this ) )
 #elif defined( USE_EDITLINE )
 	, _el( el_init( PACKAGE_NAME, stdin, stdout, stderr ) )
 	, _hist( history_init() )
@@ -468,6 +488,8 @@ HRepl::HRepl( void )
 #ifdef USE_REPLXX
 	_replxx.install_window_change_handler();
 	_replxx.set_no_color( setup._noColor ? 1 : 0 );
+	_replxx.bind_key( COMPLETIONS_READY_KEY, call( &HRepl::deliver_completions, this, _1 ) );
+	_replxx.bind_key( HINTS_READY_KEY, call( &HRepl::deliver_hints, this, _1 ) );
 #elif defined( USE_EDITLINE )
 	el_set( _el, EL_EDITOR, "emacs" );
 	el_set( _el, EL_SIGNAL, SIGWINCH );
@@ -866,6 +888,9 @@ HRepl::HRepl( void )
 
 
 HRepl::~HRepl( void ) {
+#ifdef USE_REPLXX
+	_completionWorker.reset();
+#endif
 	save_history();
 #ifdef USE_EDITLINE
 	history_end( _hist );
@@ -1085,10 +1110,68 @@ void HRepl::load_history( void ) {
 }
 
 HRepl::completions_t HRepl::completion_words( yaal::hcore::HString&& context_, yaal::hcore::HString&& prefix_, int& contextLen_, CONTEXT_TYPE& contextType_, bool shell_, bool hints_ ) {
-	HScopedValueReplacement<HShell*> svr( _shell, shell_ ? _shell : nullptr );
-	return ( _completer( _inputSoFar + context_, yaal::move( prefix_ ), contextLen_, contextType_, this, hints_ ) );
+	return ( _completer( _inputSoFar + context_, yaal::move( prefix_ ), contextLen_, contextType_, this, shell_ ? _shell : nullptr, hints_ ) );
+}
+
+#ifdef USE_REPLXX
+/*
+ * Completions and hints are generated on the completion worker,
+ * so slow completers (huge directories, network mounts, slow `complete` scripts)
+ * do not stall the input loop.
+ * Returns `false` if result for given context is not available yet,
+ * in such case generation of the result is scheduled and the input loop is notified
+ * with a private key press once the result is ready.
+ */
+bool HRepl::completion_words_async(
+	yaal::hcore::HString const& context_,
+	yaal::hcore::HString const& prefix_,
+	int& contextLen_,
+	CONTEXT_TYPE& contextType_,
+	bool shell_,
+	bool hints_,
+	completions_t& completions_
+) {
+	M_PROLOG
+	HCompletionWorker::KIND kind( hints_ ? HCompletionWorker::KIND::HINTS : HCompletionWorker::KIND::COMPLETIONS );
+	HCompletionWorker::OResult result;
+	if ( ! _completionWorker->fetch( kind, context_, result ) ) {
+		_completionWorker->submit( kind, context_, prefix_, contextLen_, shell_ );
+		return ( false );
+	}
+	contextLen_ = result._contextLen;
+	contextType_ = result._contextType;
+	completions_ = yaal::move( result._completions );
+	return ( true );
+	M_EPILOG
 }
 
+void HRepl::completion_ready( bool hints_ ) {
+	_replxx.emulate_key_press( hints_ ? HINTS_READY_KEY : COMPLETIONS_READY_KEY );
+	return;
+}
+
+void HRepl::cancel_completions( void ) {
+	M_PROLOG
+	_completionWorker->cancel();
+	return;
+	M_EPILOG
+}
+
+replxx::Replxx::ACTION_RESULT HRepl::deliver_completions( char32_t code_ ) {
+	if ( ! _completionWorker->has_result( HCompletionWorker::KIND::COMPLETIONS ) ) {
+		return ( replxx::Replxx::ACTION_RESULT::CONTINUE );
+	}
+	return ( _replxx.invoke( Replxx::ACTION::COMPLETE_LINE, code_ ) );
+}
+
+replxx::Replxx::ACTION_RESULT HRepl::deliver_hints( char32_t code_ ) {
+	if ( ! _completionWorker->has_result( HCompletionWorker::KIND::HINTS ) ) {
+		return ( replxx::Replxx::ACTION_RESULT::CONTINUE );
+	}
+	return ( _replxx.invoke( Replxx::ACTION::REPAINT, code_ ) );
+}
+#endif
+
 bool HRepl::input_impl( yaal::hcore::HString& line_, char const* prompt_ ) {
 	_prompt = prompt_;
 	char const* rawLine( nullptr );
@@ -1096,6 +1179,10 @@ bool HRepl::input_impl( yaal::hcore::HString& line_, char const* prompt_ ) {
 	do {
 		rawLine = REPL_get_input( prompt_ );
 	} while ( ! ( gotLine = ( rawLine != nullptr ) ) && ( errno == EAGAIN ) );
+#ifdef USE_REPLXX
+	/* Whatever the worker is doing now is for the line that is already finished. */
+	cancel_completions();
+#endif
 	if ( gotLine ) {
 		line_ = rawLine;
 		int len( static_cast<int>( strlen( rawLine ) ) );
@@ -1223,7 +1310,10 @@ Replxx::hints_t HRepl::find_hints( std::string const& prefix_, int& contextLen_,
 	}
 	bool inDocContext( context.find( "//doc " ) == 0 );
 	CONTEXT_TYPE contextType( CONTEXT_TYPE::HUGINN );
-	HRepl::completions_t hints( completion_words( prefix_.c_str(), HString( prefix ), contextLen_, contextType, context.get_length() > 1, true ) );
+	HRepl::completions_t hints;
+	if ( ! completion_words_async( prefix_.c_str(), prefix, contextLen_, contextType, context.get_length() > 1, true, hints ) ) {
+		return ( Replxx::hints_t() );
+	}
 	if ( hints.is_empty() ) {
 		return ( Replxx::hints_t() );
 	}
@@ -1368,6 +1458,8 @@ void HRepl::env_to_model( void ) {
 
 #ifdef USE_REPLXX
 replxx::Replxx::ACTION_RESULT HRepl::run_action( action_t action_, char32_t ) {
+	/* User actions run arbitrary code in the shell, worker must not look at it meanwhile. */
+	cancel_completions();
 	_replxx.invoke( Replxx::ACTION::CLEAR_SELF, 0 );
 	model_to_env();
 	HScopeExitCall sec(
@@ -10,6 +10,7 @@
 #include <yaal/hcore/hstring.hxx>
 #include <yaal/hcore/hstreaminterface.hxx>
 #include <yaal/hcore/htuple.hxx>
+#include <yaal/hcore/hresource.hxx>
 #include <yaal/tools/color.hxx>
 
 #include "config.hxx"
@@ -99,7 +100,7 @@ public:
 	};
 	typedef yaal::hcore::HArray<HCompletion> completions_t;
 	typedef yaal::hcore::HArray<HHistoryEntry> history_entries_t;
-	typedef completions_t ( *completion_words_t )( yaal::hcore::HString&&, yaal::hcore::HString&&, int&, CONTEXT_TYPE&, void*, bool );
+	typedef completions_t ( *completion_words_t )( yaal::hcore::HString&&, yaal::hcore::HString&&, int&, CONTEXT_TYPE&, void*, HShell*, bool );
 	typedef yaal::hcore::HBoundCall<> action_t;
 #ifndef USE_REPLXX
 #	ifdef USE_EDITLINE
@@ -122,12 +123,17 @@ public:
 	};
 	typedef yaal::hcore::HHashMap<yaal::hcore::HString, OKeyBindDispatchInfo> key_binding_dispatch_into_t;
 #endif
+#ifdef USE_REPLXX
+	class HCompletionWorker;
+	typedef yaal::hcore::HResource<HCompletionWorker> completion_worker_t;
+#endif
 private:
 	yaal::hcore::HString _inputSoFar;
 #ifdef USE_REPLXX
 	typedef yaal::hcore::HHashMap<yaal::hcore::HString, char32_t> key_table_t;
 	replxx::Replxx _replxx;
 	key_table_t _keyTable;
+	completion_worker_t _completionWorker;
 #else
 # ifdef USE_EDITLINE
 	EditLine* _el;
@@ -181,6 +187,9 @@ public:
 	bool bind_key( yaal::hcore::HString const&, action_t const& );
 	bool bind_key( yaal::hcore::HString const&, yaal::hcore::HString const& );
 	completions_t completion_words( yaal::hcore::HString&&, yaal::hcore::HString&&, int&, CONTEXT_TYPE&, bool, bool );
+#ifdef USE_REPLXX
+	bool completion_words_async( yaal::hcore::HString const&, yaal::hcore::HString const&, int&, CONTEXT_TYPE&, bool, bool, completions_t& );
+#endif
 	void load_history( void );
 	void save_history( void );
 	void set_max_history_size( int );
@@ -198,6 +207,10 @@ private:
 	bool input_impl( yaal::hcore::HString&, char const* );
 #ifdef USE_REPLXX
 	replxx::Replxx::ACTION_RESULT run_action( action_t, char32_t );
+	void completion_ready( bool );
+	void cancel_completions( void );
+	replxx::Replxx::ACTION_RESULT deliver_completions( char32_t );
+	replxx::Replxx::ACTION_RESULT deliver_hints( char32_t );
 	void colorize( std::string const&, replxx::Replxx::colors_t& ) const;
 	replxx::Replxx::hints_t find_hints( std::string const&, int&, replxx::Replxx::Color& );
 	yaal::hcore::HString expand_hint_huginn( yaal::hcore::HString const&, bool );
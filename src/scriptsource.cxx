@@ -0,0 +1,170 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <cstring>
+
+#ifndef __MSVCXX__
+#	include <unistd.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <sys/mman.h>
+#endif
+
+#include <yaal/hcore/hfile.hxx>
+#include <yaal/hcore/hregex.hxx>
+#include <yaal/hcore/unicode.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "scriptsource.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+static char const EMPTY[] = "";
+
+}
+
+HScriptSource::HScriptSource( yaal::hcore::HString const& path_, EMBEDDED embedded_ )
+	: _buffer()
+	, _mapping( nullptr )
+	, _mappingSize( 0 )
+	, _data( EMPTY )
+	, _size( 0 )
+	, _lineSkip( 0 )
+	, _shebang()
+	, _stream() {
+	M_PROLOG
+	if ( path_.is_empty() || ( path_ == "-" ) ) {
+		read( cin );
+	} else if ( ! map( path_ ) ) {
+		HFile f( path_, HFile::OPEN::READING );
+		if ( ! f ) {
+			throw HFileException( f.get_error() );
+		}
+		read( f );
+	}
+	skip_embedded( embedded_ );
+	return;
+	M_EPILOG
+}
+
+HScriptSource::~HScriptSource( void ) {
+	M_PROLOG
+	_stream.reset();
+#ifndef __MSVCXX__
+	if ( _mapping ) {
+		::munmap( _mapping, static_cast<size_t>( _mappingSize ) );
+	}
+#endif
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+/*
+ * Only non-empty regular files can be mapped,
+ * for anything else caller falls back to plain reading,
+ * and reports errors (if any) from there.
+ */
+bool HScriptSource::map( yaal::hcore::HString const& path_ ) {
+	M_PROLOG
+#ifndef __MSVCXX__
+	HUTF8String utf8( path_ );
+	int fd( ::open( utf8.c_str(), O_RDONLY | O_CLOEXEC ) );
+	if ( fd < 0 ) {
+		return ( false );
+	}
+	struct stat s;
+	void* mapping( MAP_FAILED );
+	if ( ( ::fstat( fd, &s ) == 0 ) && S_ISREG( s.st_mode ) && ( s.st_size > 0 ) ) {
+		mapping = ::mmap( nullptr, static_cast<size_t>( s.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+	}
+	::close( fd );
+	if ( mapping == MAP_FAILED ) {
+		return ( false );
+	}
+	::madvise( mapping, static_cast<size_t>( s.st_size ), MADV_SEQUENTIAL );
+	_mapping = mapping;
+	_mappingSize = s.st_size;
+	_data = static_cast<char const*>( mapping );
+	_size = s.st_size;
+	return ( true );
+#else
+	return ( false );
+#endif
+	M_EPILOG
+}
+
+void HScriptSource::read( yaal::hcore::HStreamInterface& stream_ ) {
+	M_PROLOG
+	static int const INITIAL_SIZE( 4096 );
+	int long nSize( 0 );
+	_buffer.resize( INITIAL_SIZE, '\0' );
+	while ( true ) {
+		int long toRead( _buffer.get_size() - nSize );
+		int long nRead( stream_.read( _buffer.data() + nSize, toRead ) );
+		nSize += nRead;
+		if ( nRead < toRead ) {
+			break;
+		}
+		_buffer.resize( _buffer.get_size() * 2 );
+	}
+	_buffer.resize( nSize );
+	if ( nSize > 0 ) {
+		_data = _buffer.data();
+		_size = nSize;
+	}
+	return;
+	M_EPILOG
+}
+
+void HScriptSource::skip_embedded( EMBEDDED embedded_ ) {
+	M_PROLOG
+	bool embedded(
+		( embedded_ == EMBEDDED::YES )
+		|| ( ( embedded_ == EMBEDDED::AUTO ) && ( _size > 2 ) && ( _data[0] == '#' ) && ( _data[1] == '!' ) )
+	);
+	if ( ! embedded ) {
+		return;
+	}
+	HRegex r( "^#!.*\\bhuginn\\b.*" );
+	char const* end( _data + _size );
+	char const* pos( _data );
+	while ( pos < end ) {
+		char const* eol( static_cast<char const*>( ::memchr( pos, '\n', static_cast<size_t>( end - pos ) ) ) );
+		char const* next( eol ? eol + 1 : end );
+		++ _lineSkip;
+		/* Only candidate lines are decoded. */
+		if ( ( ( eol ? eol : end ) - pos > 1 ) && ( pos[0] == '#' ) && ( pos[1] == '!' ) ) {
+			HString line( pos, ( eol ? eol : end ) - pos );
+			if ( r.matches( line ) ) {
+				_shebang = yaal::move( line );
+				pos = next;
+				break;
+			}
+		}
+		pos = next;
+	}
+	_size -= ( pos - _data );
+	_data = pos;
+	return;
+	M_EPILOG
+}
+
+yaal::hcore::HStreamInterface& HScriptSource::stream( void ) {
+	M_PROLOG
+	if ( ! _stream ) {
+		/* HMemory only ever reads from the observed block. */
+		_stream = make_resource<HMemory>( make_resource<HMemoryObserver>( const_cast<char*>( _data ), _size ), HMemory::INITIAL_STATE::VALID );
+	}
+	return ( *_stream );
+	M_EPILOG
+}
+
+}
+
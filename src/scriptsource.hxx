@@ -0,0 +1,80 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+/*! \file scriptsource.hxx
+ * \brief Declaration of HScriptSource class.
+ */
+
+#ifndef SCRIPTSOURCE_HXX_INCLUDED
+#define SCRIPTSOURCE_HXX_INCLUDED 1
+
+#include <yaal/hcore/harray.hxx>
+#include <yaal/hcore/hresource.hxx>
+#include <yaal/tools/hmemory.hxx>
+
+namespace huginn {
+
+typedef yaal::hcore::HArray<char> buffer_t;
+
+/*! \brief Complete text of a Huginn program.
+ *
+ * Regular files are mapped into memory instead of being read,
+ * stream() hands the mapping to HHuginn::load() without an intermediate copy.
+ * Users that need the text as a string (formatter, tags) still make one.
+ * Standard input and special files are read into a buffer.
+ * Embedded program prefix (everything up to and including `#! ... huginn` line)
+ * is skipped by adjusting an offset into the mapping.
+ */
+class HScriptSource {
+public:
+	enum class EMBEDDED {
+		NO,
+		YES,
+		AUTO
+	};
+private:
+	buffer_t _buffer;
+	void* _mapping;
+	int long _mappingSize;
+	char const* _data;
+	int long _size;
+	int _lineSkip;
+	yaal::hcore::HString _shebang;
+	yaal::hcore::HResource<yaal::tools::HMemory> _stream;
+public:
+	/*! \brief Load program text.
+	 *
+	 * \param path - path to the program, empty or `-` means standard input.
+	 * \param embedded - skip embedded program prefix, AUTO skips it if text starts with `#!`.
+	 */
+	HScriptSource( yaal::hcore::HString const& path, EMBEDDED embedded );
+	~HScriptSource( void );
+	char const* data( void ) const {
+		return ( _data );
+	}
+	int long size( void ) const {
+		return ( _size );
+	}
+	int line_skip( void ) const {
+		return ( _lineSkip );
+	}
+	bool is_mapped( void ) const {
+		return ( _mapping != nullptr );
+	}
+	/*! \brief Get `#! ... huginn` line that ended embedded program prefix.
+	 */
+	yaal::hcore::HString const& shebang( void ) const {
+		return ( _shebang );
+	}
+	yaal::hcore::HStreamInterface& stream( void );
+private:
+	bool map( yaal::hcore::HString const& );
+	void read( yaal::hcore::HStreamInterface& );
+	void skip_embedded( EMBEDDED );
+	HScriptSource( HScriptSource const& ) = delete;
+	HScriptSource& operator = ( HScriptSource const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef SCRIPTSOURCE_HXX_INCLUDED */
+
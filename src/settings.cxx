@@ -13,6 +13,7 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "settings.hxx"
 #include "setup.hxx"
 #include "colorize.hxx"
+#include "timeit.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -51,6 +52,20 @@ void apply_setting( yaal::tools::HHuginn& huginn_, yaal::hcore::HString const& s
 			} else {
 				throw HRuntimeException( "unknown error_context setting: "_ys.append( value ) );
 			}
+		} else if ( name == "timeit_warmup" ) {
+			int warmup( lexical_cast<int>( value ) );
+			if ( warmup < 0 ) {
+				throw HRuntimeException( "invalid timeit_warmup setting: "_ys.append( value ) );
+			}
+			setup._timeitWarmup = warmup;
+		} else if ( name == "timeit_budget" ) {
+			int budget( lexical_cast<int>( value ) );
+			if ( budget < 0 ) {
+				throw HRuntimeException( "invalid timeit_budget setting: "_ys.append( value ) );
+			}
+			setup._timeitBudget = budget;
+		} else if ( name == "timeit_format" ) {
+			setup._timeitFormat = timeit_format( value );
 		} else if ( name == "color_scheme" ) {
 			try {
 				if ( setup._colorSchemeSource != SETTING_SOURCE::COMMAND_LINE ) {
@@ -126,6 +141,15 @@ rt_settings_t rt_settings( bool all_ ) {
 	} else if ( ( setup._colorSchemeSource != SETTING_SOURCE::COMMAND_LINE ) && ! setup._colorScheme.is_empty() ) {
 		rts.insert( make_pair( "color_scheme", setup._colorScheme ) );
 	}
+	if ( all_ || ( setup._timeitWarmup != 0 ) ) {
+		rts.insert( make_pair( "timeit_warmup", to_string( setup._timeitWarmup ) ) );
+	}
+	if ( all_ || ( setup._timeitBudget != 0 ) ) {
+		rts.insert( make_pair( "timeit_budget", to_string( setup._timeitBudget ) ) );
+	}
+	if ( all_ || ( setup._timeitFormat != TIMEIT_FORMAT::TEXT ) ) {
+		rts.insert( make_pair( "timeit_format", timeit_format_to_string( setup._timeitFormat ) ) );
+	}
 	if ( all_ || ( setup._prompt != setup.default_prompt() ) ) {
 		rts.insert( make_pair( !! setup._shell ? "shell_prompt" : "prompt", setup._prompt ) );
 	}
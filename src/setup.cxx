@@ -51,6 +51,7 @@ OSetup::OSetup( void )
 	, _jupyter( false )
 	, _noDefaultImports( false )
 	, _noDefaultInit( false )
+	, _noCache( false )
 	, _noArgv( false )
 	, _beSloppy( false )
 	, _optimize( false )
@@ -60,9 +61,16 @@ OSetup::OSetup( void )
 	, _chomp( false )
 	, _autoSplit( false )
 	, _aliasImports( false )
+	, _framed( false )
+	, _persistentShell( false )
+	, _batch( false )
 	, _colorSchemeSource( SETTING_SOURCE::NONE )
 	, _errorContext( ERROR_CONTEXT::SHORT )
+	, _jobs( 1 )
 	, _timeitRepeats()
+	, _timeitWarmup( 0 )
+	, _timeitBudget( 0 )
+	, _timeitFormat( TIMEIT_FORMAT::TEXT )
 	, _inplace()
 	, _program()
 	, _shell()
@@ -76,7 +84,8 @@ OSetup::OSetup( void )
 	, _genDocs()
 	, _assumeUsed()
 	, _programName( nullptr )
-	, _logPath() {
+	, _logPath()
+	, _profile() {
 	return;
 }
 
@@ -143,6 +152,12 @@ void OSetup::test_setup( int argc_ ) {
 		);
 	}
 	++ errNo;
+	if ( _noCache && ! _program ) {
+		yaal::tools::util::failure( errNo,
+			_( "no-cache setting can be only used in one-liner mode\n" )
+		);
+	}
+	++ errNo;
 	if ( _noDefaultInit && ! ( _interactive || _jupyter ) ) {
 		yaal::tools::util::failure( errNo,
 			_( "default `init` setting can be only used in interactive or Jupyter mode\n" )
@@ -185,6 +200,18 @@ void OSetup::test_setup( int argc_ ) {
 		);
 	}
 	++ errNo;
+	if ( _jobs < 1 ) {
+		yaal::tools::util::failure( errNo,
+			_( "number of jobs (**-j**) must be a positive integer\n" )
+		);
+	}
+	++ errNo;
+	if ( ( _jobs > 1 ) && ! ( _inplace || _lint || _tags || _reformat ) ) {
+		yaal::tools::util::failure( errNo,
+			_( "jobs (**-j**) switch makes sense only for in-place (**-i**) stream editor, linter, tags or reformat mode\n" )
+		);
+	}
+	++ errNo;
 	if ( _autoSplit && ! ( _streamEditor || _streamEditorSilent ) ) {
 		yaal::tools::util::failure( errNo,
 			_( "auto-split (**-a**) switch makes sense only for stream editor mode (**-n**)\n" )
@@ -228,6 +255,45 @@ void OSetup::test_setup( int argc_ ) {
 			_( "invalid color scheme\n" )
 		);
 	}
+	++ errNo;
+	if ( ( _timeitWarmup < 0 ) || ( _timeitBudget < 0 ) ) {
+		yaal::tools::util::failure( errNo,
+			_( "timeit warm-up count and time budget must not be negative\n" )
+		);
+	}
+	++ errNo;
+	if (
+		! _timeitRepeats && ! ( _interactive || _jupyter )
+		&& ( ( _timeitWarmup > 0 ) || ( _timeitBudget > 0 ) || ( _timeitFormat != TIMEIT_FORMAT::TEXT ) )
+	) {
+		yaal::tools::util::failure( errNo,
+			_( "timeit-warmup, timeit-budget and timeit-format settings make sense only with timeit switch or with `//time` in interactive modes\n" )
+		);
+	}
+	++ errNo;
+	if ( _profile && ( _interactive || _jupyter || _program || _lint || _tags || _reformat || _shell ) ) {
+		yaal::tools::util::failure( errNo,
+			_( "profile switch makes sense only in script execution mode\n" )
+		);
+	}
+	++ errNo;
+	if ( _framed && ! _jupyter ) {
+		yaal::tools::util::failure( errNo,
+			_( "framed switch makes sense only in Jupyter kernel mode (**-J**)\n" )
+		);
+	}
+	++ errNo;
+	if ( _persistentShell && ( ! _shell || _shell->is_empty() ) ) {
+		yaal::tools::util::failure( errNo,
+			_( "persistent shell switch makes sense only with forwarding shell (**--shell=path**)\n" )
+		);
+	}
+	++ errNo;
+	if ( _batch && ! ( _lint || _tags || _reformat ) ) {
+		yaal::tools::util::failure( errNo,
+			_( "batch switch makes sense only for linter, tags or reformat mode\n" )
+		);
+	}
 	/*
 	 * black        kK
 	 * red          rR
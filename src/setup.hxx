@@ -19,6 +19,12 @@ enum class ERROR_CONTEXT {
 	SHORT
 };
 
+enum class TIMEIT_FORMAT {
+	TEXT,
+	JSON,
+	CSV
+};
+
 enum class SETTING_SOURCE {
 	NONE,
 	RC,
@@ -50,6 +56,7 @@ struct OSetup {
 	bool _jupyter;
 	bool _noDefaultImports;
 	bool _noDefaultInit;
+	bool _noCache;
 	bool _noArgv;
 	bool _beSloppy;
 	bool _optimize;
@@ -59,9 +66,16 @@ struct OSetup {
 	bool _chomp;
 	bool _autoSplit;
 	bool _aliasImports;
+	bool _framed;
+	bool _persistentShell;
+	bool _batch;
 	SETTING_SOURCE _colorSchemeSource;
 	ERROR_CONTEXT _errorContext;
+	int _jobs;
 	int_opt_t _timeitRepeats;
+	int _timeitWarmup;
+	int _timeitBudget;
+	TIMEIT_FORMAT _timeitFormat;
 	string_opt_t _inplace;
 	string_opt_t _program;
 	string_opt_t _shell;
@@ -76,6 +90,7 @@ struct OSetup {
 	symbol_names_t _assumeUsed;
 	char const* _programName;
 	string_opt_t _logPath;
+	string_opt_t _profile;
 	/* self-sufficient */
 	OSetup( void );
 	void test_setup( int );
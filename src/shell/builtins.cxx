@@ -26,6 +26,9 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "src/quotes.hxx"
 #include "src/setup.hxx"
 #include "util.hxx"
+#include "commandindex.hxx"
+#include "fileinfocache.hxx"
+#include "reaper.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -325,6 +328,36 @@ void HSystemShell::setopt_history_max_size( OCommand& command_ ) {
 	M_EPILOG
 }
 
+void HSystemShell::setopt_capture_max_size( OCommand& command_ ) {
+	M_PROLOG
+	HLock l( _mutex );
+	if ( command_._tokens.get_size() != 1 ) {
+		throw HRuntimeException( "setopt capture_max_size option requires exactly one parameter!" );
+	}
+	int long captureMaxSize( lexical_cast<int long>( command_._tokens.front() ) );
+	if ( captureMaxSize < 0 ) {
+		throw HRuntimeException( "setopt capture_max_size: new value must be non-negative ("_ys.append( command_._tokens.front() ).append( ")!" ) );
+	}
+	_captureMaxSize = captureMaxSize;
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::setopt_file_info_ttl( OCommand& command_ ) {
+	M_PROLOG
+	HLock l( _mutex );
+	if ( command_._tokens.get_size() != 1 ) {
+		throw HRuntimeException( "setopt file_info_ttl option requires exactly one parameter!" );
+	}
+	int long fileInfoTTL( lexical_cast<int long>( command_._tokens.front() ) );
+	if ( fileInfoTTL < 0 ) {
+		throw HRuntimeException( "setopt file_info_ttl: new value must be non-negative ("_ys.append( command_._tokens.front() ).append( ")!" ) );
+	}
+	_fileInfoCache->set_ttl( fileInfoTTL );
+	return;
+	M_EPILOG
+}
+
 void HSystemShell::setopt_trace( OCommand& command_ ) {
 	M_PROLOG
 	tokens_t toks;
@@ -381,6 +414,30 @@ void HSystemShell::setopt_prefix_commands( OCommand& command_ ) {
 	M_EPILOG
 }
 
+void HSystemShell::setopt_fast_builtins( OCommand& command_ ) {
+	M_PROLOG
+	tokens_t toks;
+	for ( yaal::hcore::HString const& word : command_._tokens ) {
+		tokens_t interpolated( interpolate( word, EVALUATION_MODE::DIRECT ) );
+		toks.insert( toks.end(), interpolated.begin(), interpolated.end() );
+	}
+	if ( toks.get_size() != 1 ) {
+		throw HRuntimeException( "setopt fast_builtins option requires exactly one parameter!" );
+	}
+	bool fastBuiltins( lexical_cast<bool>( toks.front() ) );
+	HLock l( _mutex );
+	for ( builtins_t::value_type const& coreUtil : _coreUtils ) {
+		if ( fastBuiltins ) {
+			_builtins.insert( coreUtil );
+		} else {
+			_builtins.erase( coreUtil.first );
+		}
+	}
+	_fastBuiltins = fastBuiltins;
+	return;
+	M_EPILOG
+}
+
 yaal::hcore::HString HSystemShell::setopt_print_trace( void ) const {
 	return ( lexical_cast<HString>( _trace ).append( " '" ).append( _tracePrompt ).append( "'" ) );
 }
@@ -404,6 +461,14 @@ yaal::hcore::HString HSystemShell::setopt_print_history_max_size( void ) const {
 	return ( lexical_cast<HString>( _repl.max_history_size() ) );
 }
 
+yaal::hcore::HString HSystemShell::setopt_print_capture_max_size( void ) const {
+	return ( lexical_cast<HString>( _captureMaxSize ) );
+}
+
+yaal::hcore::HString HSystemShell::setopt_print_file_info_ttl( void ) const {
+	return ( lexical_cast<HString>( _fileInfoCache->ttl() ).append( " (" ).append( _fileInfoCache->stats() ).append( ")" ) );
+}
+
 yaal::hcore::HString HSystemShell::setopt_print_history_path( void ) const {
 	return ( setup._historyPath );
 }
@@ -412,6 +477,10 @@ yaal::hcore::HString HSystemShell::setopt_print_ignore_filenames( void ) const {
 	return ( _ignoredFiles.pattern() );
 }
 
+yaal::hcore::HString HSystemShell::setopt_print_fast_builtins( void ) const {
+	return ( lexical_cast<HString>( _fastBuiltins ) );
+}
+
 void HSystemShell::setopt_print( OCommand& command_ ) {
 	M_PROLOG
 	HLock l( _mutex );
@@ -421,9 +490,12 @@ void HSystemShell::setopt_print( OCommand& command_ ) {
 		{ "ignore_filenames", &HSystemShell::setopt_print_ignore_filenames },
 		{ "history_path", &HSystemShell::setopt_print_history_path },
 		{ "history_max_size", &HSystemShell::setopt_print_history_max_size },
+		{ "capture_max_size", &HSystemShell::setopt_print_capture_max_size },
+		{ "file_info_ttl", &HSystemShell::setopt_print_file_info_ttl },
 		{ "trace", &HSystemShell::setopt_print_trace },
 		{ "super_user_paths", &HSystemShell::setopt_print_super_user_paths },
-		{ "prefix_commands", &HSystemShell::setopt_print_prefix_commands }
+		{ "prefix_commands", &HSystemShell::setopt_print_prefix_commands },
+		{ "fast_builtins", &HSystemShell::setopt_print_fast_builtins }
 	};
 	if ( command_._tokens.is_empty() ) {
 		int maxOptNameLen( 0 );
@@ -554,21 +626,17 @@ void HSystemShell::rehash( OCommand& command_ ) {
 	if ( argCount > 1 ) {
 		throw HRuntimeException( "rehash: Superfluous parameter!" );
 	}
-	_systemCommands.clear();
-	learn_system_commands();
-	if ( ! _loaded ) {
-		return;
-	}
+	_commandIndex->clear();
 	char const* HOME( ::getenv( "HOME" ) );
-	if ( ! HOME ) {
-		return;
-	}
-	HString cacheDir;
-	cacheDir.assign( HOME ).append( "/.cache/huginn" );
-	try {
-		filesystem::remove_directory( cacheDir, DIRECTORY_MODIFICATION::RECURSIVE );
-	} catch ( ... ) {
+	if ( _loaded && HOME ) {
+		HString cacheDir;
+		cacheDir.assign( HOME ).append( "/.cache/huginn" );
+		try {
+			filesystem::remove_directory( cacheDir, DIRECTORY_MODIFICATION::RECURSIVE );
+		} catch ( ... ) {
+		}
 	}
+	learn_system_commands();
 	return;
 	M_EPILOG
 }
@@ -669,6 +737,7 @@ void HSystemShell::bg( OCommand& command_ ) {
 	job_t& job( _jobs[get_job_no( "bg", command_, true )] );
 	if ( job->status().type == HPipedChild::STATUS::TYPE::PAUSED ) {
 		job->do_continue( true );
+		_reaper->watch( *job );
 	}
 	return;
 	M_EPILOG
@@ -919,7 +988,8 @@ char const HELP_JOBS[] =
 char const HELP_REHASH[] =
 	"%brehash%0\n\n"
 	"Re-learn locations of system commands found in each directory\n"
-	"mentioned in %e${PATH}%0 environment variable.\n"
+	"mentioned in %e${PATH}%0 environment variable, rescanning every\n"
+	"directory instead of trusting the persistent command index.\n"
 	"Also remove completion caches.\n"
 ;
 
@@ -935,10 +1005,13 @@ char const HELP_SETOPT[] =
 	"Shell options are:\n"
 	"  - history_path\n"
 	"  - history_max_size\n"
+	"  - capture_max_size\n"
+	"  - file_info_ttl\n"
 	"  - ignore_filenames\n"
 	"  - super_user_paths\n"
 	"  - trace\n"
 	"  - prefix_commands\n"
+	"  - fast_builtins\n"
 ;
 
 char const HELP_SOURCE[] =
@@ -966,6 +1039,20 @@ char const HELP_HISTORY_MAX_SIZE[] =
 	"Set maximum number of entries preserved in REPL's history.\n"
 ;
 
+char const HELP_CAPTURE_MAX_SIZE[] =
+	"%bsetopt%0 capture_max_size %ln%0\n\n"
+	"Set maximum number of bytes a command substitution may capture,\n"
+	"substitutions producing more output are aborted, %l0%0 means no limit.\n"
+;
+
+char const HELP_FILE_INFO_TTL[] =
+	"%bsetopt%0 file_info_ttl %lmilliseconds%0\n\n"
+	"Set for how long file system metadata used by syntax highlighting\n"
+	"and filename completions is cached, %l0%0 disables the cache.\n"
+	"Cache is always dropped after a command line is executed,\n"
+	"%bsetopt%0 %s--print%0 file_info_ttl also shows cache hit statistics.\n"
+;
+
 char const HELP_IGNORE_FILENAMES[] =
 	"%bsetopt%0 ignore_filenames re_pattern1 re_pattern2 ...\n\n"
 	"Ignore filenames matching following regular expression patterns\n"
@@ -990,6 +1077,12 @@ char const HELP_PREFIX_COMMANDS[] =
 	"%cenv%0 %asome_alias%0 param1 param2 ...\n"
 ;
 
+char const HELP_FAST_BUILTINS[] =
+	"%bsetopt%0 fast_builtins (%lon%0|%loff%0)\n\n"
+	"Run %cecho%0, %ctest%0, %c[%0, %ctrue%0, %cfalse%0, %cbasename%0, %cdirname%0 and %cprintf%0\n"
+	"inside the shell process instead of spawning their system counterparts.\n"
+;
+
 }
 
 void HSystemShell::help( OCommand& command_ ) {
@@ -1028,10 +1121,13 @@ void HSystemShell::help( OCommand& command_ ) {
 		{ "unsetenv", HELP_UNSETENV },
 		{ "history_path",     HELP_HISTORY_PATH },
 		{ "history_max_size", HELP_HISTORY_MAX_SIZE },
+		{ "capture_max_size", HELP_CAPTURE_MAX_SIZE },
+		{ "file_info_ttl",    HELP_FILE_INFO_TTL },
 		{ "ignore_filenames", HELP_IGNORE_FILENAMES },
 		{ "super_user_paths", HELP_SUPER_USER_PATHS },
 		{ "trace",            HELP_TRACE },
-		{ "prefix_commands",  HELP_PREFIX_COMMANDS }
+		{ "prefix_commands",  HELP_PREFIX_COMMANDS },
+		{ "fast_builtins",    HELP_FAST_BUILTINS }
 	};
 	for ( Help const& h : helpTopics ) {
 		if ( topic == h.topic ) {
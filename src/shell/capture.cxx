@@ -1,5 +1,7 @@
 /* Read huginn/LICENSE.md file for copyright and licensing information. */
 
+#include <cstring>
+
 #include <yaal/hcore/system.hxx>
 #include <yaal/hcore/hrawfile.hxx>
 
@@ -31,14 +33,47 @@ void permissive_close( HStreamInterface::ptr_t const& stream_ ) {
 	M_EPILOG
 }
 
+/*
+ * Size of the longest prefix of given data that does not end
+ * in the middle of UTF-8 encoded character.
+ */
+int long utf8_complete_size( char const* data_, int long size_ ) {
+	int long i( size_ );
+	for ( int back( 1 ); ( i > 0 ) && ( back <= 4 ); ++ back ) {
+		-- i;
+		u8_t byte( static_cast<u8_t>( data_[i] ) );
+		if ( ( byte & 0xc0 ) == 0x80 ) {
+			continue;
+		}
+		int len( byte < 0x80 ? 1 : ( byte >= 0xf0 ? 4 : ( byte >= 0xe0 ? 3 : 2 ) ) );
+		return ( back >= len ? size_ : i );
+	}
+	return ( size_ );
+}
+
+/*
+ * Number of bytes in UTF-8 encoded form of given string.
+ */
+int long utf8_size( HString const& str_ ) {
+	int long size( 0 );
+	for ( code_point_t cp : str_ ) {
+		u32_t v( cp.get() );
+		size += v < 0x80 ? 1 : ( v < 0x800 ? 2 : ( v < 0x10000 ? 3 : 4 ) );
+	}
+	return ( size );
+}
+
 }
 
-HSystemShell::HCapture::HCapture( QUOTES quotes_ )
+HSystemShell::HCapture::HCapture( QUOTES quotes_, int long maxSize_ )
 	: _pipe()
 	, _call()
 	, _thread()
 	, _buffer()
 	, _quotes( quotes_ )
+	, _maxSize( maxSize_ )
+	, _size( 0 )
+	, _overflow( false )
 	, _mutex() {
 	M_PROLOG
 	if ( quotes_ == QUOTES::EXEC ) {
@@ -95,30 +130,54 @@ void HSystemShell::HCapture::run( void ) {
 	M_EPILOG
 }
 
+/*
+ * Captured output is decoded block by block straight into the result string,
+ * the read block is reused so no second copy of the whole output is ever held.
+ */
 void HSystemShell::HCapture::task( void ) {
 	M_PROLOG
+	int long blockSize( system::get_page_size() * 16 );
 	HChunk c;
-	int long totalRead( 0 );
+	c.realloc( blockSize );
+	HString buffer;
+	HString block;
+	int long carry( 0 );
+	bool overflow( false );
 	try {
-		int long toRead( system::get_page_size() );
 		HStreamInterface::ptr_t outPtr( _pipe.out() );
 		HStreamInterface& out( *outPtr );
 		while ( true ) {
-			c.realloc( totalRead + toRead, HChunk::STRATEGY::EXACT );
-			int long nRead( out.read( c.get<char>() + totalRead, toRead ) );
+			char* data( c.get<char>() );
+			int long nRead( out.read( data + carry, blockSize - carry ) );
 			if ( nRead <= 0 ) {
 				break;
 			}
-			totalRead += nRead;
-			if ( nRead == toRead ) {
-				toRead *= 2;
+			/* scope for lock */ {
+				HLock l( _mutex );
+				_size += nRead;
+				overflow = ( _maxSize > 0 ) && ( _size > _maxSize );
 			}
+			if ( overflow ) {
+				permissive_close( outPtr );
+				break;
+			}
+			int long size( carry + nRead );
+			int long complete( utf8_complete_size( data, size ) );
+			block.assign( data, complete );
+			buffer.append( block );
+			carry = size - complete;
+			::memmove( data, data + complete, static_cast<size_t>( carry ) );
+		}
+		if ( ! overflow && ( carry > 0 ) ) {
+			block.assign( c.get<char>(), carry );
+			buffer.append( block );
 		}
 	} catch ( ... ) {
 		/* Ignore all exceptions cause we are in the thread. */
 	}
 	HLock l( _mutex );
-	_buffer.assign( c.get<char>(), totalRead );
+	_buffer = yaal::move( buffer );
+	_overflow = _overflow || overflow;
 	return;
 	M_EPILOG
 }
@@ -149,7 +208,13 @@ void HSystemShell::HCapture::append( yaal::hcore::HString const& str_ ) {
 	M_PROLOG
 	HLock l( _mutex );
 	if ( _quotes == QUOTES::EXEC ) {
-		_buffer.append( str_ );
+		int long size( _maxSize > 0 ? utf8_size( str_ ) : 0 );
+		if ( ( _maxSize > 0 ) && ( ( _size + size ) > _maxSize ) ) {
+			_overflow = true;
+		} else {
+			_size += size;
+			_buffer.append( str_ );
+		}
 	} else if ( _quotes == QUOTES::EXEC_SOURCE ) {
 		*const_cast<HStreamInterface*>( _pipe.in().get() ) << str_ << flush;
 	}
@@ -157,10 +222,15 @@ void HSystemShell::HCapture::append( yaal::hcore::HString const& str_ ) {
 	M_EPILOG
 }
 
-yaal::hcore::HString const& HSystemShell::HCapture::buffer( void ) {
+yaal::hcore::HString HSystemShell::HCapture::release_buffer( void ) {
+	M_PROLOG
 	HLock l( _mutex );
+	if ( _overflow ) {
+		throw HRuntimeException( "Captured output exceeds capture_max_size limit of "_ys.append( _maxSize ).append( " bytes!" ) );
+	}
 	_buffer.trim();
-	return ( _buffer );
+	return ( yaal::move( _buffer ) );
+	M_EPILOG
 }
 
 }
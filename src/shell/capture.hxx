@@ -15,9 +15,12 @@ private:
 	yaal::hcore::HThread _thread;
 	yaal::hcore::HString _buffer;
 	QUOTES _quotes;
+	int long _maxSize;
+	int long _size;
+	bool _overflow;
 	yaal::hcore::HMutex _mutex;
 public:
-	HCapture( QUOTES );
+	HCapture( QUOTES, int long = 0 );
 	virtual ~HCapture( void );
 	QUOTES quotes( void ) const {
 		return ( _quotes );
@@ -30,7 +33,7 @@ public:
 	yaal::hcore::HStreamInterface::ptr_t pipe_in( void ) const;
 	yaal::hcore::HStreamInterface::ptr_t pipe_out( void ) const;
 	void append( yaal::hcore::HString const& );
-	yaal::hcore::HString const& buffer( void );
+	yaal::hcore::HString release_buffer( void );
 };
 
 }
@@ -0,0 +1,185 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <cstring>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "channel.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+
+namespace huginn {
+
+HSystemShell::HChannel::HChannel( void )
+	: base_type()
+	, _slots()
+	, _free()
+	, _filled()
+	, _writeSlot( 0 )
+	, _writeSize( 0 )
+	, _writeAcquired( false )
+	, _writerClosed( false )
+	, _readSlot( 0 )
+	, _readPos( 0 )
+	, _readAcquired( false )
+	, _eof( false )
+	, _readerWaiting( false )
+	, _readerClosed( false ) {
+	M_PROLOG
+	for ( int i( 0 ); i < SLOT_COUNT; ++ i ) {
+		_free.signal();
+	}
+	return;
+	M_EPILOG
+}
+
+HSystemShell::HChannel::~HChannel( void ) {
+	M_PROLOG
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+bool HSystemShell::HChannel::acquire_write_slot( void ) {
+	M_PROLOG
+	if ( _writeAcquired ) {
+		return ( true );
+	}
+	if ( _readerClosed.load() ) {
+		return ( false );
+	}
+	_free.wait();
+	if ( _readerClosed.load() ) {
+		return ( false );
+	}
+	_writeAcquired = true;
+	_writeSize = 0;
+	return ( true );
+	M_EPILOG
+}
+
+void HSystemShell::HChannel::publish( void ) {
+	M_PROLOG
+	M_ASSERT( _writeAcquired );
+	_slots[_writeSlot]._size = _writeSize;
+	_writeAcquired = false;
+	_writeSlot = ( _writeSlot + 1 ) % SLOT_COUNT;
+	_filled.signal();
+	return;
+	M_EPILOG
+}
+
+int long HSystemShell::HChannel::do_write( void const* data_, int long size_ ) {
+	M_PROLOG
+	if ( _writerClosed ) {
+		return ( -1 );
+	}
+	char const* data( static_cast<char const*>( data_ ) );
+	int long written( 0 );
+	while ( written < size_ ) {
+		if ( ! acquire_write_slot() ) {
+			return ( -1 );
+		}
+		OSlot& slot( _slots[_writeSlot] );
+		if ( slot._data.get_size() < SLOT_SIZE ) {
+			slot._data.realloc( SLOT_SIZE );
+		}
+		int long chunk( min( size_ - written, SLOT_SIZE - _writeSize ) );
+		::memcpy( slot._data.get<char>() + _writeSize, data + written, static_cast<size_t>( chunk ) );
+		_writeSize += chunk;
+		written += chunk;
+		if ( _writeSize == SLOT_SIZE ) {
+			publish();
+		}
+	}
+	/*
+	 * Reader that starts waiting right after this check gets the data
+	 * with the next write or flush.
+	 */
+	if ( _writeAcquired && ( _writeSize > 0 ) && _readerWaiting.load() ) {
+		publish();
+	}
+	return ( written );
+	M_EPILOG
+}
+
+void HSystemShell::HChannel::do_flush( void ) {
+	M_PROLOG
+	if ( _writeAcquired && ( _writeSize > 0 ) ) {
+		publish();
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HChannel::close_write( void ) {
+	M_PROLOG
+	if ( _writerClosed ) {
+		return;
+	}
+	do_flush();
+	_writerClosed = true;
+	/* Empty block is the end-of-stream marker. */
+	if ( acquire_write_slot() ) {
+		_writeSize = 0;
+		publish();
+	}
+	return;
+	M_EPILOG
+}
+
+int long HSystemShell::HChannel::do_read( void* buffer_, int long size_ ) {
+	M_PROLOG
+	if ( _eof || _readerClosed.load() ) {
+		return ( 0 );
+	}
+	if ( ! _readAcquired ) {
+		_readerWaiting.store( true );
+		_filled.wait();
+		_readerWaiting.store( false );
+		_readAcquired = true;
+		_readPos = 0;
+	}
+	OSlot& slot( _slots[_readSlot] );
+	if ( slot._size == 0 ) {
+		_eof = true;
+		return ( 0 );
+	}
+	int long chunk( min( size_, slot._size - _readPos ) );
+	::memcpy( buffer_, slot._data.get<char>() + _readPos, static_cast<size_t>( chunk ) );
+	_readPos += chunk;
+	if ( _readPos == slot._size ) {
+		_readAcquired = false;
+		_readSlot = ( _readSlot + 1 ) % SLOT_COUNT;
+		_free.signal();
+	}
+	return ( chunk );
+	M_EPILOG
+}
+
+void HSystemShell::HChannel::close_read( void ) {
+	M_PROLOG
+	if ( _readerClosed.exchange( true ) ) {
+		return;
+	}
+	/* Wake up a writer blocked on a full ring so it can notice that nobody listens anymore. */
+	_free.signal();
+	return;
+	M_EPILOG
+}
+
+bool HSystemShell::HChannel::do_is_valid( void ) const {
+	return ( ! _readerClosed.load() );
+}
+
+HStreamInterface::POLL_TYPE HSystemShell::HChannel::do_poll_type( void ) const {
+	return ( POLL_TYPE::EMULATED );
+}
+
+void const* HSystemShell::HChannel::do_data( void ) const {
+	return ( this );
+}
+
+}
+
@@ -0,0 +1,73 @@
+#ifndef HUGINN_SHELL_CHANNEL_HXX_INCLUDED
+#define HUGINN_SHELL_CHANNEL_HXX_INCLUDED 1
+
+#include <atomic>
+
+#include <yaal/hcore/hchunk.hxx>
+#include <yaal/hcore/hthread.hxx>
+
+#include "src/systemshell.hxx"
+
+namespace huginn {
+
+/*! \brief In-process pipe between two stages of a job that both run inside the shell.
+ *
+ * Data is passed in fixed size blocks through a bounded single-producer/single-consumer ring.
+ * Each side owns its own cursor, ownership of a block is handed over with a pair of semaphores,
+ * so no lock is shared by the writer and the reader and no system call is made while
+ * the ring is neither full nor empty.
+ * A partly filled block is handed over early when the reader waits for data,
+ * so a slow producer (e.g. one printing progress lines) does not stall its consumer
+ * until a whole block accumulates.
+ * An empty block marks the end of the stream.
+ */
+class HSystemShell::HChannel : public yaal::hcore::HStreamInterface {
+public:
+	typedef HChannel this_type;
+	typedef yaal::hcore::HStreamInterface base_type;
+	static int const SLOT_COUNT = 8;
+	static int const SLOT_SIZE = 64 * 1024;
+private:
+	struct OSlot {
+		yaal::hcore::HChunk _data;
+		int long _size;
+		OSlot( void )
+			: _data()
+			, _size( 0 ) {
+		}
+	};
+	OSlot _slots[SLOT_COUNT];
+	yaal::hcore::HSemaphore _free;
+	yaal::hcore::HSemaphore _filled;
+	int _writeSlot;
+	int long _writeSize;
+	bool _writeAcquired;
+	bool _writerClosed;
+	int _readSlot;
+	int long _readPos;
+	bool _readAcquired;
+	bool _eof;
+	std::atomic<bool> _readerWaiting;
+	std::atomic<bool> _readerClosed;
+public:
+	HChannel( void );
+	virtual ~HChannel( void );
+	void close_write( void );
+	void close_read( void );
+private:
+	bool acquire_write_slot( void );
+	void publish( void );
+	virtual int long do_write( void const*, int long ) override;
+	virtual int long do_read( void*, int long ) override;
+	virtual void do_flush( void ) override;
+	virtual bool do_is_valid( void ) const override;
+	virtual POLL_TYPE do_poll_type( void ) const override;
+	virtual void const* do_data( void ) const override;
+	HChannel( HChannel const& ) = delete;
+	HChannel& operator = ( HChannel const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_CHANNEL_HXX_INCLUDED */
+
@@ -9,6 +9,7 @@ M_VCSID( "$Id: " __TID__ " $" )
 
 #include "src/systemshell.hxx"
 #include "command.hxx"
+#include "channel.hxx"
 #include "util.hxx"
 #include "src/prompt.hxx"
 #include "src/quotes.hxx"
@@ -67,7 +68,30 @@ void HSystemShell::OCommand::set_out_pipe( yaal::hcore::HPipe::ptr_t const& pipe
 	M_EPILOG
 }
 
-bool HSystemShell::OCommand::compile( EVALUATION_MODE evaluationMode_ ) {
+/*
+ * Replace OS pipe between two stages that both run inside the shell process
+ * with an in-process channel.
+ */
+void HSystemShell::OCommand::set_in_channel( OCommand& previous_ ) {
+	M_PROLOG
+	if ( ! _pipe || ! is_in_process() || ! previous_.is_in_process() ) {
+		return;
+	}
+	HStreamInterface const* pipeIn( _pipe->in().raw() );
+	channel_t channel( make_pointer<HChannel>() );
+	if ( previous_._out.raw() == pipeIn ) {
+		previous_._out = channel;
+	}
+	if ( previous_._err.raw() == pipeIn ) {
+		previous_._err = channel;
+	}
+	_in = channel;
+	_pipe.reset();
+	return;
+	M_EPILOG
+}
+
+bool HSystemShell::OCommand::compile( EVALUATION_MODE evaluationMode_, bool detached_ ) {
 	M_PROLOG
 	tokens_t::iterator it( _tokens.end() );
 	if ( ! _tokens.is_empty() && _systemShell.is_prefix_command( _tokens.front() ) ) {
@@ -95,7 +119,13 @@ bool HSystemShell::OCommand::compile( EVALUATION_MODE evaluationMode_ ) {
 		tokens = _systemShell.denormalize( _tokens, evaluationMode_, this );
 	}
 	_isShellCommand = ( ! tokens.is_empty() ) && _systemShell.is_command( tokens.front() );
-	if ( _isShellCommand && setup._shell->is_empty() && ( _systemShell.builtins().count( tokens.front() ) == 0 ) ) {
+	if (
+		_isShellCommand
+		&& (
+			_systemShell.is_core_util( tokens.front() )
+			|| ( setup._shell->is_empty() && ( _systemShell.builtins().count( tokens.front() ) == 0 ) )
+		)
+	) {
 		_tokens = tokens;
 	}
 	if ( _isShellCommand ) {
@@ -106,6 +136,10 @@ bool HSystemShell::OCommand::compile( EVALUATION_MODE evaluationMode_ ) {
 	}
 	unescape_huginn_command( *this );
 	HString line( string::join( _tokens, " " ) );
+	if ( detached_ ) {
+		_huginn = _systemShell.line_runner().detached( line );
+		return ( true );
+	}
 	if ( _systemShell.line_runner().add_line( line, _systemShell.loaded() ) ) {
 		return ( true );
 	}
@@ -185,13 +219,14 @@ bool HSystemShell::OCommand::spawn( int pgid_, bool foreground_, bool overwriteI
 			_tokens.push_back( "-c" );
 			_tokens.push_back( command );
 		}
-		_child = make_resource<HPipedChild>( _in, _closeOut ? _out : HStreamInterface::ptr_t(), _err );
+		_child = make_resource<HProcess>();
 		_child->spawn(
 			image,
 			_tokens,
-			! _in ? &cin : nullptr,
-			! _out ? &cout : ( ! _closeOut ? _out.raw() : nullptr ),
-			! _err ? &cerr : nullptr,
+			_in,
+			_out,
+			_err,
+			_closeOut,
 			pgid_,
 			foreground_ && setup._interactive
 		);
@@ -219,14 +254,15 @@ bool HSystemShell::OCommand::spawn( int pgid_, bool foreground_, bool overwriteI
 bool HSystemShell::OCommand::spawn_huginn( bool foreground_ ) {
 	M_PROLOG
 	HLineRunner& lr( _systemShell.line_runner() );
+	HHuginn* huginn( !! _huginn ? _huginn.raw() : lr.huginn() );
 	if ( !! _in ) {
-		lr.huginn()->set_input_stream( _in );
+		huginn->set_input_stream( _in );
 	}
 	if ( !! _out ) {
-		lr.huginn()->set_output_stream( _out );
+		huginn->set_output_stream( _out );
 	}
 	if ( !! _err ) {
-		lr.huginn()->set_error_stream( _err );
+		huginn->set_error_stream( _err );
 	}
 	if ( foreground_ ) {
 		run_huginn( lr );
@@ -253,8 +289,24 @@ yaal::tools::HPipedChild::STATUS HSystemShell::OCommand::run_builtin( builtin_t
 	M_EPILOG
 }
 
+void HSystemShell::OCommand::close_channels( void ) {
+	M_PROLOG
+	if ( HChannel* in = dynamic_cast<HChannel*>( _in.raw() ) ) {
+		in->close_read();
+	}
+	if ( HChannel* out = dynamic_cast<HChannel*>( _out.raw() ) ) {
+		out->close_write();
+	}
+	if ( HChannel* err = dynamic_cast<HChannel*>( _err.raw() ) ) {
+		err->close_write();
+	}
+	return;
+	M_EPILOG
+}
+
 void HSystemShell::OCommand::close_out( void ) {
 	M_PROLOG
+	close_channels();
 	HRawFile* fd( dynamic_cast<HRawFile*>( _out.raw() ) );
 	if ( _closeOut && fd && fd->is_valid() ) {
 		fd->close();
@@ -266,9 +318,10 @@ void HSystemShell::OCommand::close_out( void ) {
 
 yaal::tools::HPipedChild::STATUS HSystemShell::OCommand::run_huginn( HLineRunner& lineRunner_ ) {
 	M_PROLOG
-	HHuginn& huginn( *lineRunner_.huginn() );
+	HHuginn& huginn( !! _huginn ? *_huginn : *lineRunner_.huginn() );
 	try {
 		_status.type = HPipedChild::STATUS::TYPE::RUNNING;
+		HHuginn::value_t result;
 		if ( _isShellCommand ) {
 			HString functionName( _tokens.front() );
 			_tokens.erase( _tokens.begin() );
@@ -277,15 +330,24 @@ yaal::tools::HPipedChild::STATUS HSystemShell::OCommand::run_huginn( HLineRunner
 				values.push_back( huginn.value( t ) );
 			}
 			_huginnResult = lineRunner_.call( functionName, values, nullptr, false );
+		} else if ( !! _huginn ) {
+			/*
+			 * Value of a detached stage must not outlive its interpreter,
+			 * so it only decides about exit status.
+			 */
+			result = _huginn->execute() ? _huginn->result() : HHuginn::value_t();
 		} else {
 			_huginnResult = lineRunner_.execute();
 		}
-		if ( !! _huginnResult ) {
+		if ( ! _huginn ) {
+			result = _huginnResult;
+		}
+		if ( !! result ) {
 			_status.type = HPipedChild::STATUS::TYPE::FINISHED;
-			if ( _huginnResult->type_id() == HHuginn::TYPE::INTEGER ) {
-				_status.value = static_cast<int>( tools::huginn::get_integer( _huginnResult ) );
-			} else if ( _huginnResult->type_id() == HHuginn::TYPE::BOOLEAN ) {
-				_status.value = tools::huginn::get_boolean( _huginnResult ) ? 0 : 1;
+			if ( result->type_id() == HHuginn::TYPE::INTEGER ) {
+				_status.value = static_cast<int>( tools::huginn::get_integer( result ) );
+			} else if ( result->type_id() == HHuginn::TYPE::BOOLEAN ) {
+				_status.value = tools::huginn::get_boolean( result ) ? 0 : 1;
 			} else {
 				_status.value = 0;
 			}
@@ -299,6 +361,7 @@ yaal::tools::HPipedChild::STATUS HSystemShell::OCommand::run_huginn( HLineRunner
 		_status.type = HPipedChild::STATUS::TYPE::ABORTED;
 		_status.value = 1;
 	}
+	close_channels();
 	huginn.set_input_stream( cin );
 	huginn.set_output_stream( cout );
 	huginn.set_error_stream( cerr );
@@ -361,6 +424,10 @@ bool HSystemShell::OCommand::is_shell_command( void ) const {
 	return ( _isShellCommand );
 }
 
+bool HSystemShell::OCommand::is_in_process( void ) const {
+	return ( ! _isShellCommand || ( ! _tokens.is_empty() && ( _systemShell.builtins().count( _tokens.front() ) > 0 ) ) );
+}
+
 yaal::hcore::HString const& HSystemShell::OCommand::failure_message( void ) const {
 	return ( _failureMessage );
 }
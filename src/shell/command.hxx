@@ -7,6 +7,7 @@
 
 #include "src/systemshell.hxx"
 #include "src/shell/capture.hxx"
+#include "src/shell/process.hxx"
 
 namespace huginn {
 
@@ -20,10 +21,11 @@ struct HSystemShell::OCommand {
 	yaal::hcore::HStreamInterface::ptr_t _err;
 	tokens_t _tokens;
 	promise_t _promise;
-	piped_child_t _child;
+	process_t _child;
 	yaal::hcore::HPipe::ptr_t _pipe;
 	bool _isShellCommand;
 	bool _closeOut;
+	yaal::tools::HHuginn::ptr_t _huginn;
 	yaal::tools::HHuginn::value_t _huginnResult;
 	yaal::tools::HPipedChild::STATUS _status;
 	captures_t _captures;
@@ -39,6 +41,7 @@ struct HSystemShell::OCommand {
 		, _pipe()
 		, _isShellCommand( false )
 		, _closeOut( false )
+		, _huginn()
 		, _huginnResult()
 		, _status()
 		, _captures()
@@ -50,7 +53,12 @@ struct HSystemShell::OCommand {
 		*s << val_;
 		return ( *s );
 	}
-	bool compile( EVALUATION_MODE );
+	void write( void const* data_, int long size_ ) {
+		yaal::hcore::HStreamInterface* s( !! _out ? _out.raw() : &_systemShell.repl() );
+		s->write( data_, size_ );
+		s->flush();
+	}
+	bool compile( EVALUATION_MODE, bool );
 	bool spawn( int, bool, bool, bool, bool );
 	bool spawn_huginn( bool );
 	void add_capture( HSystemShell::capture_t const& capture_ ) {
@@ -63,13 +71,16 @@ struct HSystemShell::OCommand {
 	yaal::tools::HPipedChild::STATUS run_builtin( builtin_t const& );
 	yaal::tools::HPipedChild::STATUS finish( bool );
 	bool is_shell_command( void ) const;
+	bool is_in_process( void ) const;
 	yaal::hcore::HString const& failure_message( void ) const;
 	yaal::tools::HPipedChild::STATUS const& get_status( void );
 	void set_in_pipe( yaal::hcore::HPipe::ptr_t&& );
 	void set_out_pipe( yaal::hcore::HPipe::ptr_t const&, bool, bool );
+	void set_in_channel( OCommand& );
 private:
 	yaal::tools::HPipedChild::STATUS do_finish( void );
 	void close_out( void );
+	void close_channels( void );
 };
 
 }
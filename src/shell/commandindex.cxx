@@ -0,0 +1,283 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <cstdlib>
+
+#ifndef __MSVCXX__
+#	include <sys/stat.h>
+#endif
+
+#ifdef __HOST_OS_TYPE_LINUX__
+#	include <unistd.h>
+#	include <sys/inotify.h>
+#endif
+
+#include <yaal/hcore/hfile.hxx>
+#include <yaal/hcore/system.hxx>
+#include <yaal/tools/hfsitem.hxx>
+#include <yaal/tools/stringalgo.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "commandindex.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+using namespace yaal::tools::string;
+
+namespace huginn {
+
+namespace {
+
+char const FIELD_SEP[] = "\t";
+
+/*
+ * Modification time alone, with one second resolution, misses commands
+ * installed within the same second the directory was scanned in.
+ * Returns empty stamp iff path is not a directory.
+ */
+HString directory_stamp( yaal::tools::filesystem::path_t const& path_ ) {
+	M_PROLOG
+	HString stamp;
+#ifndef __MSVCXX__
+	HUTF8String utf8( path_ );
+	struct stat s;
+	if ( ( ::stat( utf8.c_str(), &s ) != 0 ) || ! S_ISDIR( s.st_mode ) ) {
+		return ( stamp );
+	}
+	i64_t const NS( 1000000000LL );
+#	ifdef __HOST_OS_TYPE_DARWIN__
+	i64_t modified( static_cast<i64_t>( s.st_mtimespec.tv_sec ) * NS + s.st_mtimespec.tv_nsec );
+	i64_t changed( static_cast<i64_t>( s.st_ctimespec.tv_sec ) * NS + s.st_ctimespec.tv_nsec );
+#	else
+	i64_t modified( static_cast<i64_t>( s.st_mtim.tv_sec ) * NS + s.st_mtim.tv_nsec );
+	i64_t changed( static_cast<i64_t>( s.st_ctim.tv_sec ) * NS + s.st_ctim.tv_nsec );
+#	endif
+	stamp.append( static_cast<int long long>( modified ) ).append( " " ).append( static_cast<int long long>( changed ) );
+#else
+	try {
+		HFSItem dir( path_ );
+		if ( ! dir || ! dir.is_directory() ) {
+			return ( stamp );
+		}
+		stamp.append( static_cast<int long long>( dir.modified().raw() ) );
+	} catch ( HFSItemException const& ) {
+	}
+#endif
+	return ( stamp );
+	M_EPILOG
+}
+
+}
+
+HSystemShell::HCommandIndex::HCommandIndex( void )
+	: _directories()
+	, _watches()
+	, _path()
+	, _inotify( -1 )
+	, _dirty( false ) {
+	M_PROLOG
+	char const* HOME( ::getenv( "HOME" ) );
+	if ( HOME ) {
+		_path.assign( HOME ).append( "/.cache/huginn/commands" );
+		load();
+	}
+#ifdef __HOST_OS_TYPE_LINUX__
+	_inotify = ::inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+#endif
+	return;
+	M_EPILOG
+}
+
+HSystemShell::HCommandIndex::~HCommandIndex( void ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	if ( _inotify >= 0 ) {
+		::close( _inotify );
+	}
+#endif
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+void HSystemShell::HCommandIndex::load( void ) {
+	M_PROLOG
+	try {
+		if ( ! filesystem::exists( _path ) ) {
+			return;
+		}
+		HFile f( _path, HFile::OPEN::READING );
+		if ( ! f ) {
+			return;
+		}
+		HString line;
+		while ( f.read_line( line ) >= 0 ) {
+			tokens_t fields( split<>( line, FIELD_SEP ) );
+			if ( fields.get_size() < 2 ) {
+				continue;
+			}
+			ODirectory& directory( _directories[fields[0]] );
+			directory._stamp = fields[1];
+			directory._commands.assign( fields.begin() + 2, fields.end() );
+		}
+	} catch ( HException const& ) {
+		/* Broken index is as good as no index at all. */
+		_directories.clear();
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HCommandIndex::save( void ) {
+	M_PROLOG
+	if ( ! _dirty || _path.is_empty() ) {
+		return;
+	}
+	try {
+		filesystem::create_directory( filesystem::dirname( _path ), DIRECTORY_MODIFICATION::RECURSIVE );
+		HString tmpPath( _path );
+		tmpPath.append( "." ).append( system::getpid() );
+		HFile f( tmpPath, HFile::OPEN::WRITING | HFile::OPEN::TRUNCATE );
+		if ( ! f ) {
+			return;
+		}
+		for ( directories_t::value_type const& directory : _directories ) {
+			if ( directory.second._stamp.is_empty() ) {
+				continue;
+			}
+			f << directory.first << FIELD_SEP << directory.second._stamp;
+			for ( HString const& command : directory.second._commands ) {
+				f << FIELD_SEP << command;
+			}
+			f << "\n";
+		}
+		f.close();
+		filesystem::rename( tmpPath, _path );
+		_dirty = false;
+	} catch ( HException const& ) {
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HCommandIndex::clear( void ) {
+	M_PROLOG
+	_directories.clear();
+	_dirty = true;
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HCommandIndex::learn( system_commands_t& commands_, yaal::tools::filesystem::paths_t const& paths_ ) {
+	M_PROLOG
+	changed();
+	for ( filesystem::path_t const& p : paths_ ) {
+		try {
+			HString stamp( directory_stamp( p ) );
+			if ( stamp.is_empty() ) {
+				continue;
+			}
+			ODirectory& directory( _directories[p] );
+			if ( directory._stamp != stamp ) {
+				scan( p, directory );
+				directory._stamp = stamp;
+				_dirty = true;
+			}
+			watch( p );
+			for ( HString const& command : directory._commands ) {
+				commands_[command] = p;
+			}
+		} catch ( HFSItemException const& ) {
+		}
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HCommandIndex::scan( yaal::tools::filesystem::path_t const& path_, ODirectory& directory_ ) {
+	M_PROLOG
+	directory_._commands.clear();
+	HFSItem dir( path_ );
+	for ( HFSItem const& file : dir ) {
+		HString name( file.get_name() );
+#ifndef __MSVCXX__
+		if ( ! ( file.is_executable() && file.is_file() ) ) {
+			continue;
+		}
+#else
+		name.lower();
+		HString ext( name.right( 4 ) );
+		if ( ( ext != ".exe" ) && ( ext != ".com" ) && ( ext != ".cmd" ) && ( ext != ".bat" ) ) {
+			continue;
+		}
+		name.erase( name.get_size() - 4 );
+#endif
+		directory_._commands.push_back( name );
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HCommandIndex::watch( yaal::tools::filesystem::path_t const& path_ ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	if ( _inotify < 0 ) {
+		return;
+	}
+	/* Adding a watch for already watched directory returns its existing descriptor. */
+	HUTF8String utf8( path_ );
+	int wd(
+		::inotify_add_watch(
+			_inotify,
+			utf8.c_str(),
+			IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF
+		)
+	);
+	if ( wd >= 0 ) {
+		_watches[wd] = path_;
+	}
+#else
+	static_cast<void>( path_ );
+#endif
+	return;
+	M_EPILOG
+}
+
+bool HSystemShell::HCommandIndex::changed( void ) {
+	M_PROLOG
+	bool hasChanges( false );
+#ifdef __HOST_OS_TYPE_LINUX__
+	if ( _inotify < 0 ) {
+		return ( false );
+	}
+	char buffer[4096] __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+	while ( true ) {
+		ssize_t len( ::read( _inotify, buffer, sizeof ( buffer ) ) );
+		if ( len <= 0 ) {
+			break;
+		}
+		for ( char const* p( buffer ); p < ( buffer + len ); ) {
+			inotify_event const* event( reinterpret_cast<inotify_event const*>( p ) );
+			p += sizeof ( inotify_event ) + event->len;
+			watches_t::iterator it( _watches.find( event->wd ) );
+			if ( it == _watches.end() ) {
+				continue;
+			}
+			directories_t::iterator directory( _directories.find( it->second ) );
+			if ( directory != _directories.end() ) {
+				directory->second._stamp.clear();
+			}
+			if ( ( event->mask & IN_IGNORED ) != 0 ) {
+				_watches.erase( it );
+			}
+			hasChanges = true;
+		}
+	}
+#endif
+	return ( hasChanges );
+	M_EPILOG
+}
+
+}
+
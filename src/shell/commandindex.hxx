@@ -0,0 +1,56 @@
+#ifndef HUGINN_SHELL_COMMANDINDEX_HXX_INCLUDED
+#define HUGINN_SHELL_COMMANDINDEX_HXX_INCLUDED 1
+
+#include <yaal/hcore/hhashmap.hxx>
+
+#include "src/systemshell.hxx"
+
+namespace huginn {
+
+/*! \brief Persistent index of executables found in directories from `PATH`.
+ *
+ * Directory listings are kept on disk together with the directory modification
+ * and status change times (in nanoseconds),
+ * so only directories that changed since the index was written are scanned again.
+ * On Linux directories are also watched with inotify so added or removed
+ * commands are noticed without manual `rehash`.
+ */
+class HSystemShell::HCommandIndex {
+public:
+	typedef yaal::hcore::HArray<yaal::hcore::HString> names_t;
+	struct ODirectory {
+		yaal::hcore::HString _stamp;
+		names_t _commands;
+		ODirectory( void )
+			: _stamp()
+			, _commands() {
+		}
+	};
+	typedef yaal::hcore::HHashMap<yaal::tools::filesystem::path_t, ODirectory> directories_t;
+	typedef yaal::hcore::HHashMap<int, yaal::tools::filesystem::path_t> watches_t;
+private:
+	directories_t _directories;
+	watches_t _watches;
+	yaal::tools::filesystem::path_t _path;
+	int _inotify;
+	bool _dirty;
+public:
+	HCommandIndex( void );
+	~HCommandIndex( void );
+	void learn( system_commands_t&, yaal::tools::filesystem::paths_t const& );
+	bool changed( void );
+	void clear( void );
+	void save( void );
+private:
+	void load( void );
+	void scan( yaal::tools::filesystem::path_t const&, ODirectory& );
+	void watch( yaal::tools::filesystem::path_t const& );
+private:
+	HCommandIndex( HCommandIndex const& ) = delete;
+	HCommandIndex& operator = ( HCommandIndex const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_COMMANDINDEX_HXX_INCLUDED */
+
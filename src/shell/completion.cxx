@@ -11,6 +11,7 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "src/quotes.hxx"
 #include "src/main.hxx"
 #include "util.hxx"
+#include "fileinfocache.hxx"
 #include "src/colorize.hxx"
 
 using namespace yaal;
@@ -144,8 +145,9 @@ void HSystemShell::filename_completions(
 		if ( prefix.is_empty() && ( name.front() == '.' ) ) {
 			continue;
 		}
-		bool isDirectory( f.is_directory() );
-		bool isExec( f.is_executable() );
+		HFileInfoCache::OFileInfo fileInfo( _fileInfoCache->info( path + name ) );
+		bool isDirectory( fileInfo._directory );
+		bool isExec( fileInfo._executable );
 		if ( ( filenameCompletions_ == FILENAME_COMPLETIONS::DIRECTORY ) && ! isDirectory ) {
 			continue;
 		}
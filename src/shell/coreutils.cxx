@@ -0,0 +1,821 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef __MSVCXX__
+#	include <unistd.h>
+#	include <sys/stat.h>
+#endif
+
+#include <yaal/hcore/hcore.hxx>
+#include <yaal/hcore/hchunk.hxx>
+#include <yaal/tools/hfsitem.hxx>
+#include <yaal/tools/hterminal.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "src/systemshell.hxx"
+#include "command.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+int digit_value( code_point_t cp_, int base_ ) {
+	int value( base_ );
+	switch ( cp_.get() ) {
+		case ( '0' ): case ( '1' ): case ( '2' ): case ( '3' ): case ( '4' ):
+		case ( '5' ): case ( '6' ): case ( '7' ): case ( '8' ): case ( '9' ): {
+			value = static_cast<int>( cp_.get() - '0' );
+		} break;
+		case ( 'a' ): case ( 'b' ): case ( 'c' ): case ( 'd' ): case ( 'e' ): case ( 'f' ): {
+			value = static_cast<int>( cp_.get() - 'a' ) + 10;
+		} break;
+		case ( 'A' ): case ( 'B' ): case ( 'C' ): case ( 'D' ): case ( 'E' ): case ( 'F' ): {
+			value = static_cast<int>( cp_.get() - 'A' ) + 10;
+		} break;
+	}
+	return ( value < base_ ? value : -1 );
+}
+
+/*
+ * Output of `echo` and `printf` is collected as raw bytes,
+ * numeric escapes (`\351`, `\xe9`) denote single bytes, not characters.
+ */
+typedef yaal::hcore::HArray<char> bytes_t;
+
+void append( bytes_t& out_, code_point_t cp_ ) {
+	u32_t v( cp_.get() );
+	if ( v < 0x80 ) {
+		out_.push_back( static_cast<char>( v ) );
+	} else if ( v < 0x800 ) {
+		out_.push_back( static_cast<char>( 0xc0 | ( v >> 6 ) ) );
+		out_.push_back( static_cast<char>( 0x80 | ( v & 0x3f ) ) );
+	} else if ( v < 0x10000 ) {
+		out_.push_back( static_cast<char>( 0xe0 | ( v >> 12 ) ) );
+		out_.push_back( static_cast<char>( 0x80 | ( ( v >> 6 ) & 0x3f ) ) );
+		out_.push_back( static_cast<char>( 0x80 | ( v & 0x3f ) ) );
+	} else {
+		out_.push_back( static_cast<char>( 0xf0 | ( v >> 18 ) ) );
+		out_.push_back( static_cast<char>( 0x80 | ( ( v >> 12 ) & 0x3f ) ) );
+		out_.push_back( static_cast<char>( 0x80 | ( ( v >> 6 ) & 0x3f ) ) );
+		out_.push_back( static_cast<char>( 0x80 | ( v & 0x3f ) ) );
+	}
+	return;
+}
+
+void append( bytes_t& out_, yaal::hcore::HString const& str_ ) {
+	HUTF8String utf8( str_ );
+	out_.insert( out_.end(), utf8.c_str(), utf8.c_str() + utf8.byte_count() );
+	return;
+}
+
+/*
+ * Expand escape sequence starting just after a backslash at `pos_`.
+ * `zeroOctal_` selects `\0NNN` octal form of `echo` and `printf %b`
+ * over `\NNN` form of `printf` format string.
+ * Returns position past the sequence or `npos` for `\c` (no further output).
+ */
+int long unescape_one( yaal::hcore::HString const& str_, int long pos_, bytes_t& out_, bool zeroOctal_ ) {
+	int long len( str_.get_length() );
+	code_point_t c( str_[pos_] );
+	++ pos_;
+	int base( 0 );
+	int maxDigits( 0 );
+	int value( 0 );
+	switch ( c.get() ) {
+		case ( 'a' ):  out_.push_back( '\a' ); break;
+		case ( 'b' ):  out_.push_back( '\b' ); break;
+		case ( 'f' ):  out_.push_back( '\f' ); break;
+		case ( 'n' ):  out_.push_back( '\n' ); break;
+		case ( 'r' ):  out_.push_back( '\r' ); break;
+		case ( 't' ):  out_.push_back( '\t' ); break;
+		case ( 'v' ):  out_.push_back( '\v' ); break;
+		case ( '\\' ): out_.push_back( '\\' ); break;
+		case ( 'c' ):  return ( HString::npos );
+		case ( 'x' ): {
+			base = 16;
+			maxDigits = 2;
+		} break;
+		default: {
+			if ( zeroOctal_ ? ( c == '0'_ycp ) : ( digit_value( c, 8 ) >= 0 ) ) {
+				base = 8;
+				maxDigits = 3;
+				if ( ! zeroOctal_ ) {
+					value = digit_value( c, 8 );
+					-- maxDigits;
+				}
+			} else {
+				out_.push_back( '\\' );
+				append( out_, c );
+			}
+		}
+	}
+	if ( base == 0 ) {
+		return ( pos_ );
+	}
+	int digits( 0 );
+	while ( ( digits < maxDigits ) && ( pos_ < len ) && ( digit_value( str_[pos_], base ) >= 0 ) ) {
+		value = value * base + digit_value( str_[pos_], base );
+		++ pos_;
+		++ digits;
+	}
+	if ( ( base == 16 ) && ( digits == 0 ) ) {
+		out_.push_back( '\\' );
+		out_.push_back( 'x' );
+	} else {
+		out_.push_back( static_cast<char>( value & 0xff ) );
+	}
+	return ( pos_ );
+}
+
+/*
+ * Returns false iff `\c` was found.
+ */
+bool unescape( yaal::hcore::HString const& str_, bytes_t& out_, bool zeroOctal_ ) {
+	int long len( str_.get_length() );
+	for ( int long i( 0 ); i < len; ) {
+		code_point_t c( str_[i] );
+		++ i;
+		if ( ( c != '\\'_ycp ) || ( i == len ) ) {
+			append( out_, c );
+			continue;
+		}
+		i = unescape_one( str_, i, out_, zeroOctal_ );
+		if ( i == HString::npos ) {
+			return ( false );
+		}
+	}
+	return ( true );
+}
+
+int long long to_integer( yaal::hcore::HString const& str_ ) {
+	M_PROLOG
+	HString s( str_ );
+	s.trim();
+	int long len( s.get_length() );
+	int long i( 0 );
+	if ( ( i < len ) && ( ( s[i] == '-'_ycp ) || ( s[i] == '+'_ycp ) ) ) {
+		++ i;
+	}
+	if ( i == len ) {
+		throw HRuntimeException( "integer expression expected: "_ys.append( str_ ) );
+	}
+	for ( ; i < len; ++ i ) {
+		if ( ! is_digit( s[i] ) ) {
+			throw HRuntimeException( "integer expression expected: "_ys.append( str_ ) );
+		}
+	}
+	return ( ::strtoll( HUTF8String( s ).c_str(), nullptr, 10 ) );
+	M_EPILOG
+}
+
+bool file_test( code_point_t op_, yaal::hcore::HString const& path_ ) {
+	M_PROLOG
+#ifndef __MSVCXX__
+	HUTF8String path( path_ );
+	struct stat s;
+	switch ( op_.get() ) {
+		case ( 'h' ):
+		case ( 'L' ): return ( ( ::lstat( path.c_str(), &s ) == 0 ) && S_ISLNK( s.st_mode ) );
+		case ( 'r' ): return ( ::access( path.c_str(), R_OK ) == 0 );
+		case ( 'w' ): return ( ::access( path.c_str(), W_OK ) == 0 );
+		case ( 'x' ): return ( ::access( path.c_str(), X_OK ) == 0 );
+	}
+	if ( ::stat( path.c_str(), &s ) != 0 ) {
+		return ( false );
+	}
+	switch ( op_.get() ) {
+		case ( 'e' ): return ( true );
+		case ( 'f' ): return ( S_ISREG( s.st_mode ) );
+		case ( 'd' ): return ( S_ISDIR( s.st_mode ) );
+		case ( 'b' ): return ( S_ISBLK( s.st_mode ) );
+		case ( 'c' ): return ( S_ISCHR( s.st_mode ) );
+		case ( 'p' ): return ( S_ISFIFO( s.st_mode ) );
+		case ( 'S' ): return ( S_ISSOCK( s.st_mode ) );
+		case ( 's' ): return ( s.st_size > 0 );
+		case ( 'g' ): return ( ( s.st_mode & S_ISGID ) != 0 );
+		case ( 'u' ): return ( ( s.st_mode & S_ISUID ) != 0 );
+	}
+#else
+	HFSItem fi( path_ );
+	if ( ! fi ) {
+		return ( false );
+	}
+	switch ( op_.get() ) {
+		case ( 'e' ): return ( true );
+		case ( 'r' ): return ( true );
+		case ( 'w' ): return ( true );
+		case ( 'f' ): return ( fi.is_file() );
+		case ( 'd' ): return ( fi.is_directory() );
+		case ( 'x' ): return ( fi.is_executable() );
+		case ( 's' ): return ( fi.get_size() > 0 );
+	}
+#endif
+	return ( false );
+	M_EPILOG
+}
+
+/*! \brief Evaluator for `test` and `[` expressions.
+ *
+ * Up to four arguments are disambiguated by their count as POSIX requires,
+ * longer expressions are parsed with `!`, `-a`, `-o` and parentheses
+ * in the usual precedence order.
+ */
+class HTestExpression {
+	HSystemShell::tokens_t const& _args;
+	int _pos;
+	int _end;
+public:
+	HTestExpression( HSystemShell::tokens_t const& args_ )
+		: _args( args_ )
+		, _pos( 0 )
+		, _end( 0 ) {
+	}
+	bool evaluate( int begin_, int end_ ) {
+		M_PROLOG
+		switch ( end_ - begin_ ) {
+			case ( 0 ): {
+				return ( false );
+			}
+			case ( 1 ): {
+				return ( ! _args[begin_].is_empty() );
+			}
+			case ( 2 ): {
+				if ( _args[begin_] == "!" ) {
+					return ( ! evaluate( begin_ + 1, end_ ) );
+				}
+				if ( is_unary( _args[begin_] ) ) {
+					return ( unary( _args[begin_], _args[begin_ + 1] ) );
+				}
+			} break;
+			case ( 3 ): {
+				if ( is_binary( _args[begin_ + 1] ) ) {
+					return ( binary( _args[begin_], _args[begin_ + 1], _args[begin_ + 2] ) );
+				}
+				if ( _args[begin_ + 1] == "-a" ) {
+					return ( ! _args[begin_].is_empty() && ! _args[begin_ + 2].is_empty() );
+				}
+				if ( _args[begin_ + 1] == "-o" ) {
+					return ( ! _args[begin_].is_empty() || ! _args[begin_ + 2].is_empty() );
+				}
+				if ( _args[begin_] == "!" ) {
+					return ( ! evaluate( begin_ + 1, end_ ) );
+				}
+				if ( ( _args[begin_] == "(" ) && ( _args[end_ - 1] == ")" ) ) {
+					return ( evaluate( begin_ + 1, end_ - 1 ) );
+				}
+			} break;
+			case ( 4 ): {
+				if ( _args[begin_] == "!" ) {
+					return ( ! evaluate( begin_ + 1, end_ ) );
+				}
+				if ( ( _args[begin_] == "(" ) && ( _args[end_ - 1] == ")" ) ) {
+					return ( evaluate( begin_ + 1, end_ - 1 ) );
+				}
+			} break;
+		}
+		_pos = begin_;
+		_end = end_;
+		bool result( disjunction() );
+		if ( _pos != _end ) {
+			throw HRuntimeException( "unexpected argument: `"_ys.append( _args[_pos] ).append( "`" ) );
+		}
+		return ( result );
+		M_EPILOG
+	}
+private:
+	bool disjunction( void ) {
+		M_PROLOG
+		bool result( conjunction() );
+		while ( ( _pos < _end ) && ( _args[_pos] == "-o" ) ) {
+			++ _pos;
+			bool rhs( conjunction() );
+			result = result || rhs;
+		}
+		return ( result );
+		M_EPILOG
+	}
+	bool conjunction( void ) {
+		M_PROLOG
+		bool result( negation() );
+		while ( ( _pos < _end ) && ( _args[_pos] == "-a" ) ) {
+			++ _pos;
+			bool rhs( negation() );
+			result = result && rhs;
+		}
+		return ( result );
+		M_EPILOG
+	}
+	bool negation( void ) {
+		M_PROLOG
+		if ( ( _pos < _end ) && ( _args[_pos] == "!" ) ) {
+			++ _pos;
+			return ( ! negation() );
+		}
+		return ( primary() );
+		M_EPILOG
+	}
+	bool primary( void ) {
+		M_PROLOG
+		if ( _pos >= _end ) {
+			throw HRuntimeException( "argument expected" );
+		}
+		HString const& arg( _args[_pos] );
+		bool result( false );
+		if ( ( ( _pos + 2 ) < _end ) && is_binary( _args[_pos + 1] ) ) {
+			result = binary( arg, _args[_pos + 1], _args[_pos + 2] );
+			_pos += 3;
+		} else if ( arg == "(" ) {
+			++ _pos;
+			result = disjunction();
+			if ( ( _pos >= _end ) || ( _args[_pos] != ")" ) ) {
+				throw HRuntimeException( "missing `)`" );
+			}
+			++ _pos;
+		} else if ( ( ( _pos + 1 ) < _end ) && is_unary( arg ) ) {
+			result = unary( arg, _args[_pos + 1] );
+			_pos += 2;
+		} else {
+			result = ! arg.is_empty();
+			++ _pos;
+		}
+		return ( result );
+		M_EPILOG
+	}
+	static bool is_unary( yaal::hcore::HString const& op_ ) {
+		return (
+			( op_.get_length() == 2 )
+			&& ( op_[0] == '-'_ycp )
+			&& ( HString( "bcdefghLnprSstuwxz" ).find( op_[1] ) != HString::npos )
+		);
+	}
+	static bool is_binary( yaal::hcore::HString const& op_ ) {
+		return (
+			( op_ == "=" ) || ( op_ == "==" ) || ( op_ == "!=" ) || ( op_ == "<" ) || ( op_ == ">" )
+			|| ( op_ == "-eq" ) || ( op_ == "-ne" ) || ( op_ == "-lt" )
+			|| ( op_ == "-le" ) || ( op_ == "-gt" ) || ( op_ == "-ge" )
+		);
+	}
+	static bool unary( yaal::hcore::HString const& op_, yaal::hcore::HString const& arg_ ) {
+		M_PROLOG
+		code_point_t op( op_[1] );
+		if ( op == 'n'_ycp ) {
+			return ( ! arg_.is_empty() );
+		} else if ( op == 'z'_ycp ) {
+			return ( arg_.is_empty() );
+		} else if ( op == 't'_ycp ) {
+			return ( is_a_tty( static_cast<int>( to_integer( arg_ ) ) ) );
+		}
+		return ( file_test( op, arg_ ) );
+		M_EPILOG
+	}
+	static bool binary( yaal::hcore::HString const& lhs_, yaal::hcore::HString const& op_, yaal::hcore::HString const& rhs_ ) {
+		M_PROLOG
+		if ( ( op_ == "=" ) || ( op_ == "==" ) ) {
+			return ( lhs_ == rhs_ );
+		} else if ( op_ == "!=" ) {
+			return ( lhs_ != rhs_ );
+		} else if ( op_ == "<" ) {
+			return ( lhs_ < rhs_ );
+		} else if ( op_ == ">" ) {
+			return ( rhs_ < lhs_ );
+		}
+		int long long lhs( to_integer( lhs_ ) );
+		int long long rhs( to_integer( rhs_ ) );
+		if ( op_ == "-eq" ) {
+			return ( lhs == rhs );
+		} else if ( op_ == "-ne" ) {
+			return ( lhs != rhs );
+		} else if ( op_ == "-lt" ) {
+			return ( lhs < rhs );
+		} else if ( op_ == "-le" ) {
+			return ( lhs <= rhs );
+		} else if ( op_ == "-gt" ) {
+			return ( lhs > rhs );
+		}
+		return ( lhs >= rhs );
+		M_EPILOG
+	}
+};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+template<typename T>
+yaal::hcore::HString c_format( yaal::hcore::HString const& spec_, T value_ ) {
+	M_PROLOG
+	HUTF8String spec( spec_ );
+	char buffer[256];
+	int size( ::snprintf( buffer, sizeof ( buffer ), spec.c_str(), value_ ) );
+	if ( size < 0 ) {
+		throw HRuntimeException( "invalid format: "_ys.append( spec_ ) );
+	}
+	if ( size < static_cast<int>( sizeof ( buffer ) ) ) {
+		return ( buffer );
+	}
+	HChunk big;
+	big.realloc( size + 1 );
+	::snprintf( big.get<char>(), static_cast<size_t>( size + 1 ), spec.c_str(), value_ );
+	return ( big.get<char>() );
+	M_EPILOG
+}
+#pragma GCC diagnostic pop
+
+/*! \brief POSIX `printf` formatter.
+ *
+ * Format is reused until all arguments are consumed,
+ * missing arguments are treated as empty strings or zeros.
+ */
+class HPrintf {
+	HSystemShell::tokens_t const& _args;
+	int _argIdx;
+	bytes_t _out;
+	HString _errors;
+public:
+	HPrintf( HSystemShell::tokens_t const& args_, int firstArg_ )
+		: _args( args_ )
+		, _argIdx( firstArg_ )
+		, _out()
+		, _errors() {
+	}
+	void format( yaal::hcore::HString const& format_ ) {
+		M_PROLOG
+		int argCount( static_cast<int>( _args.get_size() ) );
+		int used( 0 );
+		do {
+			used = _argIdx;
+			if ( ! format_once( format_ ) ) {
+				break;
+			}
+		} while ( ( _argIdx < argCount ) && ( _argIdx > used ) );
+		return;
+		M_EPILOG
+	}
+	bytes_t const& output( void ) const {
+		return ( _out );
+	}
+	yaal::hcore::HString const& errors( void ) const {
+		return ( _errors );
+	}
+private:
+	yaal::hcore::HString const& next_argument( void ) {
+		static HString const none;
+		return ( _argIdx < static_cast<int>( _args.get_size() ) ? _args[_argIdx ++] : none );
+	}
+	int long long next_integer( void ) {
+		M_PROLOG
+		HString const& arg( next_argument() );
+		if ( arg.is_empty() ) {
+			return ( 0 );
+		}
+		if ( ( arg[0] == '\''_ycp ) || ( arg[0] == '"'_ycp ) ) {
+			return ( arg.get_length() > 1 ? static_cast<int long long>( arg[1].get() ) : 0 );
+		}
+		HUTF8String utf8( arg );
+		char* end( nullptr );
+		int long long value( ::strtoll( utf8.c_str(), &end, 0 ) );
+		if ( *end ) {
+			_errors.append( _errors.is_empty() ? "" : "\n" ).append( "printf: invalid number: " ).append( arg );
+		}
+		return ( value );
+		M_EPILOG
+	}
+	double next_real( void ) {
+		M_PROLOG
+		HString const& arg( next_argument() );
+		if ( arg.is_empty() ) {
+			return ( 0 );
+		}
+		if ( ( arg[0] == '\''_ycp ) || ( arg[0] == '"'_ycp ) ) {
+			return ( arg.get_length() > 1 ? static_cast<double>( arg[1].get() ) : 0 );
+		}
+		HUTF8String utf8( arg );
+		char* end( nullptr );
+		double value( ::strtod( utf8.c_str(), &end ) );
+		if ( *end ) {
+			_errors.append( _errors.is_empty() ? "" : "\n" ).append( "printf: invalid number: " ).append( arg );
+		}
+		return ( value );
+		M_EPILOG
+	}
+	/*
+	 * Width and precision count bytes, as in C printf.
+	 */
+	void put( bytes_t const& str_, bool leftAlign_, int width_, int precision_ ) {
+		M_PROLOG
+		int long len( str_.get_size() );
+		if ( ( precision_ >= 0 ) && ( len > precision_ ) ) {
+			len = precision_;
+		}
+		int long fill( width_ - len );
+		for ( int long i( 0 ); ! leftAlign_ && ( i < fill ); ++ i ) {
+			_out.push_back( ' ' );
+		}
+		_out.insert( _out.end(), str_.begin(), str_.begin() + len );
+		for ( int long i( 0 ); leftAlign_ && ( i < fill ); ++ i ) {
+			_out.push_back( ' ' );
+		}
+		return;
+		M_EPILOG
+	}
+	int number( yaal::hcore::HString const& format_, int long& pos_ ) {
+		M_PROLOG
+		if ( ( pos_ < format_.get_length() ) && ( format_[pos_] == '*'_ycp ) ) {
+			++ pos_;
+			return ( static_cast<int>( next_integer() ) );
+		}
+		int value( 0 );
+		while ( ( pos_ < format_.get_length() ) && is_digit( format_[pos_] ) ) {
+			value = value * 10 + digit_value( format_[pos_], 10 );
+			++ pos_;
+		}
+		return ( value );
+		M_EPILOG
+	}
+	/*
+	 * Returns false iff output was stopped with `\c`.
+	 */
+	bool format_once( yaal::hcore::HString const& format_ ) {
+		M_PROLOG
+		int long len( format_.get_length() );
+		for ( int long i( 0 ); i < len; ) {
+			code_point_t c( format_[i] );
+			++ i;
+			if ( ( c == '\\'_ycp ) && ( i < len ) ) {
+				i = unescape_one( format_, i, _out, false );
+				if ( i == HString::npos ) {
+					return ( false );
+				}
+				continue;
+			}
+			if ( c != '%'_ycp ) {
+				append( _out, c );
+				continue;
+			}
+			if ( i == len ) {
+				throw HRuntimeException( "printf: `%': missing format character" );
+			}
+			if ( format_[i] == '%'_ycp ) {
+				_out.push_back( '%' );
+				++ i;
+				continue;
+			}
+			HString flags;
+			while ( ( i < len ) && ( HString( "-+ #0" ).find( format_[i] ) != HString::npos ) ) {
+				flags.push_back( format_[i] );
+				++ i;
+			}
+			bool hasWidth( ( i < len ) && ( is_digit( format_[i] ) || ( format_[i] == '*'_ycp ) ) );
+			int width( number( format_, i ) );
+			int precision( -1 );
+			if ( ( i < len ) && ( format_[i] == '.'_ycp ) ) {
+				++ i;
+				precision = number( format_, i );
+			}
+			if ( i == len ) {
+				throw HRuntimeException( "printf: missing format character" );
+			}
+			code_point_t conversion( format_[i] );
+			++ i;
+			bool leftAlign( ( flags.find( '-'_ycp ) != HString::npos ) || ( width < 0 ) );
+			if ( width < 0 ) {
+				width = -width;
+			}
+			HString spec( "%" );
+			spec.append( flags );
+			if ( hasWidth ) {
+				spec.append( width );
+			}
+			if ( precision >= 0 ) {
+				spec.append( "." ).append( precision );
+			}
+			switch ( conversion.get() ) {
+				case ( 's' ): {
+					bytes_t arg;
+					append( arg, next_argument() );
+					put( arg, leftAlign, width, precision );
+				} break;
+				case ( 'b' ): {
+					bytes_t expanded;
+					bool more( unescape( next_argument(), expanded, true ) );
+					put( expanded, leftAlign, width, precision );
+					if ( ! more ) {
+						return ( false );
+					}
+				} break;
+				case ( 'c' ): {
+					bytes_t arg;
+					append( arg, next_argument().left( 1 ) );
+					put( arg, leftAlign, width, -1 );
+				} break;
+				case ( 'd' ):
+				case ( 'i' ): {
+					append( _out, c_format( spec.append( "ll" ).append( conversion ), next_integer() ) );
+				} break;
+				case ( 'o' ):
+				case ( 'u' ):
+				case ( 'x' ):
+				case ( 'X' ): {
+					append( _out, c_format( spec.append( "ll" ).append( conversion ), static_cast<int long long unsigned>( next_integer() ) ) );
+				} break;
+				case ( 'a' ): case ( 'A' ):
+				case ( 'e' ): case ( 'E' ):
+				case ( 'f' ): case ( 'F' ):
+				case ( 'g' ): case ( 'G' ): {
+					append( _out, c_format( spec.append( conversion ), next_real() ) );
+				} break;
+				default: {
+					throw HRuntimeException( "printf: invalid conversion specification: %"_ys.push_back( conversion ) );
+				}
+			}
+		}
+		return ( true );
+		M_EPILOG
+	}
+};
+
+yaal::hcore::HString base_name( yaal::hcore::HString path_, yaal::hcore::HString const& suffix_ ) {
+	M_PROLOG
+	if ( path_.is_empty() ) {
+		return ( path_ );
+	}
+	path_.trim_right( "/" );
+	if ( path_.is_empty() ) {
+		return ( "/" );
+	}
+	int long slashIdx( path_.find_last( '/'_ycp ) );
+	if ( slashIdx != HString::npos ) {
+		path_.shift_left( slashIdx + 1 );
+	}
+	if ( ! suffix_.is_empty() && ( path_ != suffix_ ) && path_.ends_with( suffix_ ) ) {
+		path_ = path_.left( path_.get_length() - suffix_.get_length() );
+	}
+	return ( path_ );
+	M_EPILOG
+}
+
+yaal::hcore::HString dir_name( yaal::hcore::HString path_ ) {
+	M_PROLOG
+	if ( path_.is_empty() ) {
+		return ( "." );
+	}
+	path_.trim_right( "/" );
+	if ( path_.is_empty() ) {
+		return ( "/" );
+	}
+	int long slashIdx( path_.find_last( '/'_ycp ) );
+	if ( slashIdx == HString::npos ) {
+		return ( "." );
+	}
+	path_ = path_.left( slashIdx );
+	path_.trim_right( "/" );
+	if ( path_.is_empty() ) {
+		return ( "/" );
+	}
+	return ( path_ );
+	M_EPILOG
+}
+
+}
+
+/*
+ * In-process replacements for the most common tiny system commands,
+ * enabled with `setopt fast_builtins on`.
+ * They receive fully expanded arguments, just as their system counterparts would.
+ */
+
+void HSystemShell::core_echo( OCommand& command_ ) {
+	M_PROLOG
+	tokens_t const& args( command_._tokens );
+	int argCount( static_cast<int>( args.get_size() ) );
+	bool newLine( true );
+	bool escapes( false );
+	int argIdx( 1 );
+	for ( ; argIdx < argCount; ++ argIdx ) {
+		HString const& arg( args[argIdx] );
+		if ( ( arg.get_length() < 2 ) || ( arg.front() != '-'_ycp ) || ( arg.find_other_than( "neE", 1 ) != HString::npos ) ) {
+			break;
+		}
+		for ( code_point_t c : arg ) {
+			if ( c == 'n'_ycp ) {
+				newLine = false;
+			} else if ( c == 'e'_ycp ) {
+				escapes = true;
+			} else if ( c == 'E'_ycp ) {
+				escapes = false;
+			}
+		}
+	}
+	bytes_t out;
+	for ( int i( argIdx ); i < argCount; ++ i ) {
+		if ( i > argIdx ) {
+			out.push_back( ' ' );
+		}
+		if ( ! escapes ) {
+			append( out, args[i] );
+		} else if ( ! unescape( args[i], out, true ) ) {
+			newLine = false;
+			break;
+		}
+	}
+	if ( newLine ) {
+		out.push_back( '\n' );
+	}
+	command_.write( out.data(), out.get_size() );
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::core_test( OCommand& command_ ) {
+	M_PROLOG
+	tokens_t const& args( command_._tokens );
+	int end( static_cast<int>( args.get_size() ) );
+	HString const& name( args.front() );
+	try {
+		if ( name == "[" ) {
+			if ( ( end < 2 ) || ( args.back() != "]" ) ) {
+				throw HRuntimeException( "missing `]`" );
+			}
+			-- end;
+		}
+		command_._status.value = HTestExpression( args ).evaluate( 1, end ) ? 0 : 1;
+	} catch ( HException const& e ) {
+		command_._failureMessage.assign( name ).append( ": " ).append( e.what() );
+		command_._status.value = 2;
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::core_true( OCommand& ) {
+	return;
+}
+
+void HSystemShell::core_false( OCommand& command_ ) {
+	command_._status.value = 1;
+	return;
+}
+
+void HSystemShell::core_basename( OCommand& command_ ) {
+	M_PROLOG
+	tokens_t const& args( command_._tokens );
+	int argIdx( ( args.get_size() > 1 ) && ( args[1] == "--" ) ? 2 : 1 );
+	int argCount( static_cast<int>( args.get_size() ) - argIdx );
+	if ( argCount < 1 ) {
+		throw HRuntimeException( "basename: Missing operand!" );
+	}
+	if ( argCount > 2 ) {
+		throw HRuntimeException( "basename: Too many arguments!" );
+	}
+	command_ << base_name( args[argIdx], argCount > 1 ? args[argIdx + 1] : HString() ) << endl;
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::core_dirname( OCommand& command_ ) {
+	M_PROLOG
+	tokens_t const& args( command_._tokens );
+	int argIdx( ( args.get_size() > 1 ) && ( args[1] == "--" ) ? 2 : 1 );
+	int argCount( static_cast<int>( args.get_size() ) - argIdx );
+	if ( argCount < 1 ) {
+		throw HRuntimeException( "dirname: Missing operand!" );
+	}
+	if ( argCount > 1 ) {
+		throw HRuntimeException( "dirname: Too many arguments!" );
+	}
+	command_ << dir_name( args[argIdx] ) << endl;
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::core_printf( OCommand& command_ ) {
+	M_PROLOG
+	tokens_t const& args( command_._tokens );
+	int argIdx( ( args.get_size() > 1 ) && ( args[1] == "--" ) ? 2 : 1 );
+	if ( argIdx >= static_cast<int>( args.get_size() ) ) {
+		throw HRuntimeException( "printf: Missing format!" );
+	}
+	HPrintf formatter( args, argIdx + 1 );
+	try {
+		formatter.format( args[argIdx] );
+	} catch ( ... ) {
+		command_.write( formatter.output().data(), formatter.output().get_size() );
+		throw;
+	}
+	command_.write( formatter.output().data(), formatter.output().get_size() );
+	if ( ! formatter.errors().is_empty() ) {
+		command_._failureMessage.assign( formatter.errors() );
+		command_._status.value = 1;
+	}
+	return;
+	M_EPILOG
+}
+
+}
+
@@ -0,0 +1,107 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <yaal/tools/hfsitem.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "fileinfocache.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+HSystemShell::HFileInfoCache::HFileInfoCache( void )
+	: _fileInfos()
+	, _clock()
+	, _ttl( DEFAULT_TTL )
+	, _hits( 0 )
+	, _misses( 0 )
+	, _mutex() {
+	return;
+}
+
+HSystemShell::HFileInfoCache::OFileInfo HSystemShell::HFileInfoCache::query( yaal::tools::filesystem::path_t const& path_ ) {
+	M_PROLOG
+	OFileInfo fileInfo;
+	try {
+		fileInfo._type = filesystem::file_type( path_ );
+		fileInfo._exists = true;
+	} catch ( HException const& ) {
+		return ( fileInfo );
+	}
+	try {
+		HFSItem fsItem( path_ );
+		if ( !! fsItem ) {
+			fileInfo._directory = fsItem.is_directory();
+			fileInfo._executable = fsItem.is_executable();
+			fileInfo._suid = ! fileInfo._directory && fileInfo._executable && ( ( fsItem.get_permissions() & 06000 ) != 0 );
+		}
+	} catch ( HException const& ) {
+		/* Dangling symbolic link. */
+	}
+	return ( fileInfo );
+	M_EPILOG
+}
+
+HSystemShell::HFileInfoCache::OFileInfo HSystemShell::HFileInfoCache::info( yaal::tools::filesystem::path_t const& path_ ) const {
+	M_PROLOG
+	if ( _ttl <= 0 ) {
+		return ( query( path_ ) );
+	}
+	HLock l( _mutex );
+	i64_t now( _clock.get_time_elapsed( time::UNIT::MILLISECOND ) );
+	file_infos_t::const_iterator it( _fileInfos.find( path_ ) );
+	if ( ( it != _fileInfos.end() ) && ( ( now - it->second._stamp ) < _ttl ) ) {
+		++ _hits;
+		return ( it->second );
+	}
+	++ _misses;
+	if ( _fileInfos.get_size() >= MAX_ENTRIES ) {
+		_fileInfos.clear();
+	}
+	OFileInfo fileInfo( query( path_ ) );
+	fileInfo._stamp = now;
+	_fileInfos[path_] = fileInfo;
+	return ( fileInfo );
+	M_EPILOG
+}
+
+void HSystemShell::HFileInfoCache::invalidate( void ) {
+	M_PROLOG
+	HLock l( _mutex );
+	_fileInfos.clear();
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HFileInfoCache::set_ttl( int long ttl_ ) {
+	M_PROLOG
+	HLock l( _mutex );
+	_ttl = ttl_;
+	_fileInfos.clear();
+	return;
+	M_EPILOG
+}
+
+int long HSystemShell::HFileInfoCache::ttl( void ) const {
+	return ( _ttl );
+}
+
+yaal::hcore::HString HSystemShell::HFileInfoCache::stats( void ) const {
+	M_PROLOG
+	HLock l( _mutex );
+	i64_t lookups( _hits + _misses );
+	HString s( "hits: " );
+	s.append( to_string( _hits ) )
+		.append( ", misses: " ).append( to_string( _misses ) )
+		.append( ", hit rate: " ).append( to_string( lookups > 0 ? ( _hits * 100 ) / lookups : 0 ) ).append( "%" )
+		.append( ", entries: " ).append( to_string( _fileInfos.get_size() ) );
+	return ( s );
+	M_EPILOG
+}
+
+}
+
@@ -0,0 +1,64 @@
+#ifndef HUGINN_SHELL_FILEINFOCACHE_HXX_INCLUDED
+#define HUGINN_SHELL_FILEINFOCACHE_HXX_INCLUDED 1
+
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hclock.hxx>
+#include <yaal/hcore/hthread.hxx>
+
+#include "src/systemshell.hxx"
+
+namespace huginn {
+
+/*! \brief Short lived cache of file system metadata used while editing shell input.
+ *
+ * Syntax highlighting and filename completions ask about the same paths
+ * on every keystroke, on slow or remote file systems each of those questions
+ * is several round trips.
+ * Entries live for one edit session (the cache is dropped after each executed line)
+ * and for at most `ttl` milliseconds, so changes made by other processes are noticed too.
+ */
+class HSystemShell::HFileInfoCache {
+public:
+	struct OFileInfo {
+		bool _exists;
+		yaal::tools::filesystem::FILE_TYPE _type;
+		bool _directory;
+		bool _executable;
+		bool _suid;
+		yaal::i64_t _stamp;
+		OFileInfo( void )
+			: _exists( false )
+			, _type( yaal::tools::filesystem::FILE_TYPE::REGULAR )
+			, _directory( false )
+			, _executable( false )
+			, _suid( false )
+			, _stamp( 0 ) {
+		}
+	};
+	typedef yaal::hcore::HHashMap<yaal::tools::filesystem::path_t, OFileInfo> file_infos_t;
+	static int const MAX_ENTRIES = 4096;
+	static int long const DEFAULT_TTL = 2000;
+private:
+	mutable file_infos_t _fileInfos;
+	mutable yaal::hcore::HClock _clock;
+	int long _ttl;
+	mutable yaal::i64_t _hits;
+	mutable yaal::i64_t _misses;
+	mutable yaal::hcore::HMutex _mutex;
+public:
+	HFileInfoCache( void );
+	OFileInfo info( yaal::tools::filesystem::path_t const& ) const;
+	void invalidate( void );
+	void set_ttl( int long );
+	int long ttl( void ) const;
+	yaal::hcore::HString stats( void ) const;
+private:
+	static OFileInfo query( yaal::tools::filesystem::path_t const& );
+	HFileInfoCache( HFileInfoCache const& ) = delete;
+	HFileInfoCache& operator = ( HFileInfoCache const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_FILEINFOCACHE_HXX_INCLUDED */
+
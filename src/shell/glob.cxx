@@ -0,0 +1,438 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#ifdef __HOST_OS_TYPE_LINUX__
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <dirent.h>
+#	include <sys/syscall.h>
+#endif
+
+#include <yaal/hcore/algorithm.hxx>
+#include <yaal/tools/hfsitem.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "glob.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+char const RECURSIVE[] = "**";
+
+/*
+ * Kernel is asked for as many directory entries as fit in this buffer at once.
+ */
+int const LISTING_BUFFER_SIZE = 32 * 1024;
+
+bool is_special( code_point_t c_ ) {
+	return ( ( c_ == '*' ) || ( c_ == '?' ) || ( c_ == '[' ) );
+}
+
+bool has_wildcard( yaal::hcore::HString const& component_ ) {
+	bool escaped( false );
+	for ( code_point_t c : component_ ) {
+		if ( escaped ) {
+			escaped = false;
+		} else if ( c == '\\' ) {
+			escaped = true;
+		} else if ( is_special( c ) ) {
+			return ( true );
+		}
+	}
+	return ( false );
+}
+
+yaal::hcore::HString unescape_literal( yaal::hcore::HString const& component_ ) {
+	HString literal;
+	bool escaped( false );
+	for ( code_point_t c : component_ ) {
+		if ( ! escaped && ( c == '\\' ) ) {
+			escaped = true;
+			continue;
+		}
+		escaped = false;
+		literal.push_back( c );
+	}
+	return ( literal );
+}
+
+/*
+ * Match character `c_` against bracket expression starting at `pattern_[pos_]`.
+ * Returns position past the closing bracket or -1 if bracket expression is not terminated,
+ * in which case opening bracket is an ordinary character.
+ */
+int match_class( yaal::hcore::HString const& pattern_, int pos_, code_point_t c_, bool& matched_ ) {
+	int len( static_cast<int>( pattern_.get_length() ) );
+	int i( pos_ + 1 );
+	bool negate( false );
+	if ( ( i < len ) && ( ( pattern_[i] == '!' ) || ( pattern_[i] == '^' ) ) ) {
+		negate = true;
+		++ i;
+	}
+	bool matched( false );
+	bool first( true );
+	while ( i < len ) {
+		code_point_t lo( pattern_[i] );
+		if ( ( lo == ']' ) && ! first ) {
+			matched_ = matched != negate;
+			return ( i + 1 );
+		}
+		first = false;
+		if ( ( lo == '\\' ) && ( ( i + 1 ) < len ) ) {
+			++ i;
+			lo = pattern_[i];
+		}
+		++ i;
+		code_point_t hi( lo );
+		if ( ( ( i + 1 ) < len ) && ( pattern_[i] == '-' ) && ( pattern_[i + 1] != ']' ) ) {
+			i += 1;
+			if ( ( pattern_[i] == '\\' ) && ( ( i + 1 ) < len ) ) {
+				++ i;
+			}
+			hi = pattern_[i];
+			++ i;
+		}
+		if ( ( c_.get() >= lo.get() ) && ( c_.get() <= hi.get() ) ) {
+			matched = true;
+		}
+	}
+	return ( -1 );
+}
+
+/*
+ * Iterative wildcard matcher, on mismatch it backtracks to the most recent `*`
+ * so matching is linear in the common case and never recursive.
+ */
+bool match( yaal::hcore::HString const& pattern_, yaal::hcore::HString const& name_ ) {
+	int patternLen( static_cast<int>( pattern_.get_length() ) );
+	int nameLen( static_cast<int>( name_.get_length() ) );
+	int p( 0 );
+	int n( 0 );
+	int starP( -1 );
+	int starN( 0 );
+	while ( n < nameLen ) {
+		bool advanced( false );
+		if ( p < patternLen ) {
+			code_point_t pc( pattern_[p] );
+			if ( pc == '*' ) {
+				starP = p;
+				starN = n;
+				++ p;
+				continue;
+			} else if ( pc == '?' ) {
+				++ p;
+				advanced = true;
+			} else if ( pc == '[' ) {
+				bool matched( false );
+				int next( match_class( pattern_, p, name_[n], matched ) );
+				if ( next >= 0 ) {
+					if ( matched ) {
+						p = next;
+						advanced = true;
+					}
+				} else if ( name_[n] == '[' ) {
+					++ p;
+					advanced = true;
+				}
+			} else {
+				int skip( 1 );
+				if ( ( pc == '\\' ) && ( ( p + 1 ) < patternLen ) ) {
+					pc = pattern_[p + 1];
+					skip = 2;
+				}
+				if ( pc == name_[n] ) {
+					p += skip;
+					advanced = true;
+				}
+			}
+		}
+		if ( advanced ) {
+			++ n;
+			continue;
+		}
+		if ( starP < 0 ) {
+			return ( false );
+		}
+		p = starP + 1;
+		++ starN;
+		n = starN;
+	}
+	while ( ( p < patternLen ) && ( pattern_[p] == '*' ) ) {
+		++ p;
+	}
+	return ( p == patternLen );
+}
+
+yaal::tools::filesystem::path_t join( yaal::tools::filesystem::path_t const& dir_, yaal::hcore::HString const& name_ ) {
+	if ( dir_.is_empty() ) {
+		return ( name_ );
+	}
+	filesystem::path_t path( dir_ );
+	if ( path.back() != '/' ) {
+		path.push_back( '/'_ycp );
+	}
+	path.append( name_ );
+	return ( path );
+}
+
+HSystemShell::HGlob::TYPE probe( yaal::tools::filesystem::path_t const& path_ ) {
+	try {
+		filesystem::FILE_TYPE type( filesystem::file_type( path_ ) );
+		if ( type == filesystem::FILE_TYPE::SYMBOLIC_LINK ) {
+			return ( HSystemShell::HGlob::TYPE::LINK );
+		} else if ( type == filesystem::FILE_TYPE::DIRECTORY ) {
+			return ( HSystemShell::HGlob::TYPE::DIRECTORY );
+		}
+	} catch ( HException const& ) {
+		/* Entry vanished after it was listed. */
+	}
+	return ( HSystemShell::HGlob::TYPE::OTHER );
+}
+
+bool is_directory( HSystemShell::HGlob::OEntry const& entry_, yaal::tools::filesystem::path_t const& path_ ) {
+	if ( entry_._type == HSystemShell::HGlob::TYPE::DIRECTORY ) {
+		return ( true );
+	}
+	return ( ( entry_._type == HSystemShell::HGlob::TYPE::LINK ) && filesystem::is_directory( path_ ) );
+}
+
+bool entry_less( HSystemShell::HGlob::OEntry const& left_, HSystemShell::HGlob::OEntry const& right_ ) {
+	return ( left_._name < right_._name );
+}
+
+bool name_less( HSystemShell::HGlob::OEntry const& entry_, yaal::hcore::HString const& name_ ) {
+	return ( entry_._name < name_ );
+}
+
+}
+
+HSystemShell::HGlob::HScope::HScope( HGlob& glob_ )
+	: _glob( glob_ ) {
+	M_PROLOG
+	HLock l( _glob._mutex );
+	++ _glob._scopes;
+	return;
+	M_EPILOG
+}
+
+HSystemShell::HGlob::HScope::~HScope( void ) {
+	M_PROLOG
+	HLock l( _glob._mutex );
+	-- _glob._scopes;
+	if ( _glob._scopes == 0 ) {
+		_glob._listings.clear();
+	}
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+HSystemShell::HGlob::HGlob( void )
+	: _listings()
+	, _scopes( 0 )
+	, _mutex() {
+	return;
+}
+
+void HSystemShell::HGlob::invalidate( void ) {
+	M_PROLOG
+	HLock l( _mutex );
+	_listings.clear();
+	return;
+	M_EPILOG
+}
+
+HSystemShell::HGlob::listing_t HSystemShell::HGlob::read( yaal::tools::filesystem::path_t const& path_ ) {
+	M_PROLOG
+	listing_t listing( make_pointer<entries_t>() );
+	entries_t& entries( *listing );
+	filesystem::path_t dir( ! path_.is_empty() ? path_ : filesystem::path_t( "." ) );
+#ifdef __HOST_OS_TYPE_LINUX__
+	HUTF8String utf8( dir );
+	int fd( ::open( utf8.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC ) );
+	if ( fd < 0 ) {
+		return ( listing );
+	}
+	char buffer[LISTING_BUFFER_SIZE] __attribute__(( aligned( __alignof__( struct dirent64 ) ) ));
+	while ( true ) {
+		long len( ::syscall( SYS_getdents64, fd, buffer, sizeof ( buffer ) ) );
+		if ( len <= 0 ) {
+			break;
+		}
+		for ( char const* p( buffer ); p < ( buffer + len ); ) {
+			dirent64 const* d( reinterpret_cast<dirent64 const*>( p ) );
+			p += d->d_reclen;
+			char const* name( d->d_name );
+			if ( ( name[0] == '.' ) && ( ( name[1] == 0 ) || ( ( name[1] == '.' ) && ( name[2] == 0 ) ) ) ) {
+				continue;
+			}
+			HString entryName( name );
+			TYPE type( TYPE::OTHER );
+			if ( d->d_type == DT_DIR ) {
+				type = TYPE::DIRECTORY;
+			} else if ( d->d_type == DT_LNK ) {
+				type = TYPE::LINK;
+			} else if ( d->d_type == DT_UNKNOWN ) {
+				type = probe( join( path_, entryName ) );
+			}
+			entries.emplace_back( yaal::move( entryName ), type );
+		}
+	}
+	::close( fd );
+#else
+	try {
+		HFSItem dirItem( dir );
+		for ( HFSItem const& f : dirItem ) {
+			HString entryName( f.get_name() );
+			if ( ( entryName == "." ) || ( entryName == ".." ) ) {
+				continue;
+			}
+			TYPE type( probe( join( path_, entryName ) ) );
+			entries.emplace_back( yaal::move( entryName ), type );
+		}
+	} catch ( HException const& ) {
+		/* Not a directory or not readable, nothing matches below it. */
+	}
+#endif
+	sort( entries.begin(), entries.end(), entry_less );
+	return ( listing );
+	M_EPILOG
+}
+
+HSystemShell::HGlob::listing_t HSystemShell::HGlob::listing( yaal::tools::filesystem::path_t const& path_ ) {
+	M_PROLOG
+	if ( _scopes == 0 ) {
+		return ( read( path_ ) );
+	}
+	listings_t::const_iterator it( _listings.find( path_ ) );
+	if ( it != _listings.end() ) {
+		return ( it->second );
+	}
+	listing_t l( read( path_ ) );
+	_listings.insert( make_pair( path_, l ) );
+	return ( l );
+	M_EPILOG
+}
+
+void HSystemShell::HGlob::descend( yaal::tools::filesystem::path_t const& path_, yaal::tools::filesystem::paths_t& dirs_ ) {
+	M_PROLOG
+	/* Like in other shells `**` does not follow symbolic links to avoid cycles. */
+	listing_t l( listing( path_ ) );
+	for ( OEntry const& e : *l ) {
+		if ( ( e._type != TYPE::DIRECTORY ) || ( e._name.front() == '.' ) ) {
+			continue;
+		}
+		filesystem::path_t path( join( path_, e._name ) );
+		dirs_.push_back( path );
+		descend( path, dirs_ );
+	}
+	return;
+	M_EPILOG
+}
+
+bool HSystemShell::HGlob::exists( yaal::tools::filesystem::path_t const& dir_, yaal::hcore::HString const& name_, bool wantDirectory_ ) {
+	M_PROLOG
+	if ( ( name_ == "." ) || ( name_ == ".." ) ) {
+		return ( true );
+	}
+	listing_t l( listing( dir_ ) );
+	entries_t::const_iterator it( lower_bound( l->begin(), l->end(), name_, name_less ) );
+	if ( ( it == l->end() ) || ( it->_name != name_ ) ) {
+		return ( false );
+	}
+	return ( ! wantDirectory_ || is_directory( *it, join( dir_, name_ ) ) );
+	M_EPILOG
+}
+
+yaal::tools::filesystem::paths_t HSystemShell::HGlob::glob( yaal::hcore::HString const& pattern_ ) {
+	M_PROLOG
+	filesystem::paths_t candidates;
+	if ( pattern_.is_empty() ) {
+		return ( candidates );
+	}
+	HString::size_type len( pattern_.get_length() );
+	bool wantDirectories( pattern_.back() == '/' );
+	HArray<HString> components;
+	for ( HString::size_type start( 0 ); start < len; ) {
+		HString::size_type end( pattern_.find( '/'_ycp, start ) );
+		if ( end == HString::npos ) {
+			end = len;
+		}
+		if ( end > start ) {
+			components.push_back( pattern_.substr( start, end - start ) );
+		}
+		start = end + 1;
+	}
+	candidates.push_back( pattern_.front() == '/' ? filesystem::path_t( "/" ) : filesystem::path_t() );
+	HLock l( _mutex );
+	filesystem::paths_t next;
+	for ( int i( 0 ), count( static_cast<int>( components.get_size() ) ); i < count; ++ i ) {
+		HString component( components[i] );
+		bool last( i == ( count - 1 ) );
+		bool wantDirectory( ! last || wantDirectories );
+		next.clear();
+		if ( component == RECURSIVE ) {
+			/* `**` matches zero or more directories, trailing `**` matches everything below. */
+			for ( filesystem::path_t const& path : candidates ) {
+				next.push_back( path );
+				descend( path, next );
+			}
+			candidates.swap( next );
+			if ( ! last ) {
+				continue;
+			}
+			next.clear();
+			component = "*";
+		}
+		if ( ! has_wildcard( component ) ) {
+			HString name( unescape_literal( component ) );
+			for ( filesystem::path_t const& path : candidates ) {
+				/* Missing intermediate directories show up as empty listings later on. */
+				if ( ! last || exists( path, name, wantDirectory ) ) {
+					next.push_back( join( path, name ) );
+				}
+			}
+		} else {
+			bool wantHidden( ( component.front() == '.' ) || component.starts_with( "\\." ) );
+			for ( filesystem::path_t const& path : candidates ) {
+				listing_t entries( listing( path ) );
+				for ( OEntry const& e : *entries ) {
+					if ( ( e._name.front() == '.' ) && ! wantHidden ) {
+						continue;
+					}
+					if ( ! match( component, e._name ) ) {
+						continue;
+					}
+					filesystem::path_t entryPath( join( path, e._name ) );
+					if ( wantDirectory && ! is_directory( e, entryPath ) ) {
+						continue;
+					}
+					next.push_back( yaal::move( entryPath ) );
+				}
+			}
+		}
+		candidates.swap( next );
+		if ( candidates.is_empty() ) {
+			break;
+		}
+	}
+	sort( candidates.begin(), candidates.end() );
+	candidates.erase( unique( candidates.begin(), candidates.end() ), candidates.end() );
+	if ( wantDirectories ) {
+		for ( filesystem::path_t& path : candidates ) {
+			if ( path.back() != '/' ) {
+				path.push_back( '/'_ycp );
+			}
+		}
+	}
+	return ( candidates );
+	M_EPILOG
+}
+
+}
+
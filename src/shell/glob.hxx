@@ -0,0 +1,76 @@
+#ifndef HUGINN_SHELL_GLOB_HXX_INCLUDED
+#define HUGINN_SHELL_GLOB_HXX_INCLUDED 1
+
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hpointer.hxx>
+#include <yaal/hcore/hthread.hxx>
+
+#include "src/systemshell.hxx"
+
+namespace huginn {
+
+/*! \brief File name generation (globbing) for shell words.
+ *
+ * Supports `*`, `?`, `[...]` and recursive `**` path components.
+ * Each directory is listed at most once per scope (one command line),
+ * and the listing is shared by all globs expanded in that scope,
+ * so several globs over the same directory, or `**` over a large tree,
+ * read the file system only once.
+ */
+class HSystemShell::HGlob {
+public:
+	enum class TYPE {
+		DIRECTORY,
+		LINK,
+		OTHER
+	};
+	struct OEntry {
+		yaal::hcore::HString _name;
+		TYPE _type;
+		OEntry( yaal::hcore::HString&& name_, TYPE type_ )
+			: _name( yaal::move( name_ ) )
+			, _type( type_ ) {
+		}
+	};
+	typedef yaal::hcore::HArray<OEntry> entries_t;
+	typedef yaal::hcore::HPointer<entries_t> listing_t;
+	typedef yaal::hcore::HHashMap<yaal::tools::filesystem::path_t, listing_t> listings_t;
+	/*! \brief Keep directory listings for the lifetime of the scope object.
+	 *
+	 * Scopes nest, listings are dropped when the outermost scope ends.
+	 */
+	class HScope {
+		HGlob& _glob;
+	public:
+		HScope( HGlob& );
+		~HScope( void );
+	private:
+		HScope( HScope const& ) = delete;
+		HScope& operator = ( HScope const& ) = delete;
+	};
+private:
+	listings_t _listings;
+	int _scopes;
+	yaal::hcore::HMutex _mutex;
+public:
+	HGlob( void );
+	/*! \brief Expand pattern to sorted list of matching paths.
+	 *
+	 * \param pattern - glob pattern, special characters can be escaped with backslash.
+	 * \return Sorted list of paths matching given pattern, empty if nothing matched.
+	 */
+	yaal::tools::filesystem::paths_t glob( yaal::hcore::HString const& );
+	void invalidate( void );
+private:
+	listing_t listing( yaal::tools::filesystem::path_t const& );
+	void descend( yaal::tools::filesystem::path_t const&, yaal::tools::filesystem::paths_t& );
+	bool exists( yaal::tools::filesystem::path_t const&, yaal::hcore::HString const&, bool );
+	static listing_t read( yaal::tools::filesystem::path_t const& );
+	HGlob( HGlob const& ) = delete;
+	HGlob& operator = ( HGlob const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_GLOB_HXX_INCLUDED */
+
@@ -12,6 +12,8 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "job.hxx"
 #include "command.hxx"
 #include "util.hxx"
+#include "glob.hxx"
+#include "reaper.hxx"
 #include "src/systemshell.hxx"
 #include "src/colorize.hxx"
 #include "src/setup.hxx"
@@ -45,6 +47,7 @@ HSystemShell::HJob::HJob( HSystemShell& systemShell_, commands_t&& commands_, HC
 	, _evaluationMode( evaluationMode_ )
 	, _predecessor( predecessor_ )
 	, _lastChain( lastChain_ )
+	, _reported( false )
 	, _failureMessages()
 	, _capture( capture_ )
 	, _sec( call( &HJob::stop_capture, this ) ) {
@@ -58,6 +61,15 @@ HSystemShell::HJob::HJob( HSystemShell& systemShell_, commands_t&& commands_, HC
 	return;
 }
 
+HSystemShell::HJob::~HJob( void ) {
+	M_PROLOG
+	if ( !! _systemShell._reaper ) {
+		_systemShell._reaper->forget( *this );
+	}
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
 yaal::hcore::HString HSystemShell::HJob::make_desc( commands_t const& commands_ ) const {
 	M_PROLOG
 	HString desc;
@@ -75,15 +87,33 @@ bool HSystemShell::HJob::start( bool background_ ) {
 	M_PROLOG
 	bool validShell( false );
 	bool hasHuginnExpression( false );
-	for ( command_t& c : _commands ) {
-		if ( ! c->compile( _evaluationMode ) ) {
-			return ( false );
-		}
-		if ( hasHuginnExpression && ! c->is_shell_command() ) {
-			cerr << "Only one Huginn expression per pipe is allowed." << endl;
-			return ( false );
+	OCommand* previous( nullptr );
+	/* scope for glob listings */ {
+		/* All globs in one command line share directory listings. */
+		HGlob::HScope globScope( *_systemShell._glob );
+		for ( command_t& c : _commands ) {
+			/*
+			 * Session interpreter can run only one expression at a time,
+			 * all subsequent Huginn stages get their own interpreters.
+			 */
+			if ( ! c->compile( _evaluationMode, hasHuginnExpression ) ) {
+				return ( false );
+			}
+			hasHuginnExpression = hasHuginnExpression || ! c->is_shell_command();
+			if ( previous ) {
+				c->set_in_channel( *previous );
+			}
+			previous = c.raw();
 		}
-		hasHuginnExpression = hasHuginnExpression || ! c->is_shell_command();
+	}
+	/*
+	 * Pipe ends of one stage must not stay open in the other stages,
+	 * otherwise readers would never see the end of their input.
+	 */
+	for ( command_t& c : _commands ) {
+		HProcess::close_on_exec( c->_in );
+		HProcess::close_on_exec( c->_out );
+		HProcess::close_on_exec( c->_err );
 	}
 	for ( command_t& c : _commands ) {
 		OCommand& cmd( *c );
@@ -116,9 +146,9 @@ bool HSystemShell::HJob::start( bool background_ ) {
 	M_EPILOG
 }
 
-yaal::tools::HPipedChild::process_group_t HSystemShell::HJob::process_group( void ) {
+HSystemShell::HProcess::group_t HSystemShell::HJob::process_group( void ) {
 	M_PROLOG
-	yaal::tools::HPipedChild::process_group_t processGroup;
+	HProcess::group_t processGroup;
 	for ( command_t& c : _commands ) {
 		if ( ! c->_child ) {
 			continue;
@@ -129,7 +159,7 @@ yaal::tools::HPipedChild::process_group_t HSystemShell::HJob::process_group( voi
 	M_EPILOG
 }
 
-HSystemShell::commands_t::iterator HSystemShell::HJob::process_to_command( HPipedChild const* process_ ) {
+HSystemShell::commands_t::iterator HSystemShell::HJob::process_to_command( HProcess const* process_ ) {
 	M_PROLOG
 	return (
 		find_if(
@@ -157,7 +187,7 @@ yaal::tools::HPipedChild::STATUS HSystemShell::HJob::finish_non_process(
 ) {
 	M_PROLOG
 	for ( commands_t::iterator cmd( start_ ); cmd != _commands.end(); ) {
-		piped_child_t& child( (*cmd)->_child );
+		process_t& child( (*cmd)->_child );
 		if ( !! child ) {
 			HPipedChild::STATUS s( child->get_status() );
 			if ( ( s.type == HPipedChild::STATUS::TYPE::RUNNING ) || ( s.type == HPipedChild::STATUS::TYPE::PAUSED ) ) {
@@ -176,8 +206,8 @@ HPipedChild::STATUS HSystemShell::HJob::wait_for_finish( void ) {
 	HHuginn::value_t huginnResult( yaal::move( _commands.back()->_huginnResult ) );
 	HPipedChild::STATUS exitStatus( finish_non_process( _commands.begin() ) );
 	while ( ! _commands.is_empty() && ( exitStatus.type != HPipedChild::STATUS::TYPE::PAUSED ) ) {
-		HPipedChild::process_group_t processGroup( process_group() );
-		HPipedChild::process_group_t::iterator finishedProcess( HPipedChild::wait_for_process_group( processGroup ) );
+		HProcess::group_t processGroup( process_group() );
+		HProcess::group_t::iterator finishedProcess( HProcess::wait_for_group( processGroup ) );
 		if ( finishedProcess == processGroup.end() ) {
 			break;
 		}
@@ -228,7 +258,7 @@ void HSystemShell::HJob::do_continue( bool background_ ) {
 	}
 	_background = background_;
 	for ( command_t& c : _commands ) {
-		piped_child_t& child( c->_child );
+		process_t& child( c->_child );
 		if ( ! child ) {
 			continue;
 		}
@@ -242,7 +272,7 @@ void HSystemShell::HJob::do_continue( bool background_ ) {
 
 void HSystemShell::HJob::bring_to_foreground( void ) {
 	M_PROLOG
-	piped_child_t& child( _commands.back()->_child );
+	process_t& child( _commands.back()->_child );
 	if ( ! child ) {
 		return;
 	}
@@ -5,6 +5,7 @@
 
 #include "src/systemshell.hxx"
 #include "src/shell/capture.hxx"
+#include "src/shell/process.hxx"
 
 namespace huginn {
 
@@ -18,11 +19,13 @@ private:
 	EVALUATION_MODE _evaluationMode;
 	bool _predecessor;
 	bool _lastChain;
+	bool _reported;
 	tokens_t _failureMessages;
 	HSystemShell::HCapture* _capture;
 	yaal::tools::util::HScopeExitCall _sec;
 public:
 	HJob( HSystemShell&, commands_t&&, HSystemShell::HCapture*, EVALUATION_MODE, bool, bool );
+	~HJob( void );
 	bool start( bool );
 	yaal::tools::HPipedChild::STATUS wait_for_finish( void );
 	yaal::hcore::HString const& description( void ) const {
@@ -43,16 +46,24 @@ public:
 	bool has_huginn_jobs( void ) const;
 	bool can_orphan( void );
 	void orphan( void );
+	HProcess::group_t process_group( void );
+	/*! \brief Tell if completion of this job was already announced.
+	 */
+	bool reported( void ) const {
+		return ( _reported );
+	}
+	void mark_reported( void ) {
+		_reported = true;
+	}
 	tokens_t const& failure_messages( void ) const {
 		return ( _failureMessages );
 	}
 private:
 	void stop_capture( void );
 	yaal::hcore::HString make_desc( commands_t const& ) const;
-	yaal::tools::HPipedChild::process_group_t process_group( void );
 	yaal::tools::HPipedChild::STATUS finish_non_process( commands_t::iterator, yaal::tools::HPipedChild::STATUS = yaal::tools::HPipedChild::STATUS() );
 	yaal::tools::HPipedChild::STATUS gather_results( command_t& );
-	commands_t::iterator process_to_command( yaal::tools::HPipedChild const* );
+	commands_t::iterator process_to_command( HProcess const* );
 	HJob( HJob const& ) = delete;
 	HJob& operator = ( HJob const& ) = delete;
 };
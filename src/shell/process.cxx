@@ -0,0 +1,478 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#ifndef __MSVCXX__
+#	include <unistd.h>
+#	include <spawn.h>
+#	include <sys/wait.h>
+#endif
+
+#include <yaal/hcore/algorithm.hxx>
+#include <yaal/hcore/hrawfile.hxx>
+#include <yaal/hcore/system.hxx>
+#include <yaal/tools/hterminal.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "process.hxx"
+
+#ifndef __MSVCXX__
+
+extern char** environ;
+
+/*
+ * Terminal handoff in the child itself (before exec) is needed
+ * to avoid a race between the child reading from the terminal
+ * and the shell making the child's group the foreground one.
+ */
+#ifdef __GLIBC__
+#	if __GLIBC_PREREQ( 2, 35 )
+#		define HUGINN_SPAWN_TCSETPGRP 1
+#	endif
+#endif
+
+#endif
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+#ifndef __MSVCXX__
+
+int stream_descriptor( yaal::hcore::HStreamInterface::ptr_t const& stream_, int default_ ) {
+	if ( ! stream_ ) {
+		return ( default_ );
+	}
+	HRawFile const* rawFile( dynamic_cast<HRawFile const*>( stream_.raw() ) );
+	return ( rawFile && rawFile->is_valid() ? rawFile->get_file_descriptor() : -1 );
+}
+
+int controlling_terminal( void ) {
+	int const stdFds[] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+	for ( int fd : stdFds ) {
+		if ( is_a_tty( fd ) ) {
+			return ( fd );
+		}
+	}
+	return ( -1 );
+}
+
+void ensure( int error_, char const* what_ ) {
+	if ( error_ != 0 ) {
+		throw HRuntimeException( HString( what_ ).append( ": " ).append( ::strerror( error_ ) ) );
+	}
+}
+
+class HSpawnRequest {
+	posix_spawnattr_t _attributes;
+	posix_spawn_file_actions_t _actions;
+public:
+	HSpawnRequest( void )
+		: _attributes()
+		, _actions() {
+		M_PROLOG
+		ensure( ::posix_spawnattr_init( &_attributes ), "posix_spawnattr_init" );
+		int err( ::posix_spawn_file_actions_init( &_actions ) );
+		if ( err != 0 ) {
+			::posix_spawnattr_destroy( &_attributes );
+			ensure( err, "posix_spawn_file_actions_init" );
+		}
+		return;
+		M_EPILOG
+	}
+	~HSpawnRequest( void ) {
+		::posix_spawn_file_actions_destroy( &_actions );
+		::posix_spawnattr_destroy( &_attributes );
+	}
+	posix_spawnattr_t* attributes( void ) {
+		return ( &_attributes );
+	}
+	posix_spawn_file_actions_t* actions( void ) {
+		return ( &_actions );
+	}
+private:
+	HSpawnRequest( HSpawnRequest const& ) = delete;
+	HSpawnRequest& operator = ( HSpawnRequest const& ) = delete;
+};
+
+#endif
+
+}
+
+HSystemShell::HProcess::HProcess( void )
+	: _pipedChild()
+	, _pid( -1 )
+	, _pgid( -1 )
+	, _terminal( -1 )
+	, _status() {
+	_status.type = HPipedChild::STATUS::TYPE::UNSPAWNED;
+	return;
+}
+
+HSystemShell::HProcess::~HProcess( void ) {
+	M_PROLOG
+#ifndef __MSVCXX__
+	if ( ! _pipedChild && ( _pid > 0 ) ) {
+		HPipedChild::STATUS s( get_status() );
+		if ( ( s.type == HPipedChild::STATUS::TYPE::RUNNING ) || ( s.type == HPipedChild::STATUS::TYPE::PAUSED ) ) {
+			::kill( _pid, SIGKILL );
+			int status( 0 );
+			while ( ( ::waitpid( _pid, &status, 0 ) < 0 ) && ( errno == EINTR ) ) {
+			}
+			restore_parent_term();
+		}
+	}
+#endif
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+void HSystemShell::HProcess::spawn(
+	yaal::hcore::HString const& image_,
+	yaal::tools::HPipedChild::argv_t const& argv_,
+	yaal::hcore::HStreamInterface::ptr_t const& in_,
+	yaal::hcore::HStreamInterface::ptr_t const& out_,
+	yaal::hcore::HStreamInterface::ptr_t const& err_,
+	bool closeOut_,
+	int pgid_,
+	bool foreground_
+) {
+	M_PROLOG
+	if ( spawn_direct( image_, argv_, in_, out_, err_, closeOut_, pgid_, foreground_ ) ) {
+		return;
+	}
+	_pipedChild = make_resource<HPipedChild>( in_, closeOut_ ? out_ : HStreamInterface::ptr_t(), err_ );
+	_pipedChild->spawn(
+		image_,
+		argv_,
+		! in_ ? &cin : nullptr,
+		! out_ ? &cout : ( ! closeOut_ ? out_.raw() : nullptr ),
+		! err_ ? &cerr : nullptr,
+		pgid_,
+		foreground_
+	);
+	return;
+	M_EPILOG
+}
+
+#ifndef __MSVCXX__
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+
+bool HSystemShell::HProcess::spawn_direct(
+	yaal::hcore::HString const& image_,
+	yaal::tools::HPipedChild::argv_t const& argv_,
+	yaal::hcore::HStreamInterface::ptr_t const& in_,
+	yaal::hcore::HStreamInterface::ptr_t const& out_,
+	yaal::hcore::HStreamInterface::ptr_t const& err_,
+	bool closeOut_,
+	int pgid_,
+	bool foreground_
+) {
+	M_PROLOG
+	int const fds[] = {
+		stream_descriptor( in_, STDIN_FILENO ),
+		stream_descriptor( out_, STDOUT_FILENO ),
+		stream_descriptor( err_, STDERR_FILENO )
+	};
+	for ( int fd : fds ) {
+		if ( fd < 0 ) {
+			/* In-process stream, it needs HPipedChild's pumping. */
+			return ( false );
+		}
+	}
+	int terminal( foreground_ ? controlling_terminal() : -1 );
+#ifndef HUGINN_SPAWN_TCSETPGRP
+	if ( terminal >= 0 ) {
+		return ( false );
+	}
+#endif
+	HSpawnRequest request;
+	short flags( POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK );
+#ifdef POSIX_SPAWN_USEVFORK
+	flags = static_cast<short>( flags | POSIX_SPAWN_USEVFORK );
+#endif
+	ensure( ::posix_spawnattr_setflags( request.attributes(), flags ), "posix_spawnattr_setflags" );
+	ensure( ::posix_spawnattr_setpgroup( request.attributes(), pgid_ != HPipedChild::PROCESS_GROUP_LEADER ? pgid_ : 0 ), "posix_spawnattr_setpgroup" );
+	/* Shell ignores or handles these, the command must get the defaults. */
+	sigset_t signals;
+	sigemptyset( &signals );
+	int const defaultSignals[] = {
+		SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGPIPE, SIGCHLD
+	};
+	for ( int sigNo : defaultSignals ) {
+		sigaddset( &signals, sigNo );
+	}
+	ensure( ::posix_spawnattr_setsigdefault( request.attributes(), &signals ), "posix_spawnattr_setsigdefault" );
+	sigemptyset( &signals );
+	ensure( ::posix_spawnattr_setsigmask( request.attributes(), &signals ), "posix_spawnattr_setsigmask" );
+#ifdef HUGINN_SPAWN_TCSETPGRP
+	if ( terminal >= 0 ) {
+		ensure( ::posix_spawn_file_actions_addtcsetpgrp_np( request.actions(), terminal ), "posix_spawn_file_actions_addtcsetpgrp_np" );
+	}
+#endif
+	for ( int i( 0 ); i < static_cast<int>( sizeof ( fds ) / sizeof ( fds[0] ) ); ++ i ) {
+		if ( fds[i] != i ) {
+			ensure( ::posix_spawn_file_actions_adddup2( request.actions(), fds[i], i ), "posix_spawn_file_actions_adddup2" );
+		}
+	}
+	HUTF8String image( image_ );
+	typedef HArray<HUTF8String> utf8_strings_t;
+	utf8_strings_t utf8Argv;
+	utf8Argv.reserve( argv_.get_size() + 1 );
+	utf8Argv.emplace_back( image_ );
+	for ( HString const& arg : argv_ ) {
+		utf8Argv.emplace_back( arg );
+	}
+	HArray<char*> argv;
+	argv.reserve( utf8Argv.get_size() + 1 );
+	for ( HUTF8String const& arg : utf8Argv ) {
+		argv.push_back( const_cast<char*>( arg.c_str() ) );
+	}
+	argv.push_back( nullptr );
+	/* Child inherits descriptors, not our buffers. */
+	cout.flush();
+	cerr.flush();
+	pid_t pid( 0 );
+	int err( ::posix_spawnp( &pid, image.c_str(), request.actions(), request.attributes(), argv.data(), environ ) );
+	if ( err != 0 ) {
+		throw HRuntimeException( "Cannot execute `"_ys.append( image_ ).append( "`: " ).append( ::strerror( err ) ) );
+	}
+	_pid = static_cast<int>( pid );
+	_pgid = pgid_ != HPipedChild::PROCESS_GROUP_LEADER ? pgid_ : _pid;
+	_status.type = HPipedChild::STATUS::TYPE::RUNNING;
+	_status.value = 0;
+	/* Fails harmlessly if the child has already done it and exec'ed. */
+	::setpgid( _pid, _pgid );
+	if ( terminal >= 0 ) {
+		::tcsetpgrp( terminal, _pgid );
+		_terminal = terminal;
+	}
+	if ( closeOut_ ) {
+		/* Reader must see EOF as soon as this command exits. */
+		HRawFile* out( dynamic_cast<HRawFile*>( out_.raw() ) );
+		if ( out && out->is_valid() ) {
+			out->close();
+		}
+	}
+	return ( true );
+	M_EPILOG
+}
+
+void HSystemShell::HProcess::update( int status_ ) {
+	if ( WIFEXITED( status_ ) ) {
+		_status.type = HPipedChild::STATUS::TYPE::FINISHED;
+		_status.value = WEXITSTATUS( status_ );
+	} else if ( WIFSIGNALED( status_ ) ) {
+		_status.type = HPipedChild::STATUS::TYPE::ABORTED;
+		_status.value = WTERMSIG( status_ );
+	} else if ( WIFSTOPPED( status_ ) ) {
+		_status.type = HPipedChild::STATUS::TYPE::PAUSED;
+		_status.value = WSTOPSIG( status_ );
+	} else if ( WIFCONTINUED( status_ ) ) {
+		_status.type = HPipedChild::STATUS::TYPE::RUNNING;
+		_status.value = 0;
+	}
+	return;
+}
+
+#pragma GCC diagnostic pop
+
+#else
+
+bool HSystemShell::HProcess::spawn_direct(
+	yaal::hcore::HString const&,
+	yaal::tools::HPipedChild::argv_t const&,
+	yaal::hcore::HStreamInterface::ptr_t const&,
+	yaal::hcore::HStreamInterface::ptr_t const&,
+	yaal::hcore::HStreamInterface::ptr_t const&,
+	bool,
+	int,
+	bool
+) {
+	return ( false );
+}
+
+void HSystemShell::HProcess::update( int ) {
+	return;
+}
+
+#endif
+
+int HSystemShell::HProcess::get_pid( void ) const {
+	return ( !! _pipedChild ? _pipedChild->get_pid() : _pid );
+}
+
+yaal::tools::HPipedChild::STATUS HSystemShell::HProcess::get_status( void ) {
+	M_PROLOG
+	if ( !! _pipedChild ) {
+		return ( _pipedChild->get_status() );
+	}
+#ifndef __MSVCXX__
+	if ( ( _status.type == HPipedChild::STATUS::TYPE::RUNNING ) || ( _status.type == HPipedChild::STATUS::TYPE::PAUSED ) ) {
+		int status( 0 );
+		if ( ::waitpid( _pid, &status, WNOHANG | WUNTRACED | WCONTINUED ) == _pid ) {
+			update( status );
+		}
+	}
+#endif
+	return ( _status );
+	M_EPILOG
+}
+
+yaal::tools::HPipedChild::STATUS HSystemShell::HProcess::wait( void ) {
+	M_PROLOG
+	if ( !! _pipedChild ) {
+		return ( _pipedChild->wait() );
+	}
+#ifndef __MSVCXX__
+	while ( _status.type == HPipedChild::STATUS::TYPE::RUNNING ) {
+		int status( 0 );
+		if ( ::waitpid( _pid, &status, 0 ) == _pid ) {
+			update( status );
+		} else if ( errno != EINTR ) {
+			/* Reaped elsewhere, nothing more can be learned about it. */
+			_status.type = HPipedChild::STATUS::TYPE::FINISHED;
+		}
+	}
+	restore_parent_term();
+#endif
+	return ( _status );
+	M_EPILOG
+}
+
+void HSystemShell::HProcess::do_continue( void ) {
+	M_PROLOG
+	if ( !! _pipedChild ) {
+		_pipedChild->do_continue();
+		return;
+	}
+	if ( _status.type == HPipedChild::STATUS::TYPE::PAUSED ) {
+		system::kill( _pid, SIGCONT );
+		_status.type = HPipedChild::STATUS::TYPE::RUNNING;
+		_status.value = 0;
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HProcess::bring_to_foreground( void ) {
+	M_PROLOG
+	if ( !! _pipedChild ) {
+		_pipedChild->bring_to_foreground();
+		return;
+	}
+#ifndef __MSVCXX__
+	int terminal( controlling_terminal() );
+	if ( terminal >= 0 ) {
+		::tcsetpgrp( terminal, _pgid );
+		_terminal = terminal;
+	}
+#endif
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HProcess::restore_parent_term( void ) {
+	M_PROLOG
+	if ( !! _pipedChild ) {
+		_pipedChild->restore_parent_term();
+		return;
+	}
+#ifndef __MSVCXX__
+	if ( _terminal >= 0 ) {
+		::tcsetpgrp( _terminal, ::getpgrp() );
+		_terminal = -1;
+	}
+#endif
+	return;
+	M_EPILOG
+}
+
+HSystemShell::HProcess::group_t::iterator HSystemShell::HProcess::wait_for_group( group_t& group_ ) {
+	M_PROLOG
+	HPipedChild::process_group_t pipedChildren;
+	int pgid( -1 );
+	for ( HProcess* process : group_ ) {
+		if ( !! process->_pipedChild ) {
+			pipedChildren.push_back( process->_pipedChild.raw() );
+		} else if ( process->_pid > 0 ) {
+			pgid = process->_pgid;
+		}
+	}
+	auto wait_for_piped_children = [&group_, &pipedChildren]() {
+		HPipedChild::process_group_t::iterator finished( HPipedChild::wait_for_process_group( pipedChildren ) );
+		if ( finished == pipedChildren.end() ) {
+			return ( group_.end() );
+		}
+		return (
+			find_if(
+				group_.begin(),
+				group_.end(),
+				[&finished]( HProcess const* process_ ) {
+					return ( process_->_pipedChild.raw() == *finished );
+				}
+			)
+		);
+	};
+	if ( pgid < 0 ) {
+		return ( wait_for_piped_children() );
+	}
+#ifndef __MSVCXX__
+	while ( true ) {
+		for ( group_t::iterator it( group_.begin() ), end( group_.end() ); it != end; ++ it ) {
+			if ( (*it)->get_status().type != HPipedChild::STATUS::TYPE::RUNNING ) {
+				return ( it );
+			}
+		}
+		/*
+		 * All stages of a job share one process group,
+		 * so a single blocking waitid(2) covers the whole job.
+		 * Children are left unreaped (WNOWAIT) for get_status() above.
+		 */
+		siginfo_t info;
+		::memset( &info, 0, sizeof ( info ) );
+		if ( ::waitid( P_PGID, static_cast<id_t>( pgid ), &info, WEXITED | WSTOPPED | WNOWAIT ) == 0 ) {
+			continue;
+		}
+		if ( errno == EINTR ) {
+			continue;
+		}
+		if ( errno != ECHILD ) {
+			throw HRuntimeException( "waitid: "_ys.append( ::strerror( errno ) ) );
+		}
+		/* Remaining processes were started outside of the job's group. */
+		if ( pipedChildren.is_empty() ) {
+			return ( group_.end() );
+		}
+		return ( wait_for_piped_children() );
+	}
+#else
+	return ( wait_for_piped_children() );
+#endif
+	M_EPILOG
+}
+
+void HSystemShell::HProcess::close_on_exec( yaal::hcore::HStreamInterface::ptr_t const& stream_ ) {
+	M_PROLOG
+#ifndef __MSVCXX__
+	int fd( stream_descriptor( stream_, -1 ) );
+	if ( fd > STDERR_FILENO ) {
+		system::set_close_on_exec( fd, true );
+	}
+#endif
+	return;
+	M_EPILOG
+}
+
+}
+
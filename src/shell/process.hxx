@@ -0,0 +1,73 @@
+#ifndef HUGINN_SHELL_PROCESS_HXX_INCLUDED
+#define HUGINN_SHELL_PROCESS_HXX_INCLUDED 1
+
+#include <yaal/tools/hpipedchild.hxx>
+
+#include "src/systemshell.hxx"
+
+namespace huginn {
+
+/*! \brief External command process of a job stage.
+ *
+ * Commands with all standard streams backed by file descriptors are launched
+ * with posix_spawn(3), which unlike fork(2) does not copy the page tables of the shell
+ * (glibc runs the child in the parent's address space until exec),
+ * so launch latency does not grow with the size of loaded Huginn session.
+ * All other commands are started through HPipedChild.
+ */
+class HSystemShell::HProcess {
+public:
+	typedef yaal::hcore::HArray<HProcess*> group_t;
+private:
+	piped_child_t _pipedChild;
+	int _pid;
+	int _pgid;
+	int _terminal;
+	yaal::tools::HPipedChild::STATUS _status;
+public:
+	HProcess( void );
+	~HProcess( void );
+	void spawn(
+		yaal::hcore::HString const&,
+		yaal::tools::HPipedChild::argv_t const&,
+		yaal::hcore::HStreamInterface::ptr_t const&,
+		yaal::hcore::HStreamInterface::ptr_t const&,
+		yaal::hcore::HStreamInterface::ptr_t const&,
+		bool,
+		int,
+		bool
+	);
+	int get_pid( void ) const;
+	yaal::tools::HPipedChild::STATUS get_status( void );
+	yaal::tools::HPipedChild::STATUS wait( void );
+	void do_continue( void );
+	void bring_to_foreground( void );
+	void restore_parent_term( void );
+	/*! \brief Wait until any process from the group finishes or stops.
+	 *
+	 * \return Process that changed its state or end of the group if there is nothing to wait for.
+	 */
+	static group_t::iterator wait_for_group( group_t& );
+	/*! \brief Keep stream's descriptor from leaking into spawned processes.
+	 */
+	static void close_on_exec( yaal::hcore::HStreamInterface::ptr_t const& );
+private:
+	bool spawn_direct(
+		yaal::hcore::HString const&,
+		yaal::tools::HPipedChild::argv_t const&,
+		yaal::hcore::HStreamInterface::ptr_t const&,
+		yaal::hcore::HStreamInterface::ptr_t const&,
+		yaal::hcore::HStreamInterface::ptr_t const&,
+		bool,
+		int,
+		bool
+	);
+	void update( int );
+	HProcess( HProcess const& ) = delete;
+	HProcess& operator = ( HProcess const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_PROCESS_HXX_INCLUDED */
+
@@ -0,0 +1,271 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#include <cstring>
+#include <cerrno>
+
+#ifdef __HOST_OS_TYPE_LINUX__
+#	include <unistd.h>
+#	include <poll.h>
+#	include <sys/epoll.h>
+#	include <sys/eventfd.h>
+#	include <sys/syscall.h>
+#endif
+
+#include <yaal/hcore/hlog.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "reaper.hxx"
+#include "job.hxx"
+#include "src/colorize.hxx"
+#include "src/setup.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+namespace {
+
+#ifdef __HOST_OS_TYPE_LINUX__
+
+/*
+ * Number of events taken from the kernel in one epoll_wait(2) call.
+ */
+int const EVENT_BATCH = 32;
+
+int pidfd_open( int pid_ ) {
+#ifdef SYS_pidfd_open
+	return ( static_cast<int>( ::syscall( SYS_pidfd_open, pid_, 0 ) ) );
+#else
+	static_cast<void>( pid_ );
+	errno = ENOSYS;
+	return ( -1 );
+#endif
+}
+
+bool has_exited( int pidFd_ ) {
+	pollfd pfd{ pidFd_, POLLIN, 0 };
+	return ( ( ::poll( &pfd, 1, 0 ) > 0 ) && ( ( pfd.revents & POLLIN ) != 0 ) );
+}
+
+#endif
+
+bool is_finished( HPipedChild::STATUS const& status_ ) {
+	return ( ( status_.type != HPipedChild::STATUS::TYPE::RUNNING ) && ( status_.type != HPipedChild::STATUS::TYPE::PAUSED ) );
+}
+
+}
+
+HSystemShell::HReaper::HReaper( HSystemShell& systemShell_ )
+	: _systemShell( systemShell_ )
+	, _epoll( -1 )
+	, _wakeUp( -1 )
+	, _watches()
+	, _thread() {
+	return;
+}
+
+HSystemShell::HReaper::~HReaper( void ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	if ( _thread.is_alive() ) {
+		u64_t one( 1 );
+		M_ENSURE( ::write( _wakeUp, &one, sizeof ( one ) ) == static_cast<ssize_t>( sizeof ( one ) ) );
+		_thread.finish();
+	}
+	for ( watches_t::value_type const& w : _watches ) {
+		::close( w.first );
+	}
+	if ( _wakeUp >= 0 ) {
+		::close( _wakeUp );
+	}
+	if ( _epoll >= 0 ) {
+		::close( _epoll );
+	}
+#endif
+	return;
+	M_DESTRUCTOR_EPILOG
+}
+
+bool HSystemShell::HReaper::start( void ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	if ( _epoll >= 0 ) {
+		return ( true );
+	}
+	if ( _wakeUp >= 0 ) {
+		/* Previous attempt failed, do not retry on every job. */
+		return ( false );
+	}
+	_wakeUp = ::eventfd( 0, EFD_CLOEXEC );
+	if ( _wakeUp < 0 ) {
+		return ( false );
+	}
+	/* Probe for pidfd support with our own pid. */
+	int probe( pidfd_open( static_cast<int>( ::getpid() ) ) );
+	if ( probe < 0 ) {
+		return ( false );
+	}
+	::close( probe );
+	int epoll( ::epoll_create1( EPOLL_CLOEXEC ) );
+	if ( epoll < 0 ) {
+		return ( false );
+	}
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = _wakeUp;
+	if ( ::epoll_ctl( epoll, EPOLL_CTL_ADD, _wakeUp, &event ) != 0 ) {
+		::close( epoll );
+		return ( false );
+	}
+	_epoll = epoll;
+	_thread.spawn( call( &HReaper::run, this ) );
+	return ( true );
+#else
+	return ( false );
+#endif
+	M_EPILOG
+}
+
+void HSystemShell::HReaper::watch( HJob& job_ ) {
+	M_PROLOG
+	HLock l( _systemShell._mutex );
+	if ( ! start() ) {
+		return;
+	}
+#ifdef __HOST_OS_TYPE_LINUX__
+	forget( job_ );
+	for ( HProcess* process : job_.process_group() ) {
+		if ( is_finished( process->get_status() ) ) {
+			continue;
+		}
+		/* Zombies get a pidfd too, it is readable right away. */
+		int pidFd( pidfd_open( process->get_pid() ) );
+		if ( pidFd < 0 ) {
+			continue;
+		}
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = pidFd;
+		if ( ::epoll_ctl( _epoll, EPOLL_CTL_ADD, pidFd, &event ) != 0 ) {
+			::close( pidFd );
+			continue;
+		}
+		_watches[pidFd] = OWatch{ &job_, process };
+	}
+#else
+	static_cast<void>( job_ );
+#endif
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HReaper::forget( HJob const& job_ ) {
+	M_PROLOG
+	HLock l( _systemShell._mutex );
+	HArray<int> pidFds;
+	for ( watches_t::value_type const& w : _watches ) {
+		if ( w.second._job == &job_ ) {
+			pidFds.push_back( w.first );
+		}
+	}
+	for ( int pidFd : pidFds ) {
+		unwatch( pidFd );
+	}
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HReaper::unwatch( int pidFd_ ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	::epoll_ctl( _epoll, EPOLL_CTL_DEL, pidFd_, nullptr );
+	::close( pidFd_ );
+#endif
+	_watches.erase( pidFd_ );
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HReaper::run( void ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	epoll_event events[EVENT_BATCH];
+	while ( true ) {
+		int eventCount( ::epoll_wait( _epoll, events, EVENT_BATCH, -1 ) );
+		if ( eventCount < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			hcore::log( LOG_LEVEL::ERROR ) << "Job reaper failed: " << ::strerror( errno ) << endl;
+			break;
+		}
+		for ( int i( 0 ); i < eventCount; ++ i ) {
+			if ( events[i].data.fd == _wakeUp ) {
+				return;
+			}
+			try {
+				dispatch( events[i].data.fd );
+			} catch ( HException const& e ) {
+				hcore::log( LOG_LEVEL::ERROR ) << "Job reaper failed: " << e.what() << endl;
+			}
+		}
+	}
+#endif
+	return;
+	M_EPILOG
+}
+
+void HSystemShell::HReaper::dispatch( int pidFd_ ) {
+	M_PROLOG
+#ifdef __HOST_OS_TYPE_LINUX__
+	HLock l( _systemShell._mutex );
+	watches_t::iterator it( _watches.find( pidFd_ ) );
+	/*
+	 * Job could have been forgotten, and its descriptor number reused,
+	 * while this event was waiting for the lock.
+	 */
+	if ( ( it == _watches.end() ) || ! has_exited( pidFd_ ) ) {
+		return;
+	}
+	OWatch w( it->second );
+	unwatch( pidFd_ );
+	HJob& job( *w._job );
+	/* Foreground jobs are reaped by their waiter. */
+	if ( ! job.in_background() || job.reported() ) {
+		return;
+	}
+	w._process->get_status();
+	if ( ! is_finished( job.status() ) ) {
+		return;
+	}
+	int no( 1 );
+	for ( job_t const& j : _systemShell._jobs ) {
+		if ( j.raw() == &job ) {
+			break;
+		}
+		if ( j->is_direct_evaluation() ) {
+			++ no;
+		}
+	}
+	job.mark_reported();
+	HString notice( "["_ys.append( static_cast<int long long>( no ) ).append( "] Done " ).append( colorize( job.description(), &_systemShell ) ) );
+	if ( setup._interactive ) {
+		/* Keeps the line being edited intact. */
+		HUTF8String utf8( notice );
+		_systemShell._repl.print( "%s\n", utf8.c_str() );
+	} else {
+		cerr << notice << endl;
+	}
+#else
+	static_cast<void>( pidFd_ );
+#endif
+	return;
+	M_EPILOG
+}
+
+}
+
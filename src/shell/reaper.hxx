@@ -0,0 +1,53 @@
+#ifndef HUGINN_SHELL_REAPER_HXX_INCLUDED
+#define HUGINN_SHELL_REAPER_HXX_INCLUDED 1
+
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hthread.hxx>
+
+#include "src/systemshell.hxx"
+#include "src/shell/process.hxx"
+
+namespace huginn {
+
+/*! \brief Background job completion watcher.
+ *
+ * On Linux every running stage of a background job gets a pidfd(2)
+ * registered in a single epoll(7) instance, and a helper thread sleeps in epoll_wait(2)
+ * until any of them exits. The event leads directly to the finished stage,
+ * which is reaped at once, and the `[n] Done` notice is printed as soon as
+ * the whole job completes, not when the next command line finishes.
+ * Elsewhere, or if the kernel lacks pidfd support, jobs are only noticed by `cleanup_jobs()`.
+ */
+class HSystemShell::HReaper {
+	struct OWatch {
+		HJob* _job;
+		HProcess* _process;
+	};
+	typedef yaal::hcore::HHashMap<int, OWatch> watches_t;
+	HSystemShell& _systemShell;
+	int _epoll;
+	int _wakeUp;
+	watches_t _watches;
+	yaal::hcore::HThread _thread;
+public:
+	HReaper( HSystemShell& );
+	~HReaper( void );
+	/*! \brief Start watching all running stages of given background job.
+	 */
+	void watch( HJob& );
+	/*! \brief Stop watching given job, must be called before the job is destroyed.
+	 */
+	void forget( HJob const& );
+private:
+	bool start( void );
+	void run( void );
+	void dispatch( int );
+	void unwatch( int );
+	HReaper( HReaper const& ) = delete;
+	HReaper& operator = ( HReaper const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_REAPER_HXX_INCLUDED */
+
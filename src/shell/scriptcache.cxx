@@ -0,0 +1,130 @@
+/* Read huginn/LICENSE.md file for copyright and licensing information. */
+
+#ifndef __MSVCXX__
+#	include <sys/stat.h>
+#endif
+
+#include <yaal/tools/hfsitem.hxx>
+#include <yaal/tools/streamtools.hxx>
+
+M_VCSID( "$Id: " __ID__ " $" )
+M_VCSID( "$Id: " __TID__ " $" )
+
+#include "scriptcache.hxx"
+#include "src/quotes.hxx"
+
+using namespace yaal;
+using namespace yaal::hcore;
+using namespace yaal::tools;
+
+namespace huginn {
+
+HSystemShell::HScriptCache::HScriptCache( void )
+	: _scripts()
+	, _mutex() {
+	return;
+}
+
+HSystemShell::HScriptCache::script_t HSystemShell::HScriptCache::parse( yaal::hcore::HStreamInterface& stream_ ) {
+	M_PROLOG
+	script_t script( make_pointer<lines_t>() );
+	HString line;
+	int lineNo( 1 );
+	HString code;
+	while ( getline( stream_, line ).good() ) {
+		code.append( line );
+		if ( ! line.is_empty() && ( line.back() == '\\'_ycp ) ) {
+			code.pop_back();
+			code.push_back( ' '_ycp );
+			++ lineNo;
+			continue;
+		}
+		script->emplace_back( lineNo, code );
+		OLine& l( script->back() );
+		/*
+		 * History substitution (`!!`) depends on the state of the session
+		 * so lines that could use it are tokenized when run.
+		 */
+		if ( code.find( '!'_ycp ) == HString::npos ) {
+			try {
+				l._tokens = tokenize_shell( code );
+				l._tokenized = true;
+			} catch ( HException const& ) {
+				/* Report the error with its line when the line is run. */
+			}
+		}
+		code.clear();
+		++ lineNo;
+	}
+	return ( script );
+	M_EPILOG
+}
+
+/*
+ * Modification time alone, with one second resolution, misses edits
+ * made within the same second the script was cached in,
+ * and replacing the file (editors save to a new file and rename it) changes its inode.
+ * Returns false iff path is not a regular file.
+ */
+bool HSystemShell::HScriptCache::stamp( yaal::tools::filesystem::path_t const& path_, OStamp& stamp_ ) {
+	M_PROLOG
+#ifndef __MSVCXX__
+	HUTF8String utf8( path_ );
+	struct stat s;
+	if ( ( ::stat( utf8.c_str(), &s ) != 0 ) || ! S_ISREG( s.st_mode ) ) {
+		return ( false );
+	}
+	i64_t const NS( 1000000000LL );
+	stamp_._inode = static_cast<i64_t>( s.st_ino );
+	stamp_._size = static_cast<i64_t>( s.st_size );
+#	ifdef __HOST_OS_TYPE_DARWIN__
+	stamp_._modified = static_cast<i64_t>( s.st_mtimespec.tv_sec ) * NS + s.st_mtimespec.tv_nsec;
+	stamp_._changed = static_cast<i64_t>( s.st_ctimespec.tv_sec ) * NS + s.st_ctimespec.tv_nsec;
+#	else
+	stamp_._modified = static_cast<i64_t>( s.st_mtim.tv_sec ) * NS + s.st_mtim.tv_nsec;
+	stamp_._changed = static_cast<i64_t>( s.st_ctim.tv_sec ) * NS + s.st_ctim.tv_nsec;
+#	endif
+	return ( true );
+#else
+	try {
+		HFSItem fsItem( path_ );
+		if ( ! fsItem || fsItem.is_directory() ) {
+			return ( false );
+		}
+		stamp_._size = fsItem.get_size();
+		stamp_._modified = fsItem.modified().raw();
+	} catch ( HException const& ) {
+		return ( false );
+	}
+	return ( true );
+#endif
+	M_EPILOG
+}
+
+HSystemShell::HScriptCache::script_t HSystemShell::HScriptCache::get( yaal::hcore::HStreamInterface& stream_, yaal::tools::filesystem::path_t const& path_ ) {
+	M_PROLOG
+	OStamp fileStamp;
+	if ( ! stamp( path_, fileStamp ) ) {
+		return ( script_t() );
+	}
+	/* scope for lock */ {
+		HLock l( _mutex );
+		scripts_t::const_iterator it( _scripts.find( path_ ) );
+		if ( ( it != _scripts.end() ) && ( it->second._stamp == fileStamp ) ) {
+			return ( it->second._lines );
+		}
+	}
+	script_t script( parse( stream_ ) );
+	HLock l( _mutex );
+	if ( _scripts.get_size() >= MAX_SCRIPTS ) {
+		_scripts.clear();
+	}
+	OScript& s( _scripts[path_] );
+	s._stamp = fileStamp;
+	s._lines = script;
+	return ( script );
+	M_EPILOG
+}
+
+}
+
@@ -0,0 +1,89 @@
+#ifndef HUGINN_SHELL_SCRIPTCACHE_HXX_INCLUDED
+#define HUGINN_SHELL_SCRIPTCACHE_HXX_INCLUDED 1
+
+#include <yaal/hcore/hhashmap.hxx>
+#include <yaal/hcore/hpointer.hxx>
+#include <yaal/hcore/hthread.hxx>
+
+#include "src/systemshell.hxx"
+
+namespace huginn {
+
+/*! \brief Cache of tokenized shell scripts.
+ *
+ * Scripts are split into logical lines (with backslash continuations joined)
+ * and each line is tokenized once, words are kept unexpanded,
+ * aliases, variables and globs are resolved every time the line is run.
+ * Entries are keyed by script path and are valid as long as
+ * script inode, size, and modification and status change times (with nanosecond resolution) do not change,
+ * so sourcing the same rc or helper file again skips reading and tokenization.
+ */
+class HSystemShell::HScriptCache {
+public:
+	struct OLine {
+		int _lineNo;
+		yaal::hcore::HString _code;
+		tokens_t _tokens;
+		bool _tokenized;
+		OLine( int lineNo_, yaal::hcore::HString const& code_ )
+			: _lineNo( lineNo_ )
+			, _code( code_ )
+			, _tokens()
+			, _tokenized( false ) {
+		}
+	};
+	typedef yaal::hcore::HArray<OLine> lines_t;
+	typedef yaal::hcore::HPointer<lines_t> script_t;
+	static int const MAX_SCRIPTS = 256;
+private:
+	struct OStamp {
+		yaal::i64_t _inode;
+		yaal::i64_t _size;
+		yaal::i64_t _modified;
+		yaal::i64_t _changed;
+		OStamp( void )
+			: _inode( 0 )
+			, _size( 0 )
+			, _modified( 0 )
+			, _changed( 0 ) {
+		}
+		bool operator == ( OStamp const& other_ ) const {
+			return (
+				( _inode == other_._inode )
+				&& ( _size == other_._size )
+				&& ( _modified == other_._modified )
+				&& ( _changed == other_._changed )
+			);
+		}
+	};
+	struct OScript {
+		OStamp _stamp;
+		script_t _lines;
+		OScript( void )
+			: _stamp()
+			, _lines() {
+		}
+	};
+	typedef yaal::hcore::HHashMap<yaal::tools::filesystem::path_t, OScript> scripts_t;
+	scripts_t _scripts;
+	yaal::hcore::HMutex _mutex;
+public:
+	HScriptCache( void );
+	/*! \brief Get tokenized form of a script.
+	 *
+	 * \param stream - script source, read only if script is not in the cache.
+	 * \param path - script path.
+	 * \return Tokenized script or null if script is not a regular file and cannot be cached.
+	 */
+	script_t get( yaal::hcore::HStreamInterface&, yaal::tools::filesystem::path_t const& );
+private:
+	static script_t parse( yaal::hcore::HStreamInterface& );
+	static bool stamp( yaal::tools::filesystem::path_t const&, OStamp& );
+	HScriptCache( HScriptCache const& ) = delete;
+	HScriptCache& operator = ( HScriptCache const& ) = delete;
+};
+
+}
+
+#endif /* #ifndef HUGINN_SHELL_SCRIPTCACHE_HXX_INCLUDED */
+
@@ -9,6 +9,7 @@
 #include "src/systemshell.hxx"
 #include "src/quotes.hxx"
 #include "capture.hxx"
+#include "glob.hxx"
 
 using namespace yaal;
 using namespace yaal::hcore;
@@ -74,29 +75,16 @@ bool is_suid( yaal::tools::filesystem::path_t const& path_ ) {
 	return ( ( fsItem.get_permissions() & 06000 ) != 0 );
 }
 
-inline bool dot_start( yaal::hcore::HString const& s_ ) {
-	return ( ! s_.is_empty() && ( s_.front() == '.' ) );
-}
-
-void apply_glob( yaal::tools::string::tokens_t& interpolated_, yaal::hcore::HString&& param_, bool wantGlob_ ) {
+void apply_glob( HSystemShell::HGlob& glob_, yaal::tools::string::tokens_t& interpolated_, yaal::hcore::HString&& param_, bool wantGlob_ ) {
 	M_PROLOG
 	if ( ! wantGlob_ ) {
 		interpolated_.push_back( unescape_system( yaal::move( param_ ) ) );
 		return;
 	}
 	semantic_unescape( param_ );
-	filesystem::paths_t fr( filesystem::glob( param_ ) );
+	filesystem::paths_t fr( glob_.glob( param_ ) );
 	if ( ! fr.is_empty() ) {
-		if ( dot_start( param_ ) ) {
-			interpolated_.insert( interpolated_.end(), fr.begin(), fr.end() );
-		} else {
-			remove_copy_if(
-				fr.begin(),
-				fr.end(),
-				back_insert_iterator( interpolated_ ),
-				dot_start
-			);
-		}
+		interpolated_.insert( interpolated_.end(), fr.begin(), fr.end() );
 	} else {
 		interpolated_.push_back( unescape_system( yaal::move( param_ ) ) );
 	}
@@ -158,7 +146,16 @@ void HSystemShell::resolve_string_aliases( tokens_t& tokens_, tokens_t::iterator
 
 HSystemShell::chains_t HSystemShell::split_chains( yaal::hcore::HString const& str_, EVALUATION_MODE evaluationMode_ ) const {
 	M_PROLOG
-	tokens_t tokens( tokenize_shell_tilda( str_ ) );
+	return ( split_chains( tokenize_shell( str_ ), evaluationMode_ ) );
+	M_EPILOG
+}
+
+HSystemShell::chains_t HSystemShell::split_chains( tokens_t&& tokens_, EVALUATION_MODE evaluationMode_ ) const {
+	M_PROLOG
+	tokens_t tokens( yaal::move( tokens_ ) );
+	for ( HString& t : tokens ) {
+		denormalize_path( t );
+	}
 	if ( evaluationMode_ != EVALUATION_MODE::TRIAL ) {
 		bool head( true );
 		for ( tokens_t::iterator it( tokens.begin() ); it != tokens.end(); ++ it ) {
@@ -351,9 +348,13 @@ void HSystemShell::substitute_command( yaal::hcore::HString& token_ ) {
 			continue;
 		}
 		if ( inExecQuotes && ( c == ')' ) ) {
-			HCapture capture( QUOTES::EXEC );
+			HCapture capture( QUOTES::EXEC, _captureMaxSize );
 			run_line( subst, EVALUATION_MODE::COMMAND_SUBSTITUTION, &capture );
-			token_.append( capture.buffer() );
+			if ( token_.is_empty() ) {
+				token_ = capture.release_buffer();
+			} else {
+				token_.append( capture.release_buffer() );
+			}
 			subst.clear();
 			inExecQuotes = false;
 			continue;
@@ -385,5 +386,9 @@ bool HSystemShell::is_executable( yaal::hcore::HString const& cmd_ ) const {
 	return ( ( _systemCommands.count( cmd_ ) > 0 ) || ( _systemSuperUserCommands.count( cmd_ ) > 0 ) );
 }
 
+bool HSystemShell::is_core_util( yaal::hcore::HString const& cmd_ ) const {
+	return ( _fastBuiltins && ( _coreUtils.count( cmd_ ) > 0 ) );
+}
+
 }
 
@@ -4,6 +4,8 @@
 #include <yaal/tools/stringalgo.hxx>
 #include <yaal/tools/filesystem.hxx>
 
+#include "src/systemshell.hxx"
+
 namespace huginn {
 
 extern char const ARG_AT[];
@@ -11,7 +13,7 @@ yaal::hcore::HString stringify_command( yaal::tools::string::tokens_t const&, in
 yaal::tools::filesystem::path_t compact_path( yaal::tools::filesystem::path_t const& );
 yaal::tools::filesystem::path_t escape_path( yaal::tools::filesystem::path_t const& );
 bool is_suid( yaal::tools::filesystem::path_t const& );
-void apply_glob( yaal::tools::string::tokens_t&, yaal::hcore::HString&&, bool );
+void apply_glob( HSystemShell::HGlob&, yaal::tools::string::tokens_t&, yaal::hcore::HString&&, bool );
 
 }
 
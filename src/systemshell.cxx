@@ -27,6 +27,11 @@ M_VCSID( "$Id: " __TID__ " $" )
 #include "setup.hxx"
 #include "shell/capture.hxx"
 #include "shell/util.hxx"
+#include "shell/commandindex.hxx"
+#include "shell/fileinfocache.hxx"
+#include "shell/glob.hxx"
+#include "shell/scriptcache.hxx"
+#include "shell/reaper.hxx"
 
 #ifndef __MSVCXX__
 
@@ -75,7 +80,12 @@ HSystemShell::HSystemShell( HLineRunner& lr_, HRepl& repl_, int argc_, char** ar
 	, _repl( repl_ )
 	, _systemCommands()
 	, _systemSuperUserCommands()
+	, _commandIndex( make_resource<HCommandIndex>() )
+	, _fileInfoCache( make_resource<HFileInfoCache>() )
+	, _glob( make_resource<HGlob>() )
+	, _scriptCache( make_resource<HScriptCache>() )
 	, _builtins()
+	, _coreUtils()
 	, _aliases()
 	, _keyBindings()
 	, _setoptHandlers()
@@ -84,12 +94,15 @@ HSystemShell::HSystemShell( HLineRunner& lr_, HRepl& repl_, int argc_, char** ar
 	, _prefixCommands()
 	, _ignoredFiles( "^.*~$" )
 	, _tracePrompt( "+ " )
+	, _reaper( make_resource<HReaper>( *this ) )
 	, _jobs()
 	, _activelySourced()
 	, _activelySourcedStack()
 	, _failureMessages()
+	, _captureMaxSize( 0 )
 	, _previousOwner( -1 )
 	, _trace( false )
+	, _fastBuiltins( false )
 	, _background( false )
 	, _loaded( false )
 	, _argvs()
@@ -170,12 +183,23 @@ void HSystemShell::register_commands( void ) {
 	_builtins.insert( make_pair( "source",   &HSystemShell::source      ) );
 	_builtins.insert( make_pair( "unalias",  &HSystemShell::unalias     ) );
 	_builtins.insert( make_pair( "unsetenv", &HSystemShell::unsetenv    ) );
+	_coreUtils.insert( make_pair( "[",        &HSystemShell::core_test     ) );
+	_coreUtils.insert( make_pair( "basename", &HSystemShell::core_basename ) );
+	_coreUtils.insert( make_pair( "dirname",  &HSystemShell::core_dirname  ) );
+	_coreUtils.insert( make_pair( "echo",     &HSystemShell::core_echo     ) );
+	_coreUtils.insert( make_pair( "false",    &HSystemShell::core_false    ) );
+	_coreUtils.insert( make_pair( "printf",   &HSystemShell::core_printf   ) );
+	_coreUtils.insert( make_pair( "test",     &HSystemShell::core_test     ) );
+	_coreUtils.insert( make_pair( "true",     &HSystemShell::core_true     ) );
 	_setoptHandlers.insert( make_pair( "ignore_filenames", &HSystemShell::setopt_ignore_filenames ) );
 	_setoptHandlers.insert( make_pair( "history_path",     &HSystemShell::setopt_history_path ) );
 	_setoptHandlers.insert( make_pair( "history_max_size", &HSystemShell::setopt_history_max_size ) );
+	_setoptHandlers.insert( make_pair( "capture_max_size", &HSystemShell::setopt_capture_max_size ) );
+	_setoptHandlers.insert( make_pair( "file_info_ttl",    &HSystemShell::setopt_file_info_ttl ) );
 	_setoptHandlers.insert( make_pair( "super_user_paths", &HSystemShell::setopt_super_user_paths ) );
 	_setoptHandlers.insert( make_pair( "trace",            &HSystemShell::setopt_trace ) );
 	_setoptHandlers.insert( make_pair( "prefix_commands",  &HSystemShell::setopt_prefix_commands ) );
+	_setoptHandlers.insert( make_pair( "fast_builtins",    &HSystemShell::setopt_fast_builtins ) );
 	_setoptHandlers.insert( make_pair( "--print",          &HSystemShell::setopt_print ) );
 	HHuginn& h( *_lineRunner.huginn() );
 	tools::huginn::register_function( h, "shell_run", call( &HSystemShell::run_result, this, _1 ), "( *commandStr* ) - run shell command expressed by *commandStr*" );
@@ -343,6 +367,8 @@ HSystemShell::~HSystemShell( void ) {
 		}
 	}
 	session_stop();
+	/* Jobs must not be reported while the shell is being torn down. */
+	_reaper.reset();
 }
 
 
@@ -359,7 +385,9 @@ void HSystemShell::cleanup_jobs( void ) {
 		HPipedChild::STATUS const& status( job->status() );
 		if ( ( status.type != HPipedChild::STATUS::TYPE::RUNNING ) && ( status.type != HPipedChild::STATUS::TYPE::PAUSED ) ) {
 			flush_faliures( job );
-			cerr << "[" << no << "] Done " << colorize( job->description(), this ) << endl;
+			if ( ! job->reported() ) {
+				cerr << "[" << no << "] Done " << colorize( job->description(), this ) << endl;
+			}
 			it = _jobs.erase( it );
 		} else {
 			++ it;
@@ -455,10 +483,18 @@ int HSystemShell::do_run_script( yaal::hcore::HStreamInterface& shellScript_, ya
 			}
 		)
 	);
+	HScriptCache::script_t script( _scriptCache->get( shellScript_, path_ ) );
+	int exitStatus( 0 );
+	if ( !! script ) {
+		for ( HScriptCache::OLine const& line : *script ) {
+			exitStatus = run_script_line( path_, line._lineNo, line._code, line._tokenized ? &line._tokens : nullptr );
+		}
+		return exitStatus;
+	}
+	/* Not a regular file, commands run by the script can consume the rest of it. */
 	HString line;
 	int lineNo( 1 );
 	HString code;
-	int exitStatus( 0 );
 	while ( getline( shellScript_, line ).good() ) {
 		code.append( line );
 		if ( ! line.is_empty() && ( line.back() == '\\'_ycp ) ) {
@@ -467,25 +503,38 @@ int HSystemShell::do_run_script( yaal::hcore::HStreamInterface& shellScript_, ya
 			++ lineNo;
 			continue;
 		}
-		try {
-			_failureMessages.clear();
-			exitStatus = run_line( code, EVALUATION_MODE::DIRECT ).exit_status().value;
-			code.clear();
-			if ( ! _failureMessages.is_empty() ) {
-				cerr << path_ << ":" << lineNo << ": " << string::join( _failureMessages, " " ) << endl;
-			}
-			_failureMessages.clear();
-		} catch ( HException const& e ) {
-			cerr << "code: `" << code << "`" << endl;
-			cerr << path_ << ":" << lineNo << ": " << e.what() << endl;
-			throw;
-		}
+		exitStatus = run_script_line( path_, lineNo, code, nullptr );
+		code.clear();
 		++ lineNo;
 	}
 	return exitStatus;
 	M_EPILOG
 }
 
+int HSystemShell::run_script_line( yaal::hcore::HString const& path_, int lineNo_, yaal::hcore::HString const& code_, tokens_t const* tokens_ ) {
+	M_PROLOG
+	int exitStatus( 0 );
+	try {
+		_failureMessages.clear();
+		if ( tokens_ ) {
+			chains_t chains( split_chains( tokens_t( *tokens_ ), EVALUATION_MODE::DIRECT ) );
+			exitStatus = run_chains( chains, EVALUATION_MODE::DIRECT, nullptr ).exit_status().value;
+		} else {
+			exitStatus = run_line( code_, EVALUATION_MODE::DIRECT ).exit_status().value;
+		}
+		if ( ! _failureMessages.is_empty() ) {
+			cerr << path_ << ":" << lineNo_ << ": " << string::join( _failureMessages, " " ) << endl;
+		}
+		_failureMessages.clear();
+	} catch ( HException const& e ) {
+		cerr << "code: `" << code_ << "`" << endl;
+		cerr << path_ << ":" << lineNo_ << ": " << e.what() << endl;
+		throw;
+	}
+	return ( exitStatus );
+	M_EPILOG
+}
+
 void HSystemShell::learn_system_commands( void ) {
 	M_PROLOG
 	HLock l( _mutex );
@@ -495,40 +544,22 @@ void HSystemShell::learn_system_commands( void ) {
 	}
 	tokens_t paths( split<>( PATH_ENV, PATH_ENV_SEP ) );
 	reverse( paths.begin(), paths.end() );
-	learn_system_commands( _systemCommands, paths );
+	_systemCommands.clear();
+	_commandIndex->learn( _systemCommands, paths );
 	paths = _superUserPaths;
 	reverse( paths.begin(), paths.end() );
-	learn_system_commands( _systemSuperUserCommands, paths );
+	_systemSuperUserCommands.clear();
+	_commandIndex->learn( _systemSuperUserCommands, paths );
+	_commandIndex->save();
 	return;
 	M_EPILOG
 }
 
-void HSystemShell::learn_system_commands( system_commands_t& commands_, yaal::tools::filesystem::paths_t const& paths_ ) {
+void HSystemShell::refresh_system_commands( void ) {
 	M_PROLOG
-	for ( filesystem::path_t const& p : paths_ ) {
-		try {
-			HFSItem dir( p );
-			if ( ! dir ) {
-				continue;
-			}
-			for ( HFSItem const& file : dir ) {
-				HString name( file.get_name() );
-#ifndef __MSVCXX__
-				if ( ! ( file.is_executable() && file.is_file() ) ) {
-					continue;
-				}
-#else
-				name.lower();
-				HString ext( name.right( 4 ) );
-				if ( ( ext != ".exe" ) && ( ext != ".com" ) && ( ext != ".cmd" ) && ( ext != ".bat" ) ) {
-					continue;
-				}
-				name.erase( name.get_size() - 4 );
-#endif
-				commands_[name] = p;
-			}
-		} catch ( HFSItemException const& ) {
-		}
+	HLock l( _mutex );
+	if ( _commandIndex->changed() ) {
+		learn_system_commands();
 	}
 	return;
 	M_EPILOG
@@ -538,10 +569,13 @@ HShell::HLineResult HSystemShell::do_run( yaal::hcore::HString const& line_ ) {
 	M_PROLOG
 	HLineResult lineResult;
 	try {
+		refresh_system_commands();
 		lineResult = run_line( line_, EVALUATION_MODE::DIRECT );
 	} catch ( HException const& e ) {
 		cerr << e.what() << endl;
 	}
+	/* Executed command could have changed anything on the file system. */
+	_fileInfoCache->invalidate();
 	return lineResult;
 	M_EPILOG
 }
@@ -583,15 +617,21 @@ HSystemShell::HLineResult HSystemShell::run_line( yaal::hcore::HString const& li
 	}
 	substitute_from_history( line );
 	chains_t chains( split_chains( line, evaluationMode_ ) );
+	return ( run_chains( chains, evaluationMode_, capture_ ) );
+	M_EPILOG
+}
+
+HSystemShell::HLineResult HSystemShell::run_chains( chains_t& chains_, EVALUATION_MODE evaluationMode_, HCapture* capture_ ) {
+	M_PROLOG
 	HLineResult lineResult;
-	for ( OChain& c : chains ) {
+	for ( OChain& c : chains_ ) {
 		if ( c._background && ( evaluationMode_ == EVALUATION_MODE::COMMAND_SUBSTITUTION ) ) {
 			throw HRuntimeException( "Background jobs in command substitution are forbidden." );
 		}
 		if ( c._tokens.is_empty() ) {
 			continue;
 		}
-		lineResult = run_chain( c._tokens, c._background, capture_, evaluationMode_, &c == &chains.back() );
+		lineResult = run_chain( c._tokens, c._background, capture_, evaluationMode_, &c == &chains_.back() );
 	}
 	return lineResult;
 	M_EPILOG
@@ -766,6 +806,7 @@ HSystemShell::HLineResult HSystemShell::run_pipe( tokens_t& tokens_, bool backgr
 	if ( background_ ) {
 		HLock l( _mutex );
 		_jobs.emplace_back( yaal::move( job ) );
+		_reaper->watch( j );
 		return ( HLineResult() );
 	}
 	HLineResult sr( validShell, j.wait_for_finish() );
@@ -840,13 +881,15 @@ tokens_t HSystemShell::interpolate( yaal::hcore::HString const& token_, EVALUATI
 				strip_quotes( token );
 			}
 			if ( ( evaluationMode_ == EVALUATION_MODE::DIRECT ) && ( ( quotes == QUOTES::EXEC ) || ( quotes == QUOTES::EXEC_SOURCE ) || ( quotes == QUOTES::EXEC_SINK ) ) ) {
-				capture_t capture( make_pointer<HCapture>( quotes ) );
+				capture_t capture( make_pointer<HCapture>( quotes, _captureMaxSize ) );
 				if ( quotes != QUOTES::EXEC ) {
 					capture->set_call( call( &HSystemShell::run_substituted, this, token, capture.raw() ) );
 				} else {
 					run_line( token, EVALUATION_MODE::COMMAND_SUBSTITUTION, capture.raw() );
+					/* Substituted command could have changed the file system. */
+					_glob->invalidate();
 				}
-				token.assign( capture->buffer() );
+				token = capture->release_buffer();
 				if ( command_ ) {
 					command_->add_capture( capture );
 				}
@@ -874,9 +917,9 @@ tokens_t HSystemShell::interpolate( yaal::hcore::HString const& token_, EVALUATI
 			if ( words.get_size() > 1 ) {
 				wantGlob = wantGlob || ( words.front().find_one_of( globChars ) != HString::npos );
 				param.append( yaal::move( words.front() ) );
-				apply_glob( interpolated, yaal::move( param ), wantGlob );
+				apply_glob( *_glob, interpolated, yaal::move( param ), wantGlob );
 				for ( tokens_t::iterator it( words.begin() + 1 ), end( words.end() - 1 ); it != end; ++ it ) {
-					apply_glob( interpolated, yaal::move( *it ), wantGlob );
+					apply_glob( *_glob, interpolated, yaal::move( *it ), wantGlob );
 				}
 				param.assign( yaal::move( words.back() ) );
 				wantGlob = param.find_one_of( globChars ) != HString::npos;
@@ -886,7 +929,7 @@ tokens_t HSystemShell::interpolate( yaal::hcore::HString const& token_, EVALUATI
 			}
 		}
 		if ( ! ( argAtSubsituted && param.is_empty() ) ) {
-			apply_glob( interpolated, yaal::move( param ), wantGlob );
+			apply_glob( *_glob, interpolated, yaal::move( param ), wantGlob );
 		}
 	}
 	return interpolated;
@@ -894,6 +937,7 @@ tokens_t HSystemShell::interpolate( yaal::hcore::HString const& token_, EVALUATI
 
 tokens_t HSystemShell::denormalize( tokens_t& tokens_, EVALUATION_MODE evaluationMode_, OCommand* command_ ) {
 	M_PROLOG
+	HGlob::HScope globScope( *_glob );
 	tokens_t tmp;
 	tokens_t result;
 	bool expandExec( _builtins.count( tokens_.front() ) == 0 );
@@ -1146,6 +1190,10 @@ HSystemShell::system_commands_t const& HSystemShell::system_commands( void ) con
 	return ( _systemCommands );
 }
 
+HSystemShell::HFileInfoCache const& HSystemShell::file_info_cache( void ) const {
+	return ( *_fileInfoCache );
+}
+
 HSystemShell::aliases_t const& HSystemShell::aliases( void ) const {
 	return ( _aliases );
 }
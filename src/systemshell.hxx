@@ -36,6 +36,20 @@ public:
 	class HJob;
 	class HCapture;
 	typedef yaal::hcore::HPointer<HCapture> capture_t;
+	class HChannel;
+	typedef yaal::hcore::HPointer<HChannel> channel_t;
+	class HCommandIndex;
+	typedef yaal::hcore::HResource<HCommandIndex> command_index_t;
+	class HFileInfoCache;
+	typedef yaal::hcore::HResource<HFileInfoCache> file_info_cache_t;
+	class HScriptCache;
+	typedef yaal::hcore::HResource<HScriptCache> script_cache_t;
+	class HGlob;
+	typedef yaal::hcore::HResource<HGlob> glob_engine_t;
+	class HProcess;
+	typedef yaal::hcore::HResource<HProcess> process_t;
+	class HReaper;
+	typedef yaal::hcore::HResource<HReaper> reaper_t;
 	struct OChain {
 		tokens_t _tokens;
 		bool _background;
@@ -61,7 +75,12 @@ private:
 	HRepl& _repl;
 	system_commands_t _systemCommands;
 	system_commands_t _systemSuperUserCommands;
+	command_index_t _commandIndex;
+	file_info_cache_t _fileInfoCache;
+	glob_engine_t _glob;
+	script_cache_t _scriptCache;
 	builtins_t _builtins;
+	builtins_t _coreUtils;
 	aliases_t _aliases;
 	key_bindings_t _keyBindings;
 	setopt_handlers_t _setoptHandlers;
@@ -70,12 +89,15 @@ private:
 	prefix_commands_t _prefixCommands;
 	yaal::hcore::HRegex _ignoredFiles;
 	yaal::hcore::HString _tracePrompt;
+	reaper_t _reaper;
 	jobs_t _jobs;
 	actively_sourced_t _activelySourced;
 	actively_sourced_stack_t _activelySourcedStack;
 	tokens_t _failureMessages;
+	int long _captureMaxSize;
 	int _previousOwner;
 	bool _trace;
+	bool _fastBuiltins;
 	bool _background;
 	bool _loaded;
 	argvs_t _argvs;
@@ -84,6 +106,7 @@ public:
 	HSystemShell( HLineRunner&, HRepl&, int = 0, char** = nullptr );
 	~HSystemShell( void );
 	system_commands_t const& system_commands( void ) const;
+	HFileInfoCache const& file_info_cache( void ) const;
 	aliases_t const& aliases( void ) const;
 	builtins_t const& builtins( void ) const;
 	HLineRunner& line_runner( void );
@@ -115,9 +138,17 @@ private:
 	void exec [[noreturn]]( OCommand& );
 	void exit( OCommand& );
 	void help( OCommand& );
+	void core_echo( OCommand& );
+	void core_test( OCommand& );
+	void core_true( OCommand& );
+	void core_false( OCommand& );
+	void core_basename( OCommand& );
+	void core_dirname( OCommand& );
+	void core_printf( OCommand& );
 private:
 	void source_global( char const* );
 	HLineResult run_line( yaal::hcore::HString const&, EVALUATION_MODE, HCapture* = nullptr );
+	HLineResult run_chains( chains_t&, EVALUATION_MODE, HCapture* );
 	HLineResult run_chain( tokens_t const&, bool, HCapture*, EVALUATION_MODE, bool );
 	HLineResult run_pipe( tokens_t&, bool, HCapture*, EVALUATION_MODE, bool, bool );
 	bool spawn( OCommand&, int, bool, EVALUATION_MODE );
@@ -133,7 +164,7 @@ private:
 	void set_environment( void );
 	void register_commands( void );
 	void learn_system_commands( void );
-	void learn_system_commands( system_commands_t&, yaal::tools::filesystem::paths_t const& );
+	void refresh_system_commands( void );
 	void run_bound( yaal::hcore::HString const& );
 	void run_substituted( yaal::hcore::HString const&, HCapture* );
 	int run_result( yaal::hcore::HString const& );
@@ -153,12 +184,16 @@ private:
 	bool is_prefix_command( yaal::hcore::HString const& ) const;
 	bool is_alias( yaal::hcore::HString const& ) const;
 	bool is_executable( yaal::hcore::HString const& ) const;
+	bool is_core_util( yaal::hcore::HString const& ) const;
 	void setopt_ignore_filenames( OCommand& );
 	void setopt_history_path( OCommand& );
 	void setopt_history_max_size( OCommand& );
+	void setopt_capture_max_size( OCommand& );
+	void setopt_file_info_ttl( OCommand& );
 	void setopt_super_user_paths( OCommand& );
 	void setopt_trace( OCommand& );
 	void setopt_prefix_commands( OCommand& );
+	void setopt_fast_builtins( OCommand& );
 	void setopt_print( OCommand& );
 	void cleanup_jobs( void );
 	bool is_tracing( void ) const;
@@ -168,8 +203,11 @@ private:
 	yaal::hcore::HString setopt_print_super_user_paths( void ) const;
 	yaal::hcore::HString setopt_print_prefix_commands( void ) const;
 	yaal::hcore::HString setopt_print_history_max_size( void ) const;
+	yaal::hcore::HString setopt_print_capture_max_size( void ) const;
+	yaal::hcore::HString setopt_print_file_info_ttl( void ) const;
 	yaal::hcore::HString setopt_print_history_path( void ) const;
 	yaal::hcore::HString setopt_print_ignore_filenames( void ) const;
+	yaal::hcore::HString setopt_print_fast_builtins( void ) const;
 	virtual bool do_is_valid_command( yaal::hcore::HString const& ) override;
 	virtual bool do_try_command( yaal::hcore::HString const& ) override;
 	virtual HLineResult do_run( yaal::hcore::HString const& ) override;
@@ -181,8 +219,10 @@ private:
 	virtual completions_t do_gen_completions( yaal::hcore::HString const&, yaal::hcore::HString const&, bool ) const override;
 	void do_source( tokens_t const& );
 	virtual int do_run_script( yaal::hcore::HStreamInterface&, yaal::hcore::HString const& ) override;
+	int run_script_line( yaal::hcore::HString const&, int, yaal::hcore::HString const&, tokens_t const* );
 	int get_job_no( char const*, OCommand&, bool );
 	chains_t split_chains( yaal::hcore::HString const&, EVALUATION_MODE ) const;
+	chains_t split_chains( tokens_t&&, EVALUATION_MODE ) const;
 	yaal::hcore::HString expand( yaal::hcore::HString&& );
 	friend class HJob;
 private:
@@ -5,11 +5,11 @@
 #include <yaal/tools/huginn/thread.hxx>
 #include <yaal/tools/huginn/objectfactory.hxx>
 #include <yaal/tools/huginn/helper.hxx>
-#include <yaal/tools/hmemory.hxx>
 
 M_VCSID( "$Id: " __ID__ " $" )
 #include "tags.hxx"
 #include "huginn.hxx"
+#include "scriptsource.hxx"
 #include "setup.hxx"
 
 using namespace yaal;
@@ -58,7 +58,6 @@ char const* symbol_kind_name_short( HHuginn::SYMBOL_KIND symbolKind_ ) {
 class HTagger : public yaal::tools::HIntrospectorInterface {
 private:
 	typedef yaal::hcore::HHashMap<yaal::hcore::HString, HHuginn::SYMBOL_KIND> symbol_kinds_t;
-	typedef yaal::hcore::HArray<yaal::hcore::HString> tags_t;
 	HHuginn& _huginn;
 	symbol_kinds_t _symbolKinds;
 	yaal::hcore::HString _code;
@@ -70,11 +69,8 @@ public:
 		, _code( code_, size_ )
 		, _tags() {
 	}
-	void dump( void ) {
-		sort( _tags.begin(), _tags.end() );
-		for ( yaal::hcore::HString const& tag : _tags ) {
-			cout << tag << endl;
-		}
+	tags_t const& tags( void ) const {
+		return ( _tags );
 	}
 private:
 	virtual void do_introspect( HIntrospecteeInterface& ) override {}
@@ -117,14 +113,11 @@ private:
 
 }
 
-int tags( char const* script_ ) {
+int tags( char const* script_, tags_t& tags_, yaal::hcore::HString& errorMessage_ ) {
 	M_PROLOG
-	HHuginn::disable_grammar_verification();
-	int lineSkip( 0 );
-	buffer_t buffer( ::huginn::load( script_, &lineSkip ) );
-	HMemory source( make_resource<HMemoryObserver>( buffer.data(), buffer.get_size() ), HMemory::INITIAL_STATE::VALID );
+	HScriptSource source( script_, HScriptSource::EMBEDDED::AUTO );
 	HHuginn::ptr_t h( make_pointer<HHuginn>() );
-	h->load( source, script_, lineSkip );
+	h->load( source.stream(), script_, source.line_skip() );
 	h->register_function( "repl", call( &dummy_repl, _1, _2, _3, _4 ), "( [*prompt*] ) - read line of user input potentially prefixing it with *prompt*" );
 	h->preprocess();
 	int retVal( 0 );
@@ -133,17 +126,34 @@ int tags( char const* script_ ) {
 			retVal = 1;
 			break;
 		}
-		HTagger tagger( *h, buffer.data(), static_cast<int>( buffer.get_size() ) );
+		HTagger tagger( *h, source.data(), static_cast<int>( source.size() ) );
 		if ( ! h->compile( setup._modulePath, HHuginn::COMPILER::BE_SLOPPY, &tagger ) ) {
-			cerr << h->error_message() << endl;
+			errorMessage_ = h->error_message();
 			retVal = 2;
 			break;
 		}
-		tagger.dump();
+		tags_.insert( tags_.end(), tagger.tags().begin(), tagger.tags().end() );
 	} while ( false );
 	return retVal;
 	M_EPILOG
 }
 
+int tags( char const* script_ ) {
+	M_PROLOG
+	HHuginn::disable_grammar_verification();
+	tags_t t;
+	hcore::HString errorMessage;
+	int retVal( tags( script_, t, errorMessage ) );
+	if ( ! errorMessage.is_empty() ) {
+		cerr << errorMessage << endl;
+	}
+	sort( t.begin(), t.end() );
+	for ( yaal::hcore::HString const& tag : t ) {
+		cout << tag << endl;
+	}
+	return retVal;
+	M_EPILOG
+}
+
 }
 
@@ -7,9 +7,19 @@
 #ifndef TAGS_HXX_INCLUDED
 #define TAGS_HXX_INCLUDED 1
 
+#include <yaal/hcore/harray.hxx>
+#include <yaal/hcore/hstring.hxx>
+
 namespace huginn {
 
+typedef yaal::hcore::HArray<yaal::hcore::HString> tags_t;
+
 int tags( char const* );
+/*! \brief Collect (unsorted) tags of single program.
+ *
+ * Safe to call from several threads at once, each call uses its own interpreter.
+ */
+int tags( char const*, tags_t&, yaal::hcore::HString& );
 
 }
 
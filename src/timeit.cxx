@@ -1,6 +1,10 @@
 /* Read huginn/LICENSE.md file for copyright and licensing information. */
 
+#include <cmath>
+
 #include <yaal/hcore/hfile.hxx>
+#include <yaal/hcore/hclock.hxx>
+#include <yaal/hcore/algorithm.hxx>
 M_VCSID( "$Id: " __ID__ " $" )
 M_VCSID( "$Id: " __TID__ " $" )
 #include "timeit.hxx"
@@ -12,20 +16,100 @@ using namespace yaal::tools;
 
 namespace huginn {
 
-bool timeit( HHuginn& huginn_, time::duration_t& preciseTime_, int& runs_ ) {
+namespace {
+
+typedef HArray<i64_t> nanoseconds_t;
+
+/* Nearest-rank percentile of sorted samples. */
+i64_t percentile( nanoseconds_t const& sorted_, int percent_ ) {
+	int long count( sorted_.get_size() );
+	int long idx( ( percent_ * count + 99 ) / 100 - 1 );
+	return ( sorted_[max( 0L, min( idx, count - 1 ) )] );
+}
+
+}
+
+OTimeItStatistics::OTimeItStatistics( durations_t const& samples_ )
+	: _samples( 0 )
+	, _rejected( 0 )
+	, _total( 0 )
+	, _min( 0 )
+	, _median( 0 )
+	, _p95( 0 )
+	, _p99( 0 )
+	, _max( 0 )
+	, _mean( 0 )
+	, _stddev( 0 ) {
+	M_PROLOG
+	if ( samples_.is_empty() ) {
+		return;
+	}
+	nanoseconds_t ns;
+	ns.reserve( samples_.get_size() );
+	i64_t total( 0 );
+	for ( time::duration_t const& d : samples_ ) {
+		ns.push_back( d.get() );
+		total += d.get();
+	}
+	_total = time::duration_t( total );
+	sort( ns.begin(), ns.end() );
+	if ( ns.get_size() >= 4 ) {
+		i64_t q1( percentile( ns, 25 ) );
+		i64_t q3( percentile( ns, 75 ) );
+		i64_t fence( ( q3 - q1 ) * 3 / 2 );
+		nanoseconds_t::iterator first( lower_bound( ns.begin(), ns.end(), q1 - fence ) );
+		nanoseconds_t::iterator last( upper_bound( ns.begin(), ns.end(), q3 + fence ) );
+		_rejected = static_cast<int>( ns.get_size() - ( last - first ) );
+		ns.erase( last, ns.end() );
+		ns.erase( ns.begin(), first );
+	}
+	int long count( ns.get_size() );
+	_samples = static_cast<int>( count );
+	i64_t sum( 0 );
+	for ( i64_t v : ns ) {
+		sum += v;
+	}
+	i64_t mean( sum / count );
+	double variance( 0 );
+	for ( i64_t v : ns ) {
+		double delta( static_cast<double>( v - mean ) );
+		variance += delta * delta;
+	}
+	if ( count > 1 ) {
+		variance /= static_cast<double>( count - 1 );
+	}
+	_min = time::duration_t( ns.front() );
+	_median = time::duration_t( percentile( ns, 50 ) );
+	_p95 = time::duration_t( percentile( ns, 95 ) );
+	_p99 = time::duration_t( percentile( ns, 99 ) );
+	_max = time::duration_t( ns.back() );
+	_mean = time::duration_t( mean );
+	_stddev = time::duration_t( static_cast<i64_t>( std::sqrt( variance ) ) );
+	return;
+	M_EPILOG
+}
+
+bool timeit( HHuginn& huginn_, time::duration_t& preciseTime_, int& runs_, durations_t& samples_ ) {
 	bool ok( true );
 	if ( ! setup._timeitRepeats ) {
 		ok = huginn_.execute();
 	} else {
+		for ( int i( 0 ); ok && ( i < setup._timeitWarmup ); ++ i ) {
+			ok = huginn_.execute();
+		}
 		int repeats( *setup._timeitRepeats );
-		while ( ok && ( runs_ < repeats ) ) {
+		i64_t budget( static_cast<i64_t>( setup._timeitBudget ) * 1000000LL );
+		HClock clock;
+		while ( ok && ( ( runs_ < repeats ) || ( clock.get_time_elapsed( time::UNIT::NANOSECOND ) < budget ) ) ) {
 			ok = huginn_.execute();
-			preciseTime_ += huginn_.execution_time();
+			if ( ! ok ) {
+				break;
+			}
+			time::duration_t executionTime( huginn_.execution_time() );
+			preciseTime_ += executionTime;
+			samples_.push_back( executionTime );
 			++ runs_;
 		}
-		if ( ! ok ) {
-			-- runs_;
-		}
 	}
 	return ok;
 }
@@ -38,11 +122,25 @@ void report_timeit(
 	yaal::hcore::time::duration_t const& compile_,
 	yaal::hcore::time::duration_t const& execute_,
 	yaal::hcore::time::duration_t const& preciseTime_,
-	int runs_
+	int runs_,
+	durations_t const& samples_,
+	yaal::hcore::time::duration_t const& codegen_,
+	CODE_CACHE codeCache_
 ) {
 	if ( !! setup._timeitRepeats && ( *setup._timeitRepeats > 0 ) ) {
+		if ( setup._timeitFormat != TIMEIT_FORMAT::TEXT ) {
+			OTimeItPhases phases{ huginn_, load_, preprocess_, parse_, compile_ };
+			report_timeit_statistics( cerr, OTimeItStatistics( samples_ ), setup._timeitWarmup, setup._timeitFormat, &phases );
+			return;
+		}
+		int repetitions( max( *setup._timeitRepeats, runs_ ) );
 		cerr << "Huginn time statistics:";
 		if ( setup._verbose ) {
+			if ( codeCache_ != CODE_CACHE::NONE ) {
+				cerr
+					<< "\ncodegen:          " << lexical_cast<HString>( codegen_ )
+					<< "\ncode cache:       " << ( codeCache_ == CODE_CACHE::HIT ? "hit" : "miss" );
+			}
 			cerr
 				<< "\ninit:             " << lexical_cast<HString>( huginn_ )
 				<< "\nload:             " << lexical_cast<HString>( load_ )
@@ -55,17 +153,110 @@ void report_timeit(
 		}
 		if ( setup._quiet ) {
 			cerr
-				<< " " << *setup._timeitRepeats << " " << ( runs_ > 0 ? lexical_cast<HString>( ( preciseTime_ / runs_ ).get() ) : "not-executed" )
+				<< " " << repetitions << " " << ( runs_ > 0 ? lexical_cast<HString>( ( preciseTime_ / runs_ ).get() ) : "not-executed" )
 				<< " " << ( runs_ > 0 ? lexical_cast<HString>( preciseTime_.get() ) : "not-executed" ) << endl;
 		} else {
 			cerr
-				<< "\nrepetitions:      " << *setup._timeitRepeats
+				<< "\nrepetitions:      " << repetitions
 				<< "\niteration time:   " << ( runs_ > 0 ? lexical_cast<HString>( preciseTime_ / runs_ ) : "not executed" )
 				<< "\ncumulative time:  " << ( runs_ > 0 ? lexical_cast<HString>( preciseTime_ ) : "not executed" )
 				<< endl;
+			if ( runs_ > 1 ) {
+				report_timeit_statistics( cerr, OTimeItStatistics( samples_ ), setup._timeitWarmup, TIMEIT_FORMAT::TEXT );
+			}
 		}
 	}
 }
 
+void report_timeit_statistics( yaal::hcore::HStreamInterface& stream_, OTimeItStatistics const& statistics_, int warmup_, TIMEIT_FORMAT format_, OTimeItPhases const* phases_ ) {
+	M_PROLOG
+	switch ( format_ ) {
+		case ( TIMEIT_FORMAT::TEXT ): {
+			if ( warmup_ > 0 ) {
+				stream_ << "warm-up:          " << warmup_ << "\n";
+			}
+			stream_
+				<< "samples:          " << statistics_._samples << "\n"
+				<< "rejected:         " << statistics_._rejected << " (outside 1.5 IQR, excluded from statistics below)\n"
+				<< "min:              " << lexical_cast<HString>( statistics_._min ) << "\n"
+				<< "median:           " << lexical_cast<HString>( statistics_._median ) << "\n"
+				<< "p95:              " << lexical_cast<HString>( statistics_._p95 ) << "\n"
+				<< "p99:              " << lexical_cast<HString>( statistics_._p99 ) << "\n"
+				<< "max:              " << lexical_cast<HString>( statistics_._max ) << "\n"
+				<< "mean:             " << lexical_cast<HString>( statistics_._mean ) << "\n"
+				<< "stddev:           " << lexical_cast<HString>( statistics_._stddev ) << endl;
+		} break;
+		case ( TIMEIT_FORMAT::JSON ): {
+			stream_
+				<< "{\"samples\": " << statistics_._samples
+				<< ", \"rejected\": " << statistics_._rejected
+				<< ", \"warmup\": " << warmup_
+				<< ", \"total_ns\": " << statistics_._total.get()
+				<< ", \"min_ns\": " << statistics_._min.get()
+				<< ", \"median_ns\": " << statistics_._median.get()
+				<< ", \"p95_ns\": " << statistics_._p95.get()
+				<< ", \"p99_ns\": " << statistics_._p99.get()
+				<< ", \"max_ns\": " << statistics_._max.get()
+				<< ", \"mean_ns\": " << statistics_._mean.get()
+				<< ", \"stddev_ns\": " << statistics_._stddev.get();
+			if ( phases_ ) {
+				stream_
+					<< ", \"init_ns\": " << phases_->_init.get()
+					<< ", \"load_ns\": " << phases_->_load.get()
+					<< ", \"preprocess_ns\": " << phases_->_preprocess.get()
+					<< ", \"parse_ns\": " << phases_->_parse.get()
+					<< ", \"compile_ns\": " << phases_->_compile.get();
+			}
+			stream_ << "}" << endl;
+		} break;
+		case ( TIMEIT_FORMAT::CSV ): {
+			stream_ << "samples,rejected,warmup,total_ns,min_ns,median_ns,p95_ns,p99_ns,max_ns,mean_ns,stddev_ns";
+			if ( phases_ ) {
+				stream_ << ",init_ns,load_ns,preprocess_ns,parse_ns,compile_ns";
+			}
+			stream_
+				<< "\n"
+				<< statistics_._samples << "," << statistics_._rejected << "," << warmup_
+				<< "," << statistics_._total.get() << "," << statistics_._min.get()
+				<< "," << statistics_._median.get() << "," << statistics_._p95.get()
+				<< "," << statistics_._p99.get() << "," << statistics_._max.get()
+				<< "," << statistics_._mean.get() << "," << statistics_._stddev.get();
+			if ( phases_ ) {
+				stream_
+					<< "," << phases_->_init.get() << "," << phases_->_load.get()
+					<< "," << phases_->_preprocess.get() << "," << phases_->_parse.get()
+					<< "," << phases_->_compile.get();
+			}
+			stream_ << endl;
+		} break;
+	}
+	return;
+	M_EPILOG
+}
+
+TIMEIT_FORMAT timeit_format( yaal::hcore::HString const& name_ ) {
+	M_PROLOG
+	TIMEIT_FORMAT format( TIMEIT_FORMAT::TEXT );
+	if ( name_ == "json" ) {
+		format = TIMEIT_FORMAT::JSON;
+	} else if ( name_ == "csv" ) {
+		format = TIMEIT_FORMAT::CSV;
+	} else if ( name_ != "text" ) {
+		throw HRuntimeException( "unknown timeit format: "_ys.append( name_ ) );
+	}
+	return format;
+	M_EPILOG
+}
+
+char const* timeit_format_to_string( TIMEIT_FORMAT format_ ) {
+	char const* fs( "text" );
+	switch ( format_ ) {
+		case ( TIMEIT_FORMAT::TEXT ): fs = "text"; break;
+		case ( TIMEIT_FORMAT::JSON ): fs = "json"; break;
+		case ( TIMEIT_FORMAT::CSV ):  fs = "csv";  break;
+	}
+	return fs;
+}
+
 }
 
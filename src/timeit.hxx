@@ -4,11 +4,52 @@
 #define HUGINN_TIMEIT_HXX_INCLUDED 1
 
 #include <yaal/hcore/duration.hxx>
+#include <yaal/hcore/harray.hxx>
 #include <yaal/tools/hhuginn.hxx>
 
+#include "setup.hxx"
+
 namespace huginn {
 
-bool timeit( yaal::tools::HHuginn&, yaal::hcore::time::duration_t&, int& );
+enum class CODE_CACHE {
+	NONE,
+	HIT,
+	MISS
+};
+
+typedef yaal::hcore::HArray<yaal::hcore::time::duration_t> durations_t;
+
+/*! \brief Statistics of a series of timed executions.
+ *
+ * Samples further than 1.5 IQR from the interquartile range
+ * (e.g. runs interrupted by the scheduler or a page fault storm)
+ * are rejected before any of the statistics is calculated.
+ */
+struct OTimeItStatistics {
+	int _samples;
+	int _rejected;
+	yaal::hcore::time::duration_t _total;
+	yaal::hcore::time::duration_t _min;
+	yaal::hcore::time::duration_t _median;
+	yaal::hcore::time::duration_t _p95;
+	yaal::hcore::time::duration_t _p99;
+	yaal::hcore::time::duration_t _max;
+	yaal::hcore::time::duration_t _mean;
+	yaal::hcore::time::duration_t _stddev;
+	OTimeItStatistics( durations_t const& );
+};
+
+/*! \brief Durations of the stages preceding timed execution.
+ */
+struct OTimeItPhases {
+	yaal::hcore::time::duration_t _init;
+	yaal::hcore::time::duration_t _load;
+	yaal::hcore::time::duration_t _preprocess;
+	yaal::hcore::time::duration_t _parse;
+	yaal::hcore::time::duration_t _compile;
+};
+
+bool timeit( yaal::tools::HHuginn&, yaal::hcore::time::duration_t&, int&, durations_t& );
 
 void report_timeit(
 	yaal::hcore::time::duration_t const&,
@@ -18,9 +59,16 @@ void report_timeit(
 	yaal::hcore::time::duration_t const&,
 	yaal::hcore::time::duration_t const&,
 	yaal::hcore::time::duration_t const&,
-	int
+	int,
+	durations_t const&,
+	yaal::hcore::time::duration_t const& = yaal::hcore::time::duration_t( 0 ),
+	CODE_CACHE = CODE_CACHE::NONE
 );
 
+void report_timeit_statistics( yaal::hcore::HStreamInterface&, OTimeItStatistics const&, int, TIMEIT_FORMAT, OTimeItPhases const* = nullptr );
+TIMEIT_FORMAT timeit_format( yaal::hcore::HString const& );
+char const* timeit_format_to_string( TIMEIT_FORMAT );
+
 }
 
 #endif /* #ifndef HUGINN_TIMEIT_HXX_INCLUDED */
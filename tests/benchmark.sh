@@ -0,0 +1,368 @@
+#! /usr/bin/env bash
+
+set -eEu
+
+startDir=$(pwd)
+huginnPath="${startDir}/build/${TARGET:-release}/huginn/1exec"
+tmpDir="/tmp/huginn-benchmark"
+
+trap '/bin/rm -rf ${tmpDir}' EXIT
+
+if [ ! -f "${huginnPath}" ] ; then
+	echo "Cannot find the benchmark subject."
+	exit 1
+fi
+
+rm -rf "${tmpDir}"
+mkdir -p "${tmpDir}"
+
+now_ns() {
+	date +%s%N
+}
+
+report() {
+	printf "%-40s %16s\n" "${@}"
+}
+
+bench_line_runner() {
+	for count in 250 500 1000 2000 4000 ; do
+		local session="${tmpDir}/session_${count}"
+		for ((i = 0; i < count; ++ i)) ; do
+			echo "v${i} = ${i} * 2;"
+			echo "//"
+		done > "${session}"
+		local start=$(now_ns)
+		"${huginnPath}" --jupyter --no-default-init --session-directory="${tmpDir}" --session="bench_${count}" < "${session}" > /dev/null
+		local end=$(now_ns)
+		report "lines: ${count}" "$(( ( end - start ) / count / 1000 ))us/line"
+	done
+}
+
+heap_allocations() {
+	valgrind --tool=memcheck --leak-check=no "${@}" 2>&1 > /dev/null | awk '/total heap usage:/ { gsub( ",", "", $5 ); print $5 }'
+}
+
+bench_line_runner_allocations() {
+	if ! command -v valgrind > /dev/null ; then
+		echo "valgrind not available, skipping"
+		return
+	fi
+	local lines=200
+	local session="${tmpDir}/session_allocations"
+	for ((i = 0; i < lines; ++ i)) ; do
+		echo "v${i} = ${i} * 2;"
+		echo "//"
+	done > "${session}"
+	local subjects=("${huginnPath}")
+	if [ -n "${BASELINE:-}" ] ; then
+		subjects+=("${BASELINE}")
+	fi
+	for subject in "${subjects[@]}" ; do
+		local base=$(heap_allocations "${subject}" --jupyter --no-default-init --session-directory="${tmpDir}" --session="bench_allocations_empty" < /dev/null)
+		local total=$(heap_allocations "${subject}" --jupyter --no-default-init --session-directory="${tmpDir}" --session="bench_allocations" < "${session}")
+		/bin/rm -f "${tmpDir}/bench_allocations"*
+		report "allocations ${subject#${startDir}/}" "$(( ( total - base ) / lines ))/line"
+	done
+}
+
+bench_line_runner_classes() {
+	local lines=500
+	for classes in 100 200 400 800 ; do
+		local session="${tmpDir}/session_classes_${classes}"
+		for ((i = 0; i < classes; ++ i)) ; do
+			echo "class C${i} { _v = ${i}; get() { _v; } }"
+			echo "//"
+		done > "${session}"
+		local start=$(now_ns)
+		"${huginnPath}" --jupyter --no-default-init --session-directory="${tmpDir}" --session="bench_classes_${classes}" < "${session}" > /dev/null
+		local mid=$(now_ns)
+		for ((i = 0; i < lines; ++ i)) ; do
+			echo "v${i} = C$(( i % classes ))().get();"
+			echo "//"
+		done >> "${session}"
+		/bin/rm -f "${tmpDir}/bench_classes_${classes}"*
+		"${huginnPath}" --jupyter --no-default-init --session-directory="${tmpDir}" --session="bench_classes_${classes}" < "${session}" > /dev/null
+		local end=$(now_ns)
+		report "classes: ${classes}" "$(( ( ( end - mid ) - ( mid - start ) ) / lines / 1000 ))us/line"
+	done
+}
+
+bench_oneliner() {
+	local runs=50
+	for program in "1+1" "reduce( map( range( 100 ), @( x ) { x * x; } ), add )" ; do
+		for cache in "--no-cache" "" ; do
+			local start=$(now_ns)
+			for ((i = 0; i < runs; ++ i)) ; do
+				"${huginnPath}" ${cache} --session-directory="${tmpDir}" -e "${program}" > /dev/null
+			done
+			local end=$(now_ns)
+			report "oneliner ${program:0:16} ${cache:---cache}" "$(( ( end - start ) / runs / 1000 ))us/run"
+		done
+	done
+}
+
+bench_stream_editor() {
+	local input="${tmpDir}/stream_editor_input"
+	local size="${STREAM_EDITOR_INPUT_SIZE:-1G}"
+	yes "The quick brown fox jumps over the lazy dog, 0123456789." | head -c "${size}" > "${input}"
+	local lines=$(wc -l < "${input}")
+	local subjects=("${huginnPath}")
+	if [ -n "${BASELINE:-}" ] ; then
+		subjects+=("${BASELINE}")
+	fi
+	for subject in "${subjects[@]}" ; do
+		local start=$(now_ns)
+		"${subject}" -p -l -e '_.replace( "fox", "cat" )' < "${input}" > /dev/null
+		local end=$(now_ns)
+		report "stream editor ${subject#${startDir}/}" "$(( lines * 1000000000 / ( end - start ) )) lines/s"
+	done
+	local start=$(now_ns)
+	awk '{ gsub( "fox", "cat" ); print }' < "${input}" > /dev/null
+	local end=$(now_ns)
+	report "stream editor awk" "$(( lines * 1000000000 / ( end - start ) )) lines/s"
+	/bin/rm -f "${input}"
+}
+
+bench_in_place_jobs() {
+	local dir="${tmpDir}/in_place"
+	mkdir -p "${dir}"
+	for ((i = 0; i < 2000; ++ i)) ; do
+		yes "key${i} = value" | head -n 200 > "${dir}/file${i}.conf"
+	done
+	for jobs in 1 2 4 $(nproc) ; do
+		local start=$(now_ns)
+		"${huginnPath}" --jobs="${jobs}" -i -p -l -e '_.replace( "value", "other" )' "${dir}"/*.conf
+		local end=$(now_ns)
+		report "in-place jobs: ${jobs}" "$(( ( end - start ) / 1000000 ))ms"
+	done
+	/bin/rm -rf "${dir}"
+}
+
+bench_shell_startup() {
+	local home="${tmpDir}/home"
+	mkdir -p "${home}"
+	local runs=20
+	for state in "cold" "warm" ; do
+		local start=$(now_ns)
+		for ((i = 0; i < runs; ++ i)) ; do
+			if [ "${state}" = "cold" ] ; then
+				/bin/rm -rf "${home}/.cache"
+			fi
+			HOME="${home}" "${huginnPath}" -s -c "true"
+		done
+		local end=$(now_ns)
+		report "shell startup, ${state} command index" "$(( ( end - start ) / runs / 1000 ))us/run"
+	done
+	/bin/rm -rf "${home}"
+}
+
+bench_capture() {
+	local input="${tmpDir}/capture_input"
+	for size in 10M 100M 1G ; do
+		yes "0123456789abcdefghijklmnopqrstuvwxyz" | head -c "${size}" > "${input}"
+		local start=$(now_ns)
+		echo 'setenv CAPTURED "$(cat '"${input}"')"' | "${huginnPath}" -s > /dev/null
+		local end=$(now_ns)
+		report "capture ${size}" "$(( ( end - start ) / 1000000 ))ms"
+	done
+	/bin/rm -f "${input}"
+}
+
+bench_profile() {
+	local script="${tmpDir}/profile.hgn"
+	cat > "${script}" << EOF
+fib( n ) {
+	return ( n < 2 ? n : fib( n - 1 ) + fib( n - 2 ) );
+}
+main() {
+	return ( fib( 24 ) % 2 );
+}
+EOF
+	local runs=5
+	for profile in "" "--profile=${tmpDir}/profile.folded" ; do
+		local start=$(now_ns)
+		for ((i = 0; i < runs; ++ i)) ; do
+			"${huginnPath}" ${profile} "${script}" > /dev/null 2>&1 || true
+		done
+		local end=$(now_ns)
+		report "fib(24) ${profile:+profiled}" "$(( ( end - start ) / runs / 1000 ))us/run"
+	done
+}
+
+bench_script_load() {
+	local script="${tmpDir}/data.hgn"
+	echo "main() {" > "${script}"
+	for ((i = 0; i < 20; ++ i)) ; do
+		echo "	d${i} = [$(seq -s ", " 1 10000)];"
+	done >> "${script}"
+	echo "}" >> "${script}"
+	local runs=5
+	for mode in "--lint" "--tags" ; do
+		local start=$(now_ns)
+		for ((i = 0; i < runs; ++ i)) ; do
+			"${huginnPath}" ${mode} "${script}" > /dev/null
+		done
+		local end=$(now_ns)
+		report "load $(( $(stat -c %s "${script}") / 1024 ))KiB ${mode}" "$(( ( end - start ) / runs / 1000 ))us/run"
+	done
+}
+
+bench_batch() {
+	local tree="${tmpDir}/tree"
+	for ((d = 0; d < 10; ++ d)) ; do
+		mkdir -p "${tree}/d${d}"
+		for ((f = 0; f < 30; ++ f)) ; do
+			cat > "${tree}/d${d}/f${f}.hgn" << EOF
+class C${f} {
+	_x = ${f};
+	get( y ) { return ( _x + y ); }
+}
+f${f}( n ) {
+	s = 0;
+	for ( i : range( n ) ) {
+		s += C${f}().get( i );
+	}
+	return ( s );
+}
+main() {
+	return ( f${f}( ${d} ) );
+}
+EOF
+		done
+	done
+	local files=$(find "${tree}" -name '*.hgn' | wc -l)
+	for mode in "--lint" "--tags" "--reformat" ; do
+		local start=$(now_ns)
+		find "${tree}" -name '*.hgn' | sort | while read file ; do
+			"${huginnPath}" ${mode} "${file}" > /dev/null
+		done
+		local end=$(now_ns)
+		report "${mode} ${files} files, per process" "$(( ( end - start ) / files / 1000 ))us/file"
+		for jobs in 1 4 ; do
+			start=$(now_ns)
+			"${huginnPath}" ${mode} -j ${jobs} "${tree}" > /dev/null
+			end=$(now_ns)
+			report "${mode} ${files} files, -j ${jobs}" "$(( ( end - start ) / files / 1000 ))us/file"
+		done
+	done
+}
+
+bench_startup() {
+	local runs=20
+	for rapid in "" "--rapid-start" ; do
+		local start=$(now_ns)
+		for ((i = 0; i < runs; ++ i)) ; do
+			"${huginnPath}" ${rapid} --no-cache --session-directory="${tmpDir}" -e "1" > /dev/null
+		done
+		local end=$(now_ns)
+		report "startup -e ${rapid}" "$(( ( end - start ) / runs / 1000 ))us/run"
+		start=$(now_ns)
+		for ((i = 0; i < runs; ++ i)) ; do
+			printf 'import Mathematics as M;\nclass A { _x = 0; }\nf() { 1; }\nf();\n//\n' | "${huginnPath}" ${rapid} --jupyter --no-default-init --session-directory="${tmpDir}" --session="startup" > /dev/null
+		done
+		end=$(now_ns)
+		report "startup interactive ${rapid}" "$(( ( end - start ) / runs / 1000 ))us/run"
+	done
+}
+
+bench_glob() {
+	local tree="${tmpDir}/glob"
+	for ((d = 0; d < 100; ++ d)) ; do
+		mkdir -p "${tree}/d${d}/sub"
+		(cd "${tree}/d${d}" && seq -f "f%g.c" 0 899 | xargs touch && seq -f "sub/g%g.h" 0 99 | xargs touch)
+	done
+	local files=$(find "${tree}" -type f | wc -l)
+	local runs=5
+	for globs in "*/*.c" "**/*.h" "*/*.c */*.c */f1*.c */sub/*" "**" ; do
+		local start=$(now_ns)
+		for ((i = 0; i < runs; ++ i)) ; do
+			(cd "${tree}" && "${huginnPath}" -s -c "true ${globs}")
+		done
+		local end=$(now_ns)
+		report "glob '${globs}', ${files} files" "$(( ( end - start ) / runs / 1000 ))us/run"
+	done
+	/bin/rm -rf "${tree}"
+}
+
+bench_forwarding_shell() {
+	local script="${tmpDir}/forwarding.sh"
+	local lines=10000
+	for ((i = 0; i < lines; ++ i)) ; do
+		echo "v${i}=${i}"
+	done > "${script}"
+	for mode in "" "--persistent-shell" ; do
+		local start=$(now_ns)
+		"${huginnPath}" --shell=/bin/sh ${mode} "${script}" > /dev/null
+		local end=$(now_ns)
+		report "forwarding shell ${mode:-per-command}" "$(( ( end - start ) / lines / 1000 ))us/line"
+	done
+	/bin/rm -f "${script}"
+}
+
+bench_source() {
+	local rc="${tmpDir}/rc.sh"
+	local driver="${tmpDir}/driver.sh"
+	local lines=5000
+	for ((i = 0; i < lines; ++ i)) ; do
+		echo "alias a${i} 'echo \"${i}\" | cat' # alias ${i}"
+	done > "${rc}"
+	for runs in 1 10 ; do
+		for ((i = 0; i < runs; ++ i)) ; do
+			echo "source ${rc}"
+		done > "${driver}"
+		local start=$(now_ns)
+		HOME="${tmpDir}" "${huginnPath}" -s "${driver}" > /dev/null
+		local end=$(now_ns)
+		report "source ${lines} lines x ${runs}" "$(( ( end - start ) / ( runs * lines ) ))ns/line"
+	done
+	/bin/rm -f "${rc}" "${driver}"
+}
+
+bench_fast_builtins() {
+	local script="${tmpDir}/tests.sh"
+	local checks=100000
+	touch "${tmpDir}/x"
+	for mode in off on ; do
+		echo "setopt fast_builtins ${mode}" > "${script}"
+		for ((i = 0; i < checks; ++ i)) ; do
+			echo "[ -f ${tmpDir}/x ]"
+		done >> "${script}"
+		local start=$(now_ns)
+		HOME="${tmpDir}" "${huginnPath}" -s "${script}" > /dev/null
+		local end=$(now_ns)
+		report "${checks} x [ -f x ] fast_builtins ${mode}" "$(( ( end - start ) / checks ))ns/check"
+	done
+	/bin/rm -f "${script}" "${tmpDir}/x"
+}
+
+bench_spawn() {
+	local script="${tmpDir}/tests.sh"
+	local stages=1000
+	for size in 0 1000000 4000000 ; do
+		local elapsed=()
+		for lines in 0 ${stages} ; do
+			echo "import Algorithms as algo;" > "${script}"
+			echo "big = algo.materialize( algo.range( ${size} ), list );" >> "${script}"
+			for ((i = 0; i < lines; ++ i)) ; do
+				echo "true | true"
+			done >> "${script}"
+			local start=$(now_ns)
+			HOME="${tmpDir}" "${huginnPath}" -s "${script}" > /dev/null
+			local end=$(now_ns)
+			elapsed+=( $(( end - start )) )
+		done
+		report "spawn with ${size} element session" "$(( ( elapsed[1] - elapsed[0] ) / ( 2 * stages ) ))ns/stage"
+	done
+	/bin/rm -f "${script}"
+}
+
+run_benchmarks() {
+	pattern="${1}"
+	for functionName in $(declare -F | awk '{print $3}' | grep "^bench_" | grep "${pattern}") ; do
+		echo "${functionName}"
+		${functionName}
+	done
+}
+
+run_benchmarks "${1:-.}"
+
@@ -59,6 +59,21 @@ test_glob() {
 	assert_equals "glob 1" "$(try echo '\*')" "*"
 }
 
+test_pathname_expansion() {
+	mkdir -p g/a/b g/.h/x g/c
+	touch g/f.txt g/a/f.txt g/a/b/f.txt g/.h/x/f.txt g/.e.txt g/c/.d.txt g/\[x\] g/ab1 g/ab2 g/abz
+	assert_equals "glob recursive" "$(try 'echo g/**/*.txt')" "g/a/b/f.txt g/a/f.txt g/f.txt"
+	assert_equals "glob recursive trailing" "$(try 'echo g/a/**')" "g/a/b g/a/b/f.txt g/a/f.txt"
+	assert_equals "glob hidden" "$(try 'echo g/*')" "g/[x] g/a g/ab1 g/ab2 g/abz g/c g/f.txt"
+	assert_equals "glob hidden explicit" "$(try 'echo g/.*')" "g/.e.txt g/.h"
+	assert_equals "glob hidden per component" "$(try 'echo g/*/.* g/.h/*/*.txt g/*/*.txt')" "g/c/.d.txt g/.h/x/f.txt g/a/f.txt"
+	assert_equals "glob bracket" "$(try 'echo g/ab[12] g/ab[!12] g/ab[0-9]')" "g/ab1 g/ab2 g/abz g/ab1 g/ab2"
+	assert_equals "glob bracket literal" "$(try 'echo g/[[]x] g/\[x\]')" "g/[x] g/[x]"
+	assert_equals "glob bracket unterminated" "$(try 'echo g/ab[1 g/ab\*')" "g/ab[1 g/ab*"
+	assert_equals "glob trailing slash" "$(try 'echo g/*/ g/a*/')" "g/a/ g/c/ g/a/"
+	assert_equals "glob after command substitution" "$(try 'echo g/*.txt $(touch g/new.txt)g/*.txt')" "g/f.txt g/f.txt g/new.txt"
+}
+
 test_script() {
 	script=$(make_script)
 	assert_equals "no params" "$(${script})" '[0]:"params"'
@@ -199,6 +214,142 @@ test_builtin_setopt() {
 		"Test prefix_commands" \
 		"$(try 'alias P pwd;setopt prefix_commands env;env P')" \
 		"/tmp/huginn-tests"
+	assert_equals \
+		"Test capture_max_size" \
+		"$(try 'setopt capture_max_size 1024;setopt --print capture_max_size')" \
+		"1024"
+	assert_equals \
+		"Test capture within capture_max_size" \
+		"$(try 'setopt capture_max_size 8;echo $(echo abcdefg)')" \
+		"abcdefg"
+	assert_equals \
+		"Test capture over capture_max_size aborts producer" \
+		"$(try 'setopt capture_max_size 100;echo $(yes)' | grep -o 'Captured output exceeds.*bytes!')" \
+		"Captured output exceeds capture_max_size limit of 100 bytes!"
+	assert_equals \
+		"Test file_info_ttl" \
+		"$(try 'setopt file_info_ttl 500;setopt --print file_info_ttl')" \
+		"500 (hits: 0, misses: 0, hit rate: 0%, entries: 0)"
+}
+
+test_fast_builtins() {
+	touch "${tmpDir}/fb"
+	assert_equals "Fast echo" "$(try 'setopt fast_builtins on;echo -n a b;echo c')" "a bc"
+	assert_equals "Fast test" "$(try "setopt fast_builtins on;[ -f ${tmpDir}/fb ] && test ! -d ${tmpDir}/fb -a 3 -gt 2 && echo ok")" "ok"
+	assert_equals "Fast test failure" "$(try 'setopt fast_builtins on;[ a = b ] || echo ok')" "*standard input*:1: Exit 1 ok"
+	assert_equals "Fast test syntax" "$(try 'setopt fast_builtins on;[ a = b')" "*standard input*:1: [: missing \`]\` Exit 2"
+	assert_equals "Fast false" "$(try 'setopt fast_builtins on;false && echo fail')" "*standard input*:1: Exit 1"
+	assert_equals "Fast basename" "$(try 'setopt fast_builtins on;basename /a/b.txt/ .txt;basename /')" "b /"
+	assert_equals "Fast dirname" "$(try 'setopt fast_builtins on;dirname /a/b/;dirname a;dirname //a')" "/a . /"
+	assert_equals "Fast printf" "$(try "setopt fast_builtins on;printf '[%-3s|%03d|%x]' a 7 255 b 8")" "[a  |007|ff][b  |008|0]"
+	assert_equals "Fast printf bytes" "$(try "setopt fast_builtins on;printf '\\351\\xe9\\377' | od -An -tx1 | tr -d ' '")" "e9e9ff"
+	assert_equals "Fast echo bytes" "$(try "setopt fast_builtins on;echo -e 'a\\0351\\xff' | od -An -tx1 | tr -d ' '")" "61e9ff0a"
+	assert_equals "Fast printf %b" "$(try "setopt fast_builtins on;printf '%b|%s' 'x\\0101\\ty' 'z\\n'")" "xA	y|z\\n"
+	assert_equals "Fast printf %b stop" "$(try "setopt fast_builtins on;printf 'ab%bcd' 'ef\\cgh' x;echo END")" "abefEND"
+	assert_equals "Fast echo stop" "$(try "setopt fast_builtins on;echo -e 'a\\cb';echo END")" "aEND"
+}
+
+test_command_index() {
+	local bin="${tmpDir}/index/bin"
+	mkdir -p "${bin}" "${tmpDir}/index/home"
+	export HOME="${tmpDir}/index/home"
+	export PATH="${bin}:${PATH}"
+	assert_equals "Build command index" "$(try 'true')" ""
+	printf '#! /bin/sh\necho fresh\n' > "${bin}/freshcmd"
+	chmod +x "${bin}/freshcmd"
+	assert_equals "New command found after restart" "$(try 'freshcmd')" "fresh"
+}
+
+test_forwarding_shell_script() {
+	script="${tmpDir}/forwarding.sh"
+	cat > "${script}" <<'SCRIPT'
+greet() {
+	echo "hello ${1}"
+}
+for i in 1 2 ; do
+	if [ "${i}" -eq 2 ] ; then
+		greet "${i}"
+	fi
+done
+cat <<END
+here doc
+END
+exit 3
+echo unreachable
+SCRIPT
+	for mode in "" "--persistent-shell" ; do
+		assert_equals \
+			"Run multi-line script in forwarding shell ${mode}" \
+			"$(${huginnPath} --no-default-init --quiet --shell=/bin/sh ${mode} "${script}" ; echo "Exit ${?}")" \
+			"hello 2 here doc Exit 3"
+	done
+}
+
+test_batch() {
+	local dir="${tmpDir}/batch"
+	mkdir -p "${dir}/tree"
+	echo 'zz() { return ( 2 ); } main() { return ( zz() ); }' > "${dir}/zz.hgn"
+	echo 'aa() { return ( 1 ); } main() { return ( aa() ); }' > "${dir}/aa.hgn"
+	echo 'main() { return ( 0 ' > "${dir}/parse.hgn"
+	echo 'main() { x = 0; }' > "${dir}/compile.hgn"
+	echo 'main() { repl(); }' > "${dir}/repl.hgn"
+	cp "${dir}/zz.hgn" "${dir}/aa.hgn" "${dir}/tree/"
+	assert_equals \
+		"Lint script with arguments" \
+		"$(${huginnPath} --lint "${dir}/zz.hgn" "${dir}/parse.hgn" "${dir}/compile.hgn" 2>&1 ; echo "Exit ${?}")" \
+		"Exit 0"
+	assert_equals \
+		"Lint many files" \
+		"$(${huginnPath} --no-color --lint --batch "${dir}/zz.hgn" "${dir}/parse.hgn" "${dir}/aa.hgn" "${dir}/compile.hgn" 2>&1 | sed -e "s@^${dir}/@@" -e 's/:.*//')" \
+		"parse.hgn compile.hgn"
+	assert_equals \
+		"Lint many files status" \
+		"$(${huginnPath} --lint --batch "${dir}/zz.hgn" "${dir}/parse.hgn" "${dir}/aa.hgn" "${dir}/compile.hgn" > /dev/null 2>&1 ; echo "Exit ${?}")" \
+		"Exit 2"
+	assert_equals \
+		"Lint many files sloppy" \
+		"$(${huginnPath} --be-sloppy --lint --batch "${dir}/compile.hgn" "${dir}/repl.hgn" 2>&1 ; echo "Exit ${?}")" \
+		"Exit 0"
+	assert_equals \
+		"Lint directory" \
+		"$(${huginnPath} --lint "${dir}/tree" 2>&1 ; echo "Exit ${?}")" \
+		"Exit 0"
+	assert_equals \
+		"Reformat many files order" \
+		"$(${huginnPath} --reformat --batch -j 2 "${dir}/zz.hgn" "${dir}/aa.hgn" | grep -o 'return ( [0-9] )' ; echo "Exit ${PIPESTATUS[0]}")" \
+		"return ( 2 ) return ( 1 ) Exit 0"
+	assert_equals \
+		"Reformat directory order" \
+		"$(${huginnPath} --reformat "${dir}/tree" | grep -o 'return ( [0-9] )')" \
+		"return ( 1 ) return ( 2 )"
+	assert_equals \
+		"Reformat many files headers" \
+		"$(${huginnPath} --reformat --batch "${dir}/zz.hgn" "${dir}/parse.hgn" "${dir}/aa.hgn" 2> /dev/null | grep '^==>' | sed -e "s@${dir}/@@")" \
+		"==> zz.hgn <== ==> aa.hgn <=="
+	assert_equals \
+		"Tags many files" \
+		"$(${huginnPath} --tags --batch "${dir}/zz.hgn" "${dir}/aa.hgn" | cut -f1 | grep -v '^!' ; echo "Exit ${PIPESTATUS[0]}")" \
+		"aa main main zz Exit 0"
+}
+
+test_jupyter_framed() {
+	local kernel="${huginnPath} --jupyter --framed --no-default-init --session-directory=${tmpDir} --session=framed"
+	local print='print( "hello\n" );'
+	local reset='//reset'
+	assert_equals \
+		"Framed session requests" \
+		"$( {
+			printf 'complete 1 6\n%s' '\alpha'
+			printf 'execute 2 %d\n%s' ${#print} "${print}"
+			printf 'execute 3 5\n%s' '1 + 2'
+			printf 'meta 4 %d\n%s' ${#reset} "${reset}"
+			printf 'meta 5 5\n%s' 'x = 1'
+		} | ${kernel} )" \
+		"completions 1 2 αoutput 2 6 hello result 2 0 result 3 1 3result 4 0 error 5 25 Not a meta command: x = 1"
+	assert_equals \
+		"Framed session malformed header" \
+		"$(printf 'ping 6 0\nbogus\nexecute 7 5\n1 + 2' | ${kernel} ; echo " Exit ${?}")" \
+		"error 6 26 Unknown request type: pingerror 0 29 Malformed frame header: bogus Exit 0"
 }
 
 test_builtin_source() {
@@ -307,6 +458,10 @@ test_jobs_background() {
 		"Run job in background and bring it to foreground" \
 		"$(try 'sleep 1.4&jobs;sleep .5;fg; jobs')" \
 		"sleep 1.4 [1] Running   sleep 1.4"
+	assert_equals \
+		"Report background job completion only once" \
+		"$(try 'sleep .2&sleep .6;jobs;sleep .1;jobs')" \
+		"[1] Done sleep .2"
 	assert_equals \
 		"Try to run a background job in command substitution" \
 		"$(try 'echo $(sleep 1.4&)')" \
@@ -388,6 +543,13 @@ test_pipe_system_to_huginn() {
 		'120 720 5040'
 }
 
+test_pipe_huginn_to_huginn() {
+	assert_equals \
+		"Run pipe from huginn to huginn" \
+		"$(try 'print( "5\134n6\134n" )\; | while ( ( l = input() ) != none ) { print( "{}\134n".format(number(l)!) )\; }')" \
+		'120 720'
+}
+
 test_command_substitution_from_huginn() {
 	assert_equals \
 		"Substitute from Huginn" \